@@ -9,8 +9,10 @@
 #include "Exceptions.h"
 #include "List.h" // Tipo devuelto por los recorridos
 #include "Queue.h" // Tipo auxiliar para implementar el recorrido por niveles
+#include "Stack.h" // Tipo auxiliar para los recorridos iterativos
 #include <iomanip>   // setw
 #include <iostream>  // endl 
+#include <utility>   // pair
 
 /**
  * Implementación dinámica del TAD Arbin utilizando
@@ -28,6 +30,10 @@
  * - Cons: Arbin, Elem, Arbin -> Arbin. Generadora implementada en un constructor con tres parámetros.
  * - hijoIz, hijoDr: Arbin - -> Arbin. Observadoras que devuelven el hijo izquiero o derecho de un árbol.
  * - esVacio: Arbin -> Bool. Observadora que devuelve si un árbol binario es vacío.
+ *
+ * Los recorridos, las observadoras y la liberación de los nodos son
+ * iterativos (usan una pila explícita), así que no desbordan la pila de
+ * llamadas aunque el árbol sea degenerado (una lista de millones de nodos).
  */
 
 template <typename T>
@@ -281,28 +287,62 @@ protected:
 	// MÉTODOS AUXILIARES PARA LOS RECORRIDOS
 	// //
 	
+	/** Preorden: se apila primero el hijo derecho para sacar antes el izquierdo. */
 	static void preordenAcu(Nodo *ra, List<T> &acu) {
-		if (ra != nullptr){
-            acu.push_back(ra->elem);
-            preordenAcu(ra->iz, acu);
-            preordenAcu(ra->dr, acu);
-        }
+		Stack<Nodo*> pendientes;
+		if (ra != nullptr)
+			pendientes.push(ra);
+		while (!pendientes.empty()) {
+			Nodo *p = pendientes.top();
+			pendientes.pop();
+			acu.push_back(p->elem);
+			if (p->dr != nullptr)
+				pendientes.push(p->dr);
+			if (p->iz != nullptr)
+				pendientes.push(p->iz);
+		}
 	}
 
+	/** Inorden: se baja por la izquierda apilando los nodos aún por visitar. */
 	static void inordenAcu(Nodo *ra, List<T> &acu) {
-        if (ra != nullptr) {
-            inordenAcu(ra->iz, acu);
-            acu.push_back(ra->elem);
-            inordenAcu(ra->dr, acu);
-        }
+		Stack<Nodo*> pendientes;
+		Nodo *p = ra;
+		while (p != nullptr || !pendientes.empty()) {
+			while (p != nullptr) {
+				pendientes.push(p);
+				p = p->iz;
+			}
+			p = pendientes.top();
+			pendientes.pop();
+			acu.push_back(p->elem);
+			p = p->dr;
+		}
 	}
 
+	/**
+	 * Postorden: cada nodo se apila dos veces, la primera para apilar detrás
+	 * a sus hijos y la segunda (marcada con true) para visitarlo. No se puede
+	 * comparar con el último nodo visitado porque los dos hijos pueden ser el
+	 * mismo nodo compartido.
+	 */
 	static void postordenAcu(Nodo *ra, List<T> &acu) {
-        if (ra != nullptr) {
-            postordenAcu(ra->iz, acu);
-            postordenAcu(ra->dr, acu);
-            acu.push_back(ra->elem);
-        }
+		Stack<std::pair<Nodo*, bool>> pendientes;
+		if (ra != nullptr)
+			pendientes.push(std::make_pair(ra, false));
+		while (!pendientes.empty()) {
+			std::pair<Nodo*, bool> cima = pendientes.top();
+			pendientes.pop();
+			Nodo *p = cima.first;
+			if (cima.second)
+				acu.push_back(p->elem);
+			else {
+				pendientes.push(std::make_pair(p, true));
+				if (p->dr != nullptr)
+					pendientes.push(std::make_pair(p->dr, false));
+				if (p->iz != nullptr)
+					pendientes.push(std::make_pair(p->iz, false));
+			}
+		}
 	}
 
     static void graph_rec(std::ostream & out, int indent, Nodo* raiz){
@@ -314,35 +354,63 @@ protected:
     }
 
 	// //
-	// MÉTODOS AUXILIARES (RECURSIVOS) DE OTRAS OPERACIONES
+	// MÉTODOS AUXILIARES (ITERATIVOS) DE OTRAS OPERACIONES
 	// OBSERVADORAS
 	// //
 
 	static unsigned int numNodosAux(Nodo *ra) {
-		if (ra == nullptr)
-			return 0;
-		return 1 + numNodosAux(ra->iz) + numNodosAux(ra->dr);
+		unsigned int num = 0;
+		Stack<Nodo*> pendientes;
+		if (ra != nullptr)
+			pendientes.push(ra);
+		while (!pendientes.empty()) {
+			Nodo *p = pendientes.top();
+			pendientes.pop();
+			++num;
+			if (p->iz != nullptr)
+				pendientes.push(p->iz);
+			if (p->dr != nullptr)
+				pendientes.push(p->dr);
+		}
+		return num;
 	}
 
+	/** Se apila cada nodo junto con su profundidad (la raíz está a profundidad 1). */
 	static unsigned int tallaAux(Nodo *ra) {
-		if (ra == nullptr)
-			return 0;
-		int tallaiz = tallaAux(ra->iz);
-		int talladr = tallaAux(ra->dr);
-		if (tallaiz > talladr)
-			return 1 + tallaiz;
-		else
-			return 1 + talladr;
+		unsigned int talla = 0;
+		Stack<std::pair<Nodo*, unsigned int>> pendientes;
+		if (ra != nullptr)
+			pendientes.push(std::make_pair(ra, 1u));
+		while (!pendientes.empty()) {
+			Nodo *p = pendientes.top().first;
+			unsigned int prof = pendientes.top().second;
+			pendientes.pop();
+			if (prof > talla)
+				talla = prof;
+			if (p->iz != nullptr)
+				pendientes.push(std::make_pair(p->iz, prof + 1));
+			if (p->dr != nullptr)
+				pendientes.push(std::make_pair(p->dr, prof + 1));
+		}
+		return talla;
 	}
 
 	static unsigned int numHojasAux(Nodo *ra) {
-		if (ra == nullptr)
-			return 0;
-
-		if ((ra->iz == NULL) && (ra->dr == NULL))
-			return 1;
-
-		return numHojasAux(ra->iz) + numHojasAux(ra->dr);
+		unsigned int num = 0;
+		Stack<Nodo*> pendientes;
+		if (ra != nullptr)
+			pendientes.push(ra);
+		while (!pendientes.empty()) {
+			Nodo *p = pendientes.top();
+			pendientes.pop();
+			if ((p->iz == NULL) && (p->dr == NULL))
+				++num;
+			if (p->iz != nullptr)
+				pendientes.push(p->iz);
+			if (p->dr != nullptr)
+				pendientes.push(p->dr);
+		}
+		return num;
 	}
 
 private:
@@ -350,15 +418,31 @@ private:
 	/**
 	 * Elimina todos los nodos de una estructura arbórea que comienza con el puntero ra.
 	 * Se admite que el nodo sea nullptr
+	 * Sólo se borran los nodos que se quedan sin referencias; los que se
+	 * borran se apilan para quitar después la referencia a sus hijos.
 	 */
 	static void libera(Nodo *ra) {
-		if (ra != nullptr) {
-			ra->remRef();
-			if (ra->numRefs == 0) {
-				libera(ra->iz);
-				libera(ra->dr);
-				delete ra;
+		if (ra == nullptr)
+			return;
+		ra->remRef();
+		if (ra->numRefs > 0)
+			return; // la estructura sigue compartida
+		Stack<Nodo*> porBorrar;
+		porBorrar.push(ra);
+		while (!porBorrar.empty()) {
+			Nodo *p = porBorrar.top();
+			porBorrar.pop();
+			if (p->iz != nullptr) {
+				p->iz->remRef();
+				if (p->iz->numRefs == 0)
+					porBorrar.push(p->iz);
+			}
+			if (p->dr != nullptr) {
+				p->dr->remRef();
+				if (p->dr->numRefs == 0)
+					porBorrar.push(p->dr);
 			}
+			delete p;
 		}
 	}
 
@@ -366,17 +450,25 @@ private:
 	 * Compara dos estructuras jerárquicas de nodos, dadas sus raices.
 	 */
 	static bool comparaAux(Nodo *r1, Nodo *r2) {
-		if (r1 == r2)
-			return true;
-		else if ((r1 == nullptr) || (r2 == nullptr))
-			// En el if anterior nos aseguramos de que r1 != r2. Si uno es NULL, el
-			// otro entonces no lo será, luego son distintos.
-			return false;
-		else {
-			return (r1->elem == r2->elem) &&
-                   comparaAux(r1->iz, r2->iz) &&
-                   comparaAux(r1->dr, r2->dr);
+		// Parejas de subárboles (uno de cada árbol) que quedan por comparar
+		Stack<std::pair<Nodo*, Nodo*>> pendientes;
+		pendientes.push(std::make_pair(r1, r2));
+		while (!pendientes.empty()) {
+			Nodo *p1 = pendientes.top().first;
+			Nodo *p2 = pendientes.top().second;
+			pendientes.pop();
+			if (p1 == p2)
+				continue; // el mismo subárbol (o los dos vacíos)
+			else if ((p1 == nullptr) || (p2 == nullptr))
+				// En el if anterior nos aseguramos de que p1 != p2. Si uno es NULL, el
+				// otro entonces no lo será, luego son distintos.
+				return false;
+			else if (!(p1->elem == p2->elem))
+				return false;
+			pendientes.push(std::make_pair(p1->dr, p2->dr));
+			pendientes.push(std::make_pair(p1->iz, p2->iz));
 		}
+		return true;
 	}
 
 protected:
@@ -9,9 +9,12 @@
 #include "Exceptions.h"
 #include "List.h" // Tipo devuelto por los recorridos
 #include "Queue.h" // Tipo auxiliar para implementar el recorrido por niveles
+#include "Stack.h" // Tipo auxiliar para los recorridos iterativos
 #include <iomanip>   // setw
 #include <iostream>  // endl
 #include <memory> //shared_ptr
+#include <utility>   // pair
+#include <vector>
 
 /**
  * Implementación dinámica del TAD Arbin utilizando
@@ -28,6 +31,10 @@
  * - Cons: Arbin, Elem, Arbin -> Arbin. Generadora implementada en un constructor con tres parámetros.
  * - hijoIz, hijoDr: Arbin - -> Arbin. Observadoras que devuelven el hijo izquiero o derecho de un árbol.
  * - esVacio: Arbin -> Bool. Observadora que devuelve si un árbol binario es vacío.
+ *
+ * Los recorridos, las observadoras y la destrucción de los nodos son
+ * iterativos (usan una pila explícita), así que no desbordan la pila de
+ * llamadas aunque el árbol sea degenerado (una lista de millones de nodos).
  */
 
 template <typename T>
@@ -206,6 +213,7 @@ protected:
 	/**
 	 * Clase nodo que almacena internamente el elemento (de tipo T),
 	 * y punteros inteligentes al hijo izquierdo y al hijo derecho
+	 * El destructor es iterativo (ver ~Nodo).
 	 */
     class Nodo; // Declaración adelantada para poder definir Link
     using Link = std::shared_ptr<Nodo>; // Alias de tipo
@@ -214,10 +222,45 @@ protected:
 	public:
 		Nodo() : iz(nullptr), dr(nullptr) {}
 		Nodo(Link iz, const T &elem, Link dr) : elem(elem), iz(iz), dr(dr) {}
+		Nodo(const Nodo &) = default;
+
+		/**
+		 * Si un hijo sólo lo apunta este nodo, al destruir el puntero se
+		 * destruiría el hijo, y éste a su vez a sus hijos, con una llamada
+		 * anidada por nivel que desborda la pila en árboles degenerados. Por eso
+		 * esos hijos se sacan antes a un vector y se destruyen de uno en uno,
+		 * sacando a su vez sus hijos; así cada nodo se destruye sin hijos que
+		 * destruir en cadena.
+		 */
+		~Nodo() {
+			if (!esUnico(iz) && !esUnico(dr))
+				return;
+			std::vector<Link> porBorrar;
+			suelta(iz, porBorrar);
+			suelta(dr, porBorrar);
+			while (!porBorrar.empty()) {
+				Link p = std::move(porBorrar.back());
+				porBorrar.pop_back();
+				suelta(p->iz, porBorrar);
+				suelta(p->dr, porBorrar);
+			} // aquí se destruye p, ya sin hijos propios
+		}
 
 		T elem;
 		Link iz;
 		Link dr;
+
+	private:
+		/** Indica si el nodo sólo lo apunta l (y al soltarlo se destruiría). */
+		static bool esUnico(const Link &l) {
+			return l != nullptr && l.use_count() == 1;
+		}
+
+		/** Si sólo lo apunta l, mueve el nodo al vector porBorrar. */
+		static void suelta(Link &l, std::vector<Link> &porBorrar) {
+			if (esUnico(l))
+				porBorrar.push_back(std::move(l));
+		}
 	};
 
 	/**
@@ -230,28 +273,62 @@ protected:
 	// MÉTODOS AUXILIARES PARA LOS RECORRIDOS
 	// //
 	
+	/** Preorden: se apila primero el hijo derecho para sacar antes el izquierdo. */
 	static void preordenAcu(Link ra, List<T> &acu) {
-		if (ra != nullptr){
-            acu.push_back(ra->elem);
-            preordenAcu(ra->iz, acu);
-            preordenAcu(ra->dr, acu);
-        }
+		Stack<Nodo*> pendientes;
+		if (ra != nullptr)
+			pendientes.push(ra.get());
+		while (!pendientes.empty()) {
+			Nodo *p = pendientes.top();
+			pendientes.pop();
+			acu.push_back(p->elem);
+			if (p->dr != nullptr)
+				pendientes.push(p->dr.get());
+			if (p->iz != nullptr)
+				pendientes.push(p->iz.get());
+		}
 	}
 
+	/** Inorden: se baja por la izquierda apilando los nodos aún por visitar. */
 	static void inordenAcu(Link ra, List<T> &acu) {
-        if (ra != nullptr) {
-            inordenAcu(ra->iz, acu);
-            acu.push_back(ra->elem);
-            inordenAcu(ra->dr, acu);
-        }
+		Stack<Nodo*> pendientes;
+		Nodo *p = ra.get();
+		while (p != nullptr || !pendientes.empty()) {
+			while (p != nullptr) {
+				pendientes.push(p);
+				p = p->iz.get();
+			}
+			p = pendientes.top();
+			pendientes.pop();
+			acu.push_back(p->elem);
+			p = p->dr.get();
+		}
 	}
 
+	/**
+	 * Postorden: cada nodo se apila dos veces, la primera para apilar detrás
+	 * a sus hijos y la segunda (marcada con true) para visitarlo. No se puede
+	 * comparar con el último nodo visitado porque los dos hijos pueden ser el
+	 * mismo nodo compartido.
+	 */
 	static void postordenAcu(Link ra, List<T> &acu) {
-        if (ra != nullptr) {
-            postordenAcu(ra->iz, acu);
-            postordenAcu(ra->dr, acu);
-            acu.push_back(ra->elem);
-        }
+		Stack<std::pair<Nodo*, bool>> pendientes;
+		if (ra != nullptr)
+			pendientes.push(std::make_pair(ra.get(), false));
+		while (!pendientes.empty()) {
+			std::pair<Nodo*, bool> cima = pendientes.top();
+			pendientes.pop();
+			Nodo *p = cima.first;
+			if (cima.second)
+				acu.push_back(p->elem);
+			else {
+				pendientes.push(std::make_pair(p, true));
+				if (p->dr != nullptr)
+					pendientes.push(std::make_pair(p->dr.get(), false));
+				if (p->iz != nullptr)
+					pendientes.push(std::make_pair(p->iz.get(), false));
+			}
+		}
 	}
 
     static void graph_rec(std::ostream & out, int indent, Link raiz){
@@ -263,34 +340,62 @@ protected:
     }
 
 	// //
-	// MÉTODOS AUXILIARES (RECURSIVOS) DE OTRAS OPERACIONES OBSERVADORAS
+	// MÉTODOS AUXILIARES (ITERATIVOS) DE OTRAS OPERACIONES OBSERVADORAS
 	// //
 
 	static unsigned int numNodosAux(Link ra) {
-		if (ra == nullptr)
-			return 0;
-		return 1 + numNodosAux(ra->iz) + numNodosAux(ra->dr);
+		unsigned int num = 0;
+		Stack<Nodo*> pendientes;
+		if (ra != nullptr)
+			pendientes.push(ra.get());
+		while (!pendientes.empty()) {
+			Nodo *p = pendientes.top();
+			pendientes.pop();
+			++num;
+			if (p->iz != nullptr)
+				pendientes.push(p->iz.get());
+			if (p->dr != nullptr)
+				pendientes.push(p->dr.get());
+		}
+		return num;
 	}
 
+	/** Se apila cada nodo junto con su profundidad (la raíz está a profundidad 1). */
 	static unsigned int tallaAux(Link ra) {
-		if (ra == nullptr)
-			return 0;
-		int tallaiz = tallaAux(ra->iz);
-		int talladr = tallaAux(ra->dr);
-		if (tallaiz > talladr)
-			return 1 + tallaiz;
-		else
-			return 1 + talladr;
+		unsigned int talla = 0;
+		Stack<std::pair<Nodo*, unsigned int>> pendientes;
+		if (ra != nullptr)
+			pendientes.push(std::make_pair(ra.get(), 1u));
+		while (!pendientes.empty()) {
+			Nodo *p = pendientes.top().first;
+			unsigned int prof = pendientes.top().second;
+			pendientes.pop();
+			if (prof > talla)
+				talla = prof;
+			if (p->iz != nullptr)
+				pendientes.push(std::make_pair(p->iz.get(), prof + 1));
+			if (p->dr != nullptr)
+				pendientes.push(std::make_pair(p->dr.get(), prof + 1));
+		}
+		return talla;
 	}
 
 	static unsigned int numHojasAux(Link ra) {
-		if (ra == nullptr)
-			return 0;
-
-		if ((ra->iz == NULL) && (ra->dr == NULL))
-			return 1;
-
-		return numHojasAux(ra->iz) + numHojasAux(ra->dr);
+		unsigned int num = 0;
+		Stack<Nodo*> pendientes;
+		if (ra != nullptr)
+			pendientes.push(ra.get());
+		while (!pendientes.empty()) {
+			Nodo *p = pendientes.top();
+			pendientes.pop();
+			if ((p->iz == NULL) && (p->dr == NULL))
+				++num;
+			if (p->iz != nullptr)
+				pendientes.push(p->iz.get());
+			if (p->dr != nullptr)
+				pendientes.push(p->dr.get());
+		}
+		return num;
 	}
 
 private:
@@ -299,17 +404,25 @@ private:
 	 * Compara dos estructuras jerárquicas de nodos, dadas sus raices.
 	 */
 	static bool comparaAux(Link r1, Link r2) {
-		if (r1 == r2)
-			return true;
-		else if ((r1 == nullptr) || (r2 == nullptr))
-			// En el if anterior nos aseguramos de que r1 != r2. Si uno es NULL, el
-			// otro entonces no lo será, luego son distintos.
-			return false;
-		else {
-			return (r1->elem == r2->elem) &&
-                   comparaAux(r1->iz, r2->iz) &&
-                   comparaAux(r1->dr, r2->dr);
+		// Parejas de subárboles (uno de cada árbol) que quedan por comparar
+		Stack<std::pair<Nodo*, Nodo*>> pendientes;
+		pendientes.push(std::make_pair(r1.get(), r2.get()));
+		while (!pendientes.empty()) {
+			Nodo *p1 = pendientes.top().first;
+			Nodo *p2 = pendientes.top().second;
+			pendientes.pop();
+			if (p1 == p2)
+				continue; // el mismo subárbol (o los dos vacíos)
+			else if ((p1 == nullptr) || (p2 == nullptr))
+				// En el if anterior nos aseguramos de que p1 != p2. Si uno es NULL, el
+				// otro entonces no lo será, luego son distintos.
+				return false;
+			else if (!(p1->elem == p2->elem))
+				return false;
+			pendientes.push(std::make_pair(p1->dr.get(), p2->dr.get()));
+			pendientes.push(std::make_pair(p1->iz.get(), p2->iz.get()));
 		}
+		return true;
 	}
 
 protected:
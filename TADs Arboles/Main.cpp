@@ -0,0 +1,8 @@
+#include "Tests.h"
+
+int main(){
+	testArbinDegenerado();
+	testArbinSDegenerado();
+	testTreeSetOrdenado();
+	testCopiasIguales();
+}
@@ -0,0 +1,138 @@
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <string>
+using namespace std;
+
+#include "Arbin.h"
+#include "Arbin_Smart.h"
+#include "TreeSet.h"
+
+// Pruebas de estrés con árboles de un millón de nodos. Con árboles
+// degenerados (cada nodo con un único hijo) la talla es igual al número de
+// nodos, así que cualquier operación recursiva desbordaría la pila.
+
+static const unsigned int N = 1000000;
+
+static void comprueba(bool cond, const char *que){
+	cout << (cond ? "OK    " : "ERROR ") << que << endl;
+}
+
+/** Comprueba que la lista tiene n elementos que forman la sucesión ini, ini + paso, ... */
+template <typename L>
+static bool esSucesion(const L *l, unsigned int n, int ini, int paso){
+	if (l->size() != n)
+		return false;
+	int esperado = ini;
+	for (auto it = l->cbegin(); it != l->cend(); ++it, esperado += paso)
+		if (it.elem() != esperado)
+			return false;
+	return true;
+}
+
+/**
+ * Pruebas comunes a Arbin y ArbinS. El árbol se construye en zigzag: el nodo i
+ * tiene como único hijo al árbol de los nodos 0..i-1, a la izquierda si i es
+ * impar y a la derecha si es par.
+ */
+template <typename A>
+static void pruebaDegenerado(){
+	A a;
+	for (unsigned int i = 0; i < N; ++i)
+		a = (i % 2 == 1) ? A(a, (int) i, A()) : A(A(), (int) i, a);
+	comprueba(a.numNodos() == N, "numNodos");
+	comprueba(a.talla() == N, "talla");
+	comprueba(a.numHojas() == 1, "numHojas");
+
+	// Copia y comparación con un árbol igual construido aparte
+	A copia(a);
+	comprueba(copia == a, "copy ==");
+	A b;
+	for (unsigned int i = 0; i < N; ++i)
+		b = (i % 2 == 1) ? A(b, (int) i, A()) : A(A(), (int) i, b);
+	comprueba(b == a, "== on an equal tree");
+	A c;
+	for (unsigned int i = 0; i < N; ++i)
+		c = (i % 2 == 1) ? A(c, (int) (i == N / 2 + 1 ? 0 : i), A()) : A(A(), (int) i, c);
+	comprueba(c != a, "!= on a different tree");
+
+	// Recorridos: en preorden se va de la raíz (N-1) hacia abajo y en
+	// postorden de abajo arriba
+	auto *pre = a.preorden();
+	comprueba(esSucesion(pre, N, N - 1, -1), "preorden");
+	delete pre;
+	auto *post = a.postorden();
+	comprueba(esSucesion(post, N, 0, 1), "postorden");
+	delete post;
+	auto *ino = a.inorden();
+	comprueba(ino->size() == N, "inorden");
+	delete ino;
+	auto *niv = a.niveles();
+	comprueba(esSucesion(niv, N, N - 1, -1), "niveles");
+	delete niv;
+	// Al salir se destruyen los cuatro árboles
+}
+
+void testArbinDegenerado(){
+	cout << "Arbin, " << N << " nodes in a chain" << endl;
+	pruebaDegenerado<Arbin<int>>();
+}
+
+void testArbinSDegenerado(){
+	cout << "ArbinS, " << N << " nodes in a chain" << endl;
+	pruebaDegenerado<ArbinS<int>>();
+}
+
+/** Igualdad de conjuntos: cada uno contenido en el otro */
+template <typename S>
+static bool iguales(const S &s1, const S &s2){
+	return s1.size() == s2.size() && s1.is_subset_of(s2) && s2.is_subset_of(s1);
+}
+
+void testTreeSetOrdenado(){
+	// Insertar en orden es lo que degeneraría un árbol de búsqueda sin equilibrar
+	cout << "TreeSet, " << N << " sorted inserts" << endl;
+	TreeSet<int> s;
+	for (unsigned int i = 0; i < N; ++i)
+		s.insert((int) i);
+	comprueba(s.size() == (int) N, "size");
+	int esperado = 0;
+	bool enOrden = true;
+	for (auto it = s.cbegin(); it != s.cend(); ++it, ++esperado)
+		enOrden = enOrden && *it == esperado;
+	comprueba(enOrden && esperado == (int) N, "in-order iteration");
+
+	TreeSet<int> copia(s);
+	comprueba(iguales(copia, s), "copy ==");
+	TreeSet<int> inverso;
+	for (unsigned int i = N; i > 0; --i)
+		inverso.insert((int) i - 1);
+	comprueba(iguales(inverso, s), "== with reverse-order inserts");
+	copia.erase((int) N / 2);
+	comprueba(!iguales(copia, s) && copia.size() == (int) N - 1, "!= after erase");
+
+	for (unsigned int i = 0; i < N; i += 2)
+		s.erase((int) i);
+	comprueba(s.size() == (int) N / 2 && s.select(0) != s.cend() && *s.select(0) == 1, "erase evens");
+}
+
+/** Contenido completo de un fichero (vacío si no se puede abrir) */
+static string leeFichero(const string &nombre){
+	ifstream f(nombre, ios::binary);
+	return string(istreambuf_iterator<char>(f), istreambuf_iterator<char>());
+}
+
+/**
+ * TreeMap.h y Allocators.h son copias de los de "TADs Treemap y Hashmap"
+ * (los conjuntos se implementan sobre ese TreeMap). Cualquier cambio se
+ * tiene que hacer en los dos sitios; esta prueba avisa si se olvida uno.
+ * Hay que ejecutarla desde este directorio.
+ */
+void testCopiasIguales(){
+	cout << "TreeMap.h and Allocators.h, same as in ../TADs Treemap y Hashmap" << endl;
+	const char *ficheros[] = { "TreeMap.h", "Allocators.h" };
+	for (const char *f : ficheros){
+		string aqui = leeFichero(f), alli = leeFichero(string("../TADs Treemap y Hashmap/") + f);
+		comprueba(!aqui.empty() && aqui == alli, f);
+	}
+}
@@ -0,0 +1,9 @@
+#ifndef TESTS_H_
+#define TESTS_H_
+
+void testArbinDegenerado();
+void testArbinSDegenerado();
+void testTreeSetOrdenado();
+void testCopiasIguales();
+
+#endif /* TESTS_H_ */
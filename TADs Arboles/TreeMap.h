@@ -0,0 +1,1705 @@
+/**
+ * Implementación del TAD Dictionary utilizando árboles de búsqueda.
+ * (c) Marco Antonio Gómez Martín, 2012
+ * Adaptada por Ignacio Fábregas, 2022
+*/
+
+#ifndef __TREEMAP_H
+#define __TREEMAP_H
+
+#include <algorithm>
+#include <cstddef>
+#include <functional>
+#include <iostream>
+#include <type_traits>
+#include <utility>
+#include <vector>
+#include "Allocators.h"
+#include "Exceptions.h"
+
+/**
+ * Guarda un objeto de tipo T. Si T es una clase vacía (std::less, NewAllocator,
+ * el SinValor de TreeSetC...) se guarda como clase base en vez de como
+ * atributo, y por la optimización de la base vacía no ocupa memoria en la
+ * clase que hereda de Compacto. Id distingue varios Compacto de una misma clase.
+ */
+template <typename T, int Id, bool = std::is_empty<T>::value && !std::is_final<T>::value>
+class Compacto {
+public:
+	Compacto() : obj() {}
+
+	/** Construye el objeto a partir de los argumentos. */
+	template <typename... Args>
+	explicit Compacto(std::in_place_t, Args&&... args) : obj(std::forward<Args>(args)...) {}
+
+	T &get() {
+		return obj;
+	}
+
+	const T &get() const {
+		return obj;
+	}
+
+private:
+	T obj;
+};
+
+/** Compacto de una clase vacía: el objeto es la propia base. */
+template <typename T, int Id>
+class Compacto<T, Id, true> : private T {
+public:
+	Compacto() : T() {}
+
+	/** Construye el objeto a partir de los argumentos. */
+	template <typename... Args>
+	explicit Compacto(std::in_place_t, Args&&... args) : T(std::forward<Args>(args)...) {}
+
+	T &get() {
+		return *this;
+	}
+
+	const T &get() const {
+		return *this;
+	}
+};
+
+/**
+ * Clase nodo de TreeMap, que almacena internamente la pareja (clave, valor),
+ * los punteros al hijo izquierdo, al hijo derecho y al padre (nullptr en
+ * la raíz) y la altura y el número de nodos del subárbol que cuelga del nodo
+ * (los dos enteros ocupan juntos lo mismo que un puntero).
+ * Los constructores que reciben los hijos los hacen apuntar al nodo.
+ * El valor se guarda en una base Compacto, así que si Valor es una clase vacía
+ * (como en TreeSetC) el nodo no gasta memoria en él.
+ */
+template <typename Clave, typename Valor>
+class NodoTreeMap : private Compacto<Valor, 0> {
+private:
+	using Nodo = NodoTreeMap;
+	using BaseValor = Compacto<Valor, 0>;
+
+public:
+	NodoTreeMap() : iz(nullptr), dr(nullptr), padre(nullptr), altura(1), tam(1) {}
+	NodoTreeMap(const Clave &clave, const Valor &valor)
+		: BaseValor(std::in_place, valor), clave(clave), iz(nullptr), dr(nullptr), padre(nullptr), altura(1), tam(1) {}
+	NodoTreeMap(Nodo *iz, const Clave &clave, const Valor &valor, Nodo *dr)
+		: BaseValor(std::in_place, valor), clave(clave), iz(iz), dr(dr), padre(nullptr), altura(1 + alturaMayor(iz, dr)),
+		  tam(1 + tamHijos(iz, dr)) {
+		adopta();
+	}
+	/** Construye la clave y el valor en el propio nodo a partir de los argumentos. */
+	template <typename C, typename... Args>
+	NodoTreeMap(Nodo *iz, Nodo *dr, C &&clave, Args&&... args)
+		: BaseValor(std::in_place, std::forward<Args>(args)...), clave(std::forward<C>(clave)), iz(iz), dr(dr),
+		  padre(nullptr), altura(1 + alturaMayor(iz, dr)), tam(1 + tamHijos(iz, dr)) {
+		adopta();
+	}
+
+	Valor &valor() {
+		return BaseValor::get();
+	}
+
+	const Valor &valor() const {
+		return BaseValor::get();
+	}
+
+	Clave clave;
+	Nodo* iz;
+	Nodo* dr;
+	Nodo* padre;
+	int altura;
+	int tam;
+
+private:
+	/** Altura del más alto de los dos subárboles. */
+	static int alturaMayor(Nodo *iz, Nodo *dr) {
+		int a = iz == nullptr ? 0 : iz->altura;
+		int b = dr == nullptr ? 0 : dr->altura;
+		return a > b ? a : b;
+	}
+
+	/** Número de nodos de los dos subárboles. */
+	static int tamHijos(Nodo *iz, Nodo *dr) {
+		return (iz == nullptr ? 0 : iz->tam) + (dr == nullptr ? 0 : dr->tam);
+	}
+
+	/** Hace que los hijos apunten a este nodo como padre. */
+	void adopta() {
+		if (iz != nullptr) iz->padre = this;
+		if (dr != nullptr) dr->padre = this;
+	}
+};
+
+/**
+ * Implementación dinámica del TAD Dictionary utilizando  árboles de búsqueda auto-balanceados (AVL).
+ * Cada nodo guarda la altura de su subárbol y, tras cada inserción o borrado, se
+ *          rota lo necesario para que las alturas de los dos hijos de cualquier nodo
+ *          difieran como mucho en 1. Así la altura es O(log n) aunque las claves
+ *          lleguen ordenadas, y todas las operaciones son O(log n) en el caso peor.
+ * Cada nodo guarda también un puntero a su padre, así los iteradores son sólo un
+ *          puntero al nodo actual y pueden avanzar y retroceder sin memoria adicional.
+ * Se añade un comparador entre claves: objeto función que acepta dos valores de tipo T y devuelve si el
+ *          primero es menor que el segundo. Por defecto se toma el "<" en T si está definido
+ * Los nodos se crean y destruyen con el asignador que se pasa como parámetro
+ *          (ver Allocators.h); por defecto se usan new y delete.
+ * Las operaciones son:
+ *    - TreeMapVacio: operación generadora que construye un árbol de búsqueda vacío.
+ *    - Insert(clave, valor): generadora que añade una nueva pareja (clave, valor) al árbol.
+ *          Si la clave ya estaba se sustituye el valor.
+ *    - erase(clave): operación modificadora. Elimina la clave del árbol de búsqueda.
+ *          Si la clave no está la operación no tiene efecto.
+ *    - at(clave): operación observadora que devuelve el valor asociado a una clave.
+ *          Es un error preguntar por una clave que no existe.
+ *    - contains(clave): operación observadora. Sirve para averiguar si se ha introducido una
+ *          clave en el árbol
+ *    - empty(): operación observadora que indica si el árbol de búsqueda tiene alguna clave introducida.
+ *    - size(): operación observadora que indica el tamaño del diccionario.
+ * Además, emplace y try_emplace construyen el valor directamente en el nodo e
+ * insert_or_assign inserta o sustituye indicando si la clave era nueva.
+ * Si el comparador es transparente (define is_transparent, como std::less<>),
+ * at, contains y find admiten claves de otros tipos comparables con Clave
+ * (std::string_view, const char*...) sin construir una Clave.
+ * Para consultas ordenadas están lower_bound, upper_bound, equal_range, floor,
+ * ceiling y range(lo, hi), que permite recorrer las claves de [lo, hi) en O(log n + k).
+ * Cada nodo guarda además el número de nodos de su subárbol, con lo que select(k),
+ * rank(clave) y count_range(lo, hi) son O(log n).
+ * Un diccionario se puede construir de golpe a partir de un rango de parejas
+ * (clave, valor) y, si el rango viene ordenado, el árbol (perfectamente
+ * equilibrado) se construye en O(n); insert_sorted mezcla un rango así con
+ * un diccionario ya existente.
+ * Para no bajar dos veces por el árbol, find_or_insert busca e inserta a la vez
+ * y devuelve un iterador; insert admite una pista (el iterador delante del que
+ * va la clave) con la que no hace falta bajar desde la raíz, y erase admite un
+ * iterador. Como cada nodo conoce a su padre, el reequilibrado se hace subiendo
+ * desde el nodo que cambia.
+ * union_with, intersect_with, difference_with e is_subset_of operan con las claves
+ * de dos diccionarios recorriéndolos a la vez, en orden, en O(n + m).
+ * split(clave) parte el diccionario en dos por una clave y join une dos
+ * diccionarios cuyas claves no se solapan, ambos en O(log n).
+ * Si Valor, el comparador o el asignador son clases vacías no ocupan memoria
+ * (se guardan con Compacto). Los detalles internos son protected porque TreeSetC
+ * (TADs Arboles) es un TreeMap cuyo valor es una clase vacía.
+ */
+template <typename Clave, typename Valor, typename Comparador = std::less<Clave>,
+		template <typename> class Asignador = NewAllocator>
+class TreeMap : private Compacto<Comparador, 0>, private Compacto<Asignador<NodoTreeMap<Clave, Valor>>, 1> {
+protected:
+	/** Nodos del árbol (ver NodoTreeMap). */
+	using Nodo = NodoTreeMap<Clave, Valor>;
+
+	/** El comparador y el asignador se guardan como bases (ver Compacto). */
+	using BaseComparador = Compacto<Comparador, 0>;
+	using BaseAsignador = Compacto<Asignador<Nodo>, 1>;
+
+public:
+
+	/** Constructor; operación EmptyTreeMap */
+	TreeMap() : ra(nullptr) { numElems =0;}
+
+	/**
+	 * Constructor a partir de un rango [ini, fin) de parejas (clave, valor)
+	 * (cualquier tipo con first y second, como std::pair). Si una clave se
+	 * repite se queda el último valor, como si se hubieran insertado en orden.
+	 * Los nodos se crean en una sola pasada y después se enlazan formando un
+	 * árbol perfectamente equilibrado, sin comparar al bajar desde la raíz.
+	 * O(n) si el rango está ordenado por clave; O(n log n) si no lo está.
+	 */
+	template <typename It>
+	TreeMap(It ini, It fin) : ra(nullptr), numElems(0) {
+		std::vector<Nodo*> nodos;
+		creaNodos(ini, fin, nodos);
+		enlaza(nodos);
+	}
+
+	/** Destructor; elimina la estructura de nodos. */
+	~TreeMap() {
+		libera();
+        ra = nullptr;
+        numElems = 0;
+	}
+
+	/**
+	 * Operación generadora que añade una nueva clave/valor a un árbol de búsqueda.
+	 * Si la clave ya existía, sustituimos el valor viejo por el nuevo.
+	 * El aumento en el número de elementos se maneja en buscaOInserta
+	 * O(log n)
+	 */
+	void insert(const Clave &clave, const Valor &valor) {
+        bool insertado;
+        Nodo *p = buscaOInserta(clave, insertado, valor);
+        if (!insertado)
+            p->valor() = valor;
+	}
+
+	/** Como insert, pero moviendo la clave y el valor en vez de copiarlos. O(log n) */
+	void insert(Clave &&clave, Valor &&valor) {
+        bool insertado;
+        Nodo *p = buscaOInserta(std::move(clave), insertado, std::move(valor));
+        if (!insertado)
+            p->valor() = std::move(valor);
+	}
+
+	/**
+	 * Añade la clave con un valor construido en el propio nodo a partir de args.
+	 * Si la clave ya estaba no se hace nada (y no se construye ningún valor).
+	 * Devuelve si la clave era nueva.
+	 * O(log n)
+	 */
+	template <typename... Args>
+	bool try_emplace(const Clave &clave, Args&&... args) {
+        bool insertado;
+        buscaOInserta(clave, insertado, std::forward<Args>(args)...);
+        return insertado;
+	}
+
+	template <typename... Args>
+	bool try_emplace(Clave &&clave, Args&&... args) {
+        bool insertado;
+        buscaOInserta(std::move(clave), insertado, std::forward<Args>(args)...);
+        return insertado;
+	}
+
+	/**
+	 * Añade una pareja construyendo la clave a partir de c y el valor a partir
+	 * de args. Como en try_emplace, si la clave ya estaba no se hace nada.
+	 * Devuelve si la clave era nueva.
+	 * O(log n)
+	 */
+	template <typename C, typename... Args>
+	bool emplace(C &&c, Args&&... args) {
+        return try_emplace(Clave(std::forward<C>(c)), std::forward<Args>(args)...);
+	}
+
+	/**
+	 * Como insert (si la clave ya estaba se sustituye el valor), pero
+	 * devuelve si la clave era nueva.
+	 * O(log n)
+	 */
+	template <typename V>
+	bool insert_or_assign(const Clave &clave, V &&valor) {
+        bool insertado;
+        Nodo *p = buscaOInserta(clave, insertado, std::forward<V>(valor));
+        if (!insertado)
+            p->valor() = std::forward<V>(valor);
+        return insertado;
+	}
+
+	template <typename V>
+	bool insert_or_assign(Clave &&clave, V &&valor) {
+        bool insertado;
+        Nodo *p = buscaOInserta(std::move(clave), insertado, std::forward<V>(valor));
+        if (!insertado)
+            p->valor() = std::forward<V>(valor);
+        return insertado;
+	}
+
+	/**
+	 * Añade todas las parejas (clave, valor) del rango [ini, fin), que debería
+	 * estar ordenado por clave. Como en insert, si una clave ya estaba se
+	 * sustituye su valor. En vez de bajar desde la raíz por cada pareja, se
+	 * mezclan en orden los nodos del árbol con los nuevos y se vuelve a
+	 * enlazar todo como un árbol perfectamente equilibrado.
+	 * O(n + m) siendo m el tamaño del rango (O(n + m log m) si no está ordenado).
+	 */
+	template <typename It>
+	void insert_sorted(It ini, It fin) {
+		std::vector<Nodo*> nuevos;
+		creaNodos(ini, fin, nuevos);
+		mezclaNodos(nuevos);
+	}
+
+	/**
+	 * Operación modificadora que elimina una clave del árbol.
+	 * Si la clave no existía la operación no tiene efecto.
+	 * El decremento en el número de elementos se maneja en borraNodo
+	 * O(log n)
+	 */
+	void erase(const Clave &clave) {
+        Nodo *p = buscaAux(ra, clave);
+        if (p != nullptr)
+            borraNodo(p);
+	}
+
+	/**
+	 * Operación observadora que devuelve el valor asociado
+	 a una clave dada. O(log n)
+	 */
+	const Valor &at(const Clave &clave) const {
+		Nodo *p = buscaAux(ra, clave);
+		if (p == nullptr)
+			throw EClaveErronea();
+		return p->valor();
+	}
+
+	/**
+	 * Operación observadora que permite averiguar si una clave
+	 * determinada está en el árbol de búsqueda. O(log n)
+	 */
+	bool contains(const Clave &clave) const {
+		return (buscaAux(ra, clave) != nullptr) ? true : false;
+	}
+
+	/**
+	 * Versiones de at y contains que buscan con una clave de otro tipo K sin
+	 * construir una Clave temporal. Sólo existen si el comparador es
+	 * transparente, es decir, si sabe comparar K con Clave. O(log n)
+	 */
+	template <typename K, typename C = Comparador, typename = typename C::is_transparent>
+	const Valor &at(const K &clave) const {
+		Nodo *p = buscaAux(ra, clave);
+		if (p == nullptr)
+			throw EClaveErronea();
+		return p->valor();
+	}
+
+	template <typename K, typename C = Comparador, typename = typename C::is_transparent>
+	bool contains(const K &clave) const {
+		return buscaAux(ra, clave) != nullptr;
+	}
+
+	/** Operación observadora que devuelve si un diccionario es vacío */
+	bool empty() const {
+		return ra == nullptr;
+	}
+
+    /** Operación observadora que devuelve el número de elementos del diccionario */
+    int size() const{
+        return numElems;
+    }
+
+	/**
+	 * Sobrecarga del operador [] que permite acceder al valor asociado a una clave y modificarlo.
+	 * Si el elemento buscado no estaba, se inserta uno con el valor por defecto del tipo Valor.
+	 */
+	Valor &operator[](const Clave &clave) {
+        bool insertado;
+		Nodo* ret = buscaOInserta(clave, insertado); //busca o inserta el elemento.
+		return ret->valor(); //ret es donde está el valor asociado a la clave.
+	}
+
+	Valor &operator[](Clave &&clave) {
+        bool insertado;
+		return buscaOInserta(std::move(clave), insertado)->valor();
+	}
+
+    /** Dibujo del diccionario: Uso únicamente para debugear durante clase */
+    friend std::ostream& operator<<(std::ostream& o, const TreeMap& t){
+        o<<"{";
+        muestra(t.ra, o);
+        o<<"}";
+        return o;
+    }
+
+
+    // //
+	// ITERADOR CONSTANTE Y FUNCIONES RELACIONADAS
+	// //
+
+	/**
+	 * Clase interna que implementa un iterador que permite
+	 * recorrer el diccionario pero no modificarlo.
+	 * Basta con el puntero al nodo actual: como cada nodo conoce a su padre,
+	 * se puede avanzar y retroceder sin guardar los ascendientes.
+	 */
+	class ConstIterator {
+	public:
+		ConstIterator() : act(nullptr) {}
+
+        /** Avanza al siguiente en inorden. O(1) amortizado (O(log n) en el caso peor) */
+        void next() {
+            if (act == nullptr)
+                throw InvalidAccessException();
+            act = siguiente(act);
+        }
+
+        /**
+         * Retrocede al anterior en inorden. Desde el primero se pasa al final.
+         * O(1) amortizado (O(log n) en el caso peor)
+         */
+        void prev() {
+            if (act == nullptr)
+                throw InvalidAccessException();
+            act = anterior(act);
+        }
+
+        /** O(1) */
+		const Clave &key() const {
+			if (act == nullptr) throw InvalidAccessException();
+			return act->clave;
+		}
+
+        /** O(1) */
+		const Valor &value() const {
+			if (act == nullptr) throw InvalidAccessException();
+			return act->valor();
+		}
+
+        /** O(1) */
+		bool operator==(const ConstIterator &other) const {
+			return act == other.act;
+		}
+
+        /** O(1) */
+		bool operator!=(const ConstIterator &other) const {
+			return !(this->operator==(other));
+		}
+
+        /** O(1) amortizado */
+		ConstIterator &operator++() {
+			next();
+			return *this;
+		}
+
+        /** O(1) amortizado */
+		ConstIterator operator++(int) {
+			ConstIterator ret(*this);
+			operator++();
+			return ret;
+		}
+
+        /** O(1) amortizado */
+		ConstIterator &operator--() {
+			prev();
+			return *this;
+		}
+
+        /** O(1) amortizado */
+		ConstIterator operator--(int) {
+			ConstIterator ret(*this);
+			operator--();
+			return ret;
+		}
+
+	protected:
+        friend class TreeMap;
+
+        ConstIterator(Nodo *act) : act(act) {}
+
+        /** Puntero al nodo actual del recorrido */
+        Nodo *act;
+	};
+
+    /**
+     * Devuelve el iterador constante al principio del recorrido inorden.
+     * Es decir, empieza por el elemento más pequeño.
+     * O(log n)
+     */
+	ConstIterator cbegin() const {
+		return ConstIterator(minimo(ra));
+	}
+
+    /** Devuelve un iterador constante al final del recorrido (fuera de éste). O(1) */
+	ConstIterator cend() const {
+		return ConstIterator(nullptr);
+	}
+
+    /**
+     * Devuelve el iterador constante al último elemento del recorrido inorden
+     * (la clave más grande), para recorrer el diccionario hacia atrás con --.
+     * O(log n)
+     */
+	ConstIterator clast() const {
+		return ConstIterator(maximo(ra));
+	}
+
+    /**
+    * Devuelve un iterador constante al nodo con elemento c.
+    * Devuelve el iterador cend si no está
+    */
+	ConstIterator find(const Clave &c) const {
+		return ConstIterator(buscaAux(ra, c));
+	}
+
+	/** find con una clave de otro tipo (sólo si el comparador es transparente). */
+	template <typename K, typename C = Comparador, typename = typename C::is_transparent>
+	ConstIterator find(const K &c) const {
+		return ConstIterator(buscaAux(ra, c));
+	}
+
+	// //
+	// ITERADOR NO CONSTANTE Y FUNCIONES RELACIONADAS
+	// //
+
+	/**
+	 * Clase interna que implementa un iterador sobre el árbol de búsqueda
+	 * que permite recorrer la lista e incluso alterar el valor de sus elementos.
+	 */
+	class Iterator {
+	public:
+		Iterator() : act(nullptr) {}
+
+        /** Avanza al siguiente en inorden. O(1) amortizado (O(log n) en el caso peor) */
+        void next() {
+            if (act == nullptr)
+                throw InvalidAccessException();
+            act = siguiente(act);
+        }
+
+        /**
+         * Retrocede al anterior en inorden. Desde el primero se pasa al final.
+         * O(1) amortizado (O(log n) en el caso peor)
+         */
+        void prev() {
+            if (act == nullptr)
+                throw InvalidAccessException();
+            act = anterior(act);
+        }
+
+        /** O(1) */
+		const Clave &key() const {
+			if (act == nullptr) throw InvalidAccessException();
+			return act->clave;
+		}
+
+        /** O(1) */
+		Valor &value() const {
+			if (act == nullptr) throw InvalidAccessException();
+			return act->valor();
+		}
+
+        /** O(1) */
+		bool operator==(const Iterator &other) const {
+			return act == other.act;
+		}
+
+        /** O(1) */
+		bool operator!=(const Iterator &other) const {
+			return !(this->operator==(other));
+		}
+
+        /** O(1) amortizado */
+		Iterator &operator++() {
+			next();
+			return *this;
+		}
+
+        /** O(1) amortizado */
+		Iterator operator++(int) {
+			Iterator ret(*this);
+			operator++();
+			return ret;
+		}
+
+        /** O(1) amortizado */
+		Iterator &operator--() {
+			prev();
+			return *this;
+		}
+
+        /** O(1) amortizado */
+		Iterator operator--(int) {
+			Iterator ret(*this);
+			operator--();
+			return ret;
+		}
+
+	protected:
+		friend class TreeMap;
+
+		Iterator(Nodo *act) : act(act) {}
+
+        /** Puntero al nodo actual del recorrido */
+        Nodo *act;
+	};
+
+    /**
+    * Devuelve el iterador al principio del recorrido inorden.
+    * Es decir, empieza por el elemento más pequeño.
+    * O(log n)
+    */
+    Iterator begin() {
+        return Iterator(minimo(ra));
+    }
+
+    /** Devuelve un iterador constante al final del recorrido (fuera de éste). O(1) */
+    Iterator end() const {
+        return Iterator(nullptr);
+    }
+
+    /**
+     * Devuelve el iterador al último elemento del recorrido inorden (la clave
+     * más grande), para recorrer el diccionario hacia atrás con --.
+     * O(log n)
+     */
+    Iterator last() {
+        return Iterator(maximo(ra));
+    }
+
+    /**
+    * Devuelve un iterador constante al nodo con elemento c.
+    * Devuelve el iterador end si no está.
+    * O(log n)
+    */
+	Iterator find(const Clave &c) {
+		return Iterator(buscaAux(ra, c));
+	}
+
+	/** find con una clave de otro tipo (sólo si el comparador es transparente). */
+	template <typename K, typename C = Comparador, typename = typename C::is_transparent>
+	Iterator find(const K &c) {
+		return Iterator(buscaAux(ra, c));
+	}
+
+	/**
+	 * Busca la clave y, si no está, la añade con un valor construido a partir
+	 * de args (sin args, el valor por defecto). Devuelve un iterador a la
+	 * clave y si era nueva, bajando una sola vez por el árbol (en vez de
+	 * contains seguido de insert). Si no era nueva no se usa ningún argumento.
+	 * O(log n)
+	 */
+	template <typename... Args>
+	std::pair<Iterator, bool> find_or_insert(const Clave &clave, Args&&... args) {
+        bool insertado;
+        Nodo *p = buscaOInserta(clave, insertado, std::forward<Args>(args)...);
+        return std::make_pair(Iterator(p), insertado);
+	}
+
+	template <typename... Args>
+	std::pair<Iterator, bool> find_or_insert(Clave &&clave, Args&&... args) {
+        bool insertado;
+        Nodo *p = buscaOInserta(std::move(clave), insertado, std::forward<Args>(args)...);
+        return std::make_pair(Iterator(p), insertado);
+	}
+
+	/**
+	 * insert con una pista: hint debería ser la posición delante de la cual va
+	 * la clave, es decir, la primera clave mayor que ella (o end() si es la
+	 * mayor). Si la pista es correcta el nodo nuevo se cuelga directamente, con
+	 * dos comparaciones, sin bajar desde la raíz; si no lo es (o la clave ya
+	 * estaba), se hace un insert normal. Devuelve un iterador a la clave.
+	 * Si las claves llegan en orden, basta con dar end() como pista.
+	 * O(1) comparaciones si la pista es correcta, pero el reequilibrado
+	 * sigue subiendo hasta la raíz para actualizar los tamaños: O(log n).
+	 */
+	Iterator insert(Iterator hint, const Clave &clave, const Valor &valor) {
+		Nodo *sig = hint.act;
+		Nodo *ant = sig == nullptr ? maximo(ra) : anterior(sig);
+		if ((ant != nullptr && !cless(ant->clave, clave)) ||
+				(sig != nullptr && !cless(clave, sig->clave))) {
+			// La pista no sirve: ant >= clave o clave >= sig
+			bool insertado;
+			Nodo *p = buscaOInserta(clave, insertado, valor);
+			if (!insertado)
+				p->valor() = valor;
+			return Iterator(p);
+		}
+		// ant < clave < sig, así que el nuevo nodo va entre los dos: en el hijo
+		// izquierdo de sig si está libre y si no (o si no hay sig), en el hijo
+		// derecho de ant, que tiene que estar libre.
+		Nodo *nuevo = asig().nuevo(nullptr, nullptr, clave, valor);
+		if (sig != nullptr && sig->iz == nullptr) {
+			sig->iz = nuevo;
+			nuevo->padre = sig;
+		} else if (ant != nullptr) {
+			ant->dr = nuevo;
+			nuevo->padre = ant;
+		} else // el árbol era vacío
+			ra = nuevo;
+		++numElems;
+		reequilibraDesde(nuevo->padre);
+		return Iterator(nuevo);
+	}
+
+	/**
+	 * Elimina la pareja a la que apunta el iterador, sin volver a buscar la
+	 * clave, y devuelve un iterador a la siguiente. El resto de iteradores
+	 * siguen siendo válidos.
+	 * O(log n) para reequilibrar
+	 */
+	Iterator erase(Iterator it) {
+		if (it.act == nullptr)
+			throw InvalidAccessException();
+		Nodo *sig = siguiente(it.act);
+		borraNodo(it.act);
+		return Iterator(sig);
+	}
+
+
+	// //
+	// BÚSQUEDAS POR RANGO Y NAVEGACIÓN ORDENADA
+	// //
+
+	/**
+	 * Devuelve un iterador constante a la primera clave mayor o igual que c
+	 * (cend si no hay ninguna). O(log n)
+	 */
+	ConstIterator lower_bound(const Clave &c) const {
+		return ConstIterator(primeroNoMenor(c));
+	}
+
+	/**
+	 * Devuelve un iterador constante a la primera clave estrictamente mayor
+	 * que c (cend si no hay ninguna). O(log n)
+	 */
+	ConstIterator upper_bound(const Clave &c) const {
+		return ConstIterator(primeroMayor(c));
+	}
+
+	/**
+	 * Devuelve el par (lower_bound(c), upper_bound(c)): el rango de las
+	 * claves equivalentes a c, que es vacío si c no está. O(log n)
+	 */
+	std::pair<ConstIterator, ConstIterator> equal_range(const Clave &c) const {
+		return std::make_pair(lower_bound(c), upper_bound(c));
+	}
+
+	/**
+	 * Devuelve un iterador constante a la mayor clave menor o igual que c
+	 * (cend si no hay ninguna). O(log n)
+	 */
+	ConstIterator floor(const Clave &c) const {
+		return ConstIterator(ultimoNoMayor(c));
+	}
+
+	/**
+	 * Devuelve un iterador constante a la menor clave mayor o igual que c
+	 * (cend si no hay ninguna). Es lo mismo que lower_bound. O(log n)
+	 */
+	ConstIterator ceiling(const Clave &c) const {
+		return ConstIterator(primeroNoMenor(c));
+	}
+
+	/**
+	 * Rango de un recorrido: un par de iteradores [ini, fin) que se puede
+	 * recorrer con un bucle for, sin copiar ningún elemento.
+	 */
+	template <typename It>
+	class Range {
+	public:
+		/** Iterador al primer elemento del rango. O(1) */
+		It begin() const {
+			return ini;
+		}
+
+		/** Iterador a la posición siguiente al último elemento del rango. O(1) */
+		It end() const {
+			return fin;
+		}
+
+		/** Indica si el rango no tiene ningún elemento. O(1) */
+		bool empty() const {
+			return ini == fin;
+		}
+
+	protected:
+		friend class TreeMap;
+
+		Range(It ini, It fin) : ini(ini), fin(fin) {}
+
+		It ini;
+		It fin;
+	};
+
+	/**
+	 * Devuelve el rango con las claves del intervalo [lo, hi). No se recorre nada
+	 * al crearlo: sólo se localizan sus extremos y después se avanza en inorden,
+	 * así que recorrer el rango cuesta O(log n + k), siendo k su número de elementos.
+	 * Si hi no es mayor que lo el rango es vacío.
+	 */
+	Range<ConstIterator> range(const Clave &lo, const Clave &hi) const {
+		if (!cless(lo, hi))
+			return Range<ConstIterator>(cend(), cend());
+		return Range<ConstIterator>(lower_bound(lo), lower_bound(hi));
+	}
+
+	/** lower_bound que permite modificar los valores. O(log n) */
+	Iterator lower_bound(const Clave &c) {
+		return Iterator(primeroNoMenor(c));
+	}
+
+	/** upper_bound que permite modificar los valores. O(log n) */
+	Iterator upper_bound(const Clave &c) {
+		return Iterator(primeroMayor(c));
+	}
+
+	/** equal_range que permite modificar los valores. O(log n) */
+	std::pair<Iterator, Iterator> equal_range(const Clave &c) {
+		return std::make_pair(lower_bound(c), upper_bound(c));
+	}
+
+	/** floor que permite modificar los valores. O(log n) */
+	Iterator floor(const Clave &c) {
+		return Iterator(ultimoNoMayor(c));
+	}
+
+	/** ceiling que permite modificar los valores. O(log n) */
+	Iterator ceiling(const Clave &c) {
+		return Iterator(primeroNoMenor(c));
+	}
+
+	/** range que permite modificar los valores. O(log n + k) */
+	Range<Iterator> range(const Clave &lo, const Clave &hi) {
+		if (!cless(lo, hi))
+			return Range<Iterator>(end(), end());
+		return Range<Iterator>(lower_bound(lo), lower_bound(hi));
+	}
+
+
+	// //
+	// ESTADÍSTICOS DE ORDEN
+	// //
+
+	/**
+	 * Devuelve un iterador constante a la k-ésima clave más pequeña, contando
+	 * desde 0 (cend si k no está entre 0 y size() - 1).
+	 * Cada nodo sabe cuántos nodos cuelgan de él, así que basta con bajar
+	 * una vez desde la raíz. O(log n)
+	 */
+	ConstIterator select(int k) const {
+		return ConstIterator(seleccion(k));
+	}
+
+	/** select que permite modificar el valor. O(log n) */
+	Iterator select(int k) {
+		return Iterator(seleccion(k));
+	}
+
+	/**
+	 * Devuelve cuántas claves del diccionario son estrictamente menores que c
+	 * (la posición que ocupa, o que ocuparía, c en el recorrido inorden). O(log n)
+	 */
+	int rank(const Clave &c) const {
+		int res = 0;
+		Nodo *p = ra;
+		while (p != nullptr) {
+			if (cless(p->clave, c)) { // p y todo su hijo izquierdo son menores
+				res += tamSubarbol(p->iz) + 1;
+				p = p->dr;
+			} else
+				p = p->iz;
+		}
+		return res;
+	}
+
+	/** Devuelve cuántas claves hay en el intervalo [lo, hi). O(log n) */
+	int count_range(const Clave &lo, const Clave &hi) const {
+		if (!cless(lo, hi))
+			return 0;
+		return rank(hi) - rank(lo);
+	}
+
+
+	// //
+	// OPERACIONES ENTRE DICCIONARIOS
+	// //
+
+	/*
+	 * Operan con las claves. En vez de buscar en un diccionario cada clave del
+	 * otro (O(n log m)), se mezclan los dos recorridos en inorden como en la
+	 * intersección de dos listas ordenadas. Las modificadoras reutilizan los
+	 * nodos de este diccionario que siguen en el resultado y lo vuelven a
+	 * enlazar como un árbol perfectamente equilibrado. Los nodos que sobran se
+	 * borran al final, ya que siguiente() necesita que los ascendientes de un
+	 * nodo sigan existiendo.
+	 */
+
+	/**
+	 * Añade las parejas de other cuya clave no está en este diccionario (las
+	 * claves que están en los dos conservan su valor). O(n + m)
+	 */
+	void union_with(const TreeMap &other) {
+		std::vector<Nodo*> nodos;
+		nodos.reserve(numElems + other.numElems);
+		Nodo *p = minimo(ra);
+		Nodo *q = minimo(other.ra);
+		while (p != nullptr || q != nullptr) {
+			if (q == nullptr || (p != nullptr && cless(p->clave, q->clave))) {
+				nodos.push_back(p);
+				p = siguiente(p);
+			} else if (p == nullptr || cless(q->clave, p->clave)) {
+				nodos.push_back(asig().nuevo(q->clave, q->valor()));
+				q = siguiente(q);
+			} else { // está en los dos
+				nodos.push_back(p);
+				p = siguiente(p);
+				q = siguiente(q);
+			}
+		}
+		enlaza(nodos);
+	}
+
+	/** Deja sólo las parejas cuya clave también está en other. O(n + m) */
+	void intersect_with(const TreeMap &other) {
+		std::vector<Nodo*> nodos, sobran;
+		Nodo *p = minimo(ra);
+		Nodo *q = minimo(other.ra);
+		while (p != nullptr) {
+			if (q == nullptr || cless(p->clave, q->clave)) {
+				sobran.push_back(p);
+				p = siguiente(p);
+			} else if (cless(q->clave, p->clave))
+				q = siguiente(q);
+			else {
+				nodos.push_back(p);
+				p = siguiente(p);
+				q = siguiente(q);
+			}
+		}
+		for (Nodo *n : sobran)
+			asig().borra(n);
+		enlaza(nodos);
+	}
+
+	/** Quita las parejas cuya clave está en other. O(n + m) */
+	void difference_with(const TreeMap &other) {
+		std::vector<Nodo*> nodos, sobran;
+		Nodo *p = minimo(ra);
+		Nodo *q = minimo(other.ra);
+		while (p != nullptr) {
+			if (q == nullptr || cless(p->clave, q->clave)) {
+				nodos.push_back(p);
+				p = siguiente(p);
+			} else if (cless(q->clave, p->clave))
+				q = siguiente(q);
+			else {
+				sobran.push_back(p);
+				p = siguiente(p);
+				q = siguiente(q);
+			}
+		}
+		for (Nodo *n : sobran)
+			asig().borra(n);
+		enlaza(nodos);
+	}
+
+	/** Indica si todas las claves del diccionario están en other. O(n + m) */
+	bool is_subset_of(const TreeMap &other) const {
+		if (numElems > other.numElems)
+			return false;
+		Nodo *p = minimo(ra);
+		Nodo *q = minimo(other.ra);
+		while (p != nullptr) {
+			while (q != nullptr && cless(q->clave, p->clave))
+				q = siguiente(q);
+			if (q == nullptr || cless(p->clave, q->clave))
+				return false; // p->clave no está en other
+			p = siguiente(p);
+			q = siguiente(q);
+		}
+		return true;
+	}
+
+
+	// //
+	// PARTIR Y UNIR DICCIONARIOS
+	// //
+
+	/*
+	 * Dos árboles AVL en los que todas las claves de uno son menores que las
+	 * del otro se unen bajando por el borde del más alto hasta un subárbol de
+	 * la altura del más bajo, colgando allí el más bajo y reequilibrando al
+	 * subir. Para partir un árbol se baja buscando la clave y se van uniendo
+	 * los trozos que quedan a cada lado.
+	 * Con un asignador sin estado (NewAllocator) los nodos pasan de un
+	 * diccionario a otro. Con uno con estado (ArenaAllocator) cada diccionario
+	 * tiene que liberar sus propios nodos, así que los que cambian de
+	 * diccionario se copian y el coste es lineal en ellos.
+	 */
+
+	/**
+	 * Quita del diccionario las claves mayores o iguales que c y las devuelve
+	 * en otro diccionario.
+	 * O(log n) (O(log n + k) con un asignador con estado, siendo k el número
+	 * de claves que cambian de diccionario)
+	 */
+	TreeMap split(const Clave &c) {
+		TreeMap ret;
+		parteEn(c, ret);
+		return ret;
+	}
+
+	/**
+	 * Añade las parejas de other, que queda vacío. Todas las claves de other
+	 * tienen que ser mayores que las del diccionario; si no, se lanza
+	 * EClaveErronea.
+	 * O(log n + log m) (O(log n + m) con un asignador con estado)
+	 */
+	void join(TreeMap &other) {
+		if (other.ra == nullptr)
+			return;
+		if (ra != nullptr && !cless(maximo(ra)->clave, minimo(other.ra)->clave))
+			throw EClaveErronea();
+		Nodo *otros = other.ra;
+		if (!NODOS_COMPARTIDOS) {
+			otros = copiaAux(other.ra);
+			other.libera();
+		}
+		numElems += other.numElems;
+		other.ra = nullptr;
+		other.numElems = 0;
+		// El menor de other hace de nodo central de la unión
+		Nodo *central;
+		otros = quitaMinimo(otros, central);
+		ra = une(ra, central, otros);
+	}
+
+
+	// //
+	// MÉTODOS DE "FONTANERÍA" DE C++ QUE HACEN VERSÁTIL A LA CLASE
+	// //
+
+	/** Constructor copia */
+	TreeMap(const TreeMap &other) : BaseComparador(), BaseAsignador(), ra(nullptr) {
+		copia(other);
+	}
+
+	/** Operador de asignación. O(n) */
+	TreeMap &operator=(const TreeMap &other) {
+		if (this != &other) {
+			libera();
+			copia(other);
+		}
+		return *this;
+	}
+
+	/**
+	 * Constructor de movimiento: se queda con los nodos de other sin copiarlos.
+	 * other queda vacío. O(1)
+	 */
+	TreeMap(TreeMap &&other) noexcept : ra(nullptr), numElems(0) {
+		mueve(other);
+	}
+
+	/** Asignación de movimiento. O(n) para liberar el árbol actual */
+	TreeMap &operator=(TreeMap &&other) noexcept {
+		if (this != &other) {
+			libera();
+			mueve(other);
+		}
+		return *this;
+	}
+
+protected:
+
+	void libera() {
+		// Si el asignador puede liberar todos los nodos de golpe y éstos no
+		// necesitan destructor, no hace falta recorrer el árbol.
+		if (LIBERA_EN_BLOQUE)
+			asig().liberaTodo();
+		else
+			libera(ra);
+	}
+
+	/**
+	 * Pasa a mayores, que tiene que estar vacío, las claves mayores o iguales
+	 * que c (ver split).
+	 */
+	void parteEn(const Clave &c, TreeMap &mayores) {
+		Nodo *menores, *resto;
+		parte(ra, c, menores, resto);
+		int movidos = tamSubarbol(resto);
+		ra = menores;
+		numElems -= movidos;
+		if (!NODOS_COMPARTIDOS && resto != nullptr) {
+			Nodo *copia = mayores.copiaAux(resto);
+			libera(resto);
+			resto = copia;
+		}
+		mayores.ra = resto;
+		mayores.numElems = movidos;
+		mayores.comparador() = comparador();
+	}
+
+	void copia(const TreeMap &other) {
+        ra = copiaAux(other.ra);
+        numElems = other.numElems;
+        comparador() = other.comparador();
+	}
+
+	/**
+	 * Se queda con los nodos, el comparador y el asignador de other, que queda
+	 * vacío. Antes de llamar a este método se debe invocar a "libera".
+	 */
+	void mueve(TreeMap &other) {
+		ra = other.ra;
+		numElems = other.numElems;
+		comparador() = std::move(other.comparador());
+		asig() = std::move(other.asig());
+		other.ra = nullptr;
+		other.numElems = 0;
+	}
+
+	/**
+	 * Elimina todos los nodos de una estructura  que comienza con el puntero n.
+	 * Es iterativo para no desbordar la pila con árboles degenerados: mientras
+	 * el nodo tenga hijo izquierdo se rota a la derecha, y cuando no lo tiene
+	 * se borra y se sigue por el derecho. Cada nodo baja por rotación como
+	 * mucho una vez, así que no hace falta memoria adicional.
+	 * O(n)
+	 */
+	void libera(Nodo *n) {
+		while (n != nullptr) {
+			if (n->iz != nullptr) {
+				Nodo *iz = n->iz;
+				n->iz = iz->dr;
+				iz->dr = n;
+				n = iz;
+			} else {
+				Nodo *dr = n->dr;
+				asig().borra(n);
+				n = dr;
+			}
+		}
+	}
+
+	/**
+	 * Copia la estructura jerárquica de nodos pasada como parámetro
+	 * Se recorre el original en preorden con los punteros al padre, llevando en
+	 * q la copia del nodo actual p, así que no se usa la pila aunque el árbol
+	 * sea degenerado. Un hijo de p está ya copiado si q tiene ese hijo.
+	 * O(n)
+	 */
+	Nodo *copiaAux(Nodo *raiz) {
+		if (raiz == nullptr)
+			return nullptr;
+		Nodo *res = copiaNodo(raiz, nullptr);
+		Nodo *p = raiz, *q = res;
+		for (;;) {
+			if (p->iz != nullptr && q->iz == nullptr) {
+				q->iz = copiaNodo(p->iz, q);
+				p = p->iz;
+				q = q->iz;
+			} else if (p->dr != nullptr && q->dr == nullptr) {
+				q->dr = copiaNodo(p->dr, q);
+				p = p->dr;
+				q = q->dr;
+			} else if (p == raiz)
+				return res;
+			else {
+				p = p->padre;
+				q = q->padre;
+			}
+		}
+	}
+
+	/** Copia de n, todavía sin hijos, colgada de padre. O(1) */
+	Nodo *copiaNodo(Nodo *n, Nodo *padre) {
+		Nodo *c = asig().nuevo(n->clave, n->valor());
+		c->padre = padre;
+		c->altura = n->altura;
+		c->tam = n->tam;
+		return c;
+	}
+
+	/**
+	 * Crea (sin enlazarlos) un nodo por cada pareja del rango [ini, fin) y
+	 * los deja en "nodos" ordenados por clave y sin claves repetidas: de cada
+	 * clave repetida se queda el último.
+	 * O(n) si el rango está ordenado; O(n log n) si no.
+	 */
+	template <typename It>
+	void creaNodos(It ini, It fin, std::vector<Nodo*> &nodos) {
+		for (; ini != fin; ++ini)
+			nodos.push_back(asig().nuevo(nullptr, nullptr, ini->first, ini->second));
+		ordenaNodos(nodos);
+	}
+
+	/**
+	 * Ordena por clave los nodos (aún sin enlazar) y borra los que repiten
+	 * clave, quedándose con el último de cada clave. Si ya estaban ordenados
+	 * basta con comprobarlo. O(n) si están ordenados; O(n log n) si no.
+	 */
+	void ordenaNodos(std::vector<Nodo*> &nodos) {
+		bool ordenado = true;
+		for (std::size_t i = 1; i < nodos.size() && ordenado; ++i)
+			if (!cless(nodos[i - 1]->clave, nodos[i]->clave))
+				ordenado = false;
+		if (ordenado)
+			return;
+		// stable_sort mantiene las claves iguales en el orden en el que llegaron
+		std::stable_sort(nodos.begin(), nodos.end(), [this](Nodo *a, Nodo *b) {
+			return cless(a->clave, b->clave);
+		});
+		std::size_t k = 0; // nodos ya colocados en su sitio definitivo
+		for (std::size_t i = 0; i < nodos.size(); ++i) {
+			if (k > 0 && !cless(nodos[k - 1]->clave, nodos[i]->clave)) {
+				asig().borra(nodos[k - 1]); // la clave se repite: gana la última
+				nodos[k - 1] = nodos[i];
+			} else
+				nodos[k++] = nodos[i];
+		}
+		nodos.resize(k);
+	}
+
+	/**
+	 * Mezcla en orden los nodos del árbol con los nuevos (ordenados, sin
+	 * claves repetidas y sin enlazar) y enlaza el resultado. Si una clave ya
+	 * estaba, el nodo existente se queda con el valor del nuevo. O(n + m)
+	 */
+	void mezclaNodos(std::vector<Nodo*> &nuevos) {
+		std::vector<Nodo*> nodos;
+		nodos.reserve(numElems + nuevos.size());
+		Nodo *p = minimo(ra);
+		std::size_t j = 0;
+		while (p != nullptr || j < nuevos.size()) {
+			if (j == nuevos.size() || (p != nullptr && cless(p->clave, nuevos[j]->clave))) {
+				nodos.push_back(p);
+				p = siguiente(p);
+			} else if (p == nullptr || cless(nuevos[j]->clave, p->clave)) {
+				nodos.push_back(nuevos[j++]);
+			} else { // la clave ya estaba: se sustituye el valor
+				p->valor() = std::move(nuevos[j]->valor());
+				asig().borra(nuevos[j++]);
+				nodos.push_back(p);
+				p = siguiente(p);
+			}
+		}
+		enlaza(nodos);
+	}
+
+	/**
+	 * Hace que el árbol sean exactamente los nodos del vector (ordenados y
+	 * sin claves repetidas), enlazados como un árbol perfectamente equilibrado. O(n)
+	 */
+	void enlaza(std::vector<Nodo*> &nodos) {
+		ra = construye(nodos.data(), 0, (int) nodos.size(), nullptr);
+		numElems = (int) nodos.size();
+	}
+
+	/**
+	 * Enlaza los nodos[ini..fin), ordenados, como un árbol perfectamente
+	 * equilibrado cuya raíz (el nodo central) cuelga de padre, y la devuelve.
+	 * Todas las hojas quedan a la misma profundidad o a una de diferencia,
+	 * así que se cumple la condición de los AVL. O(fin - ini)
+	 */
+	static Nodo *construye(Nodo **nodos, int ini, int fin, Nodo *padre) {
+		if (ini >= fin)
+			return nullptr;
+		int m = ini + (fin - ini) / 2;
+		Nodo *p = nodos[m];
+		p->padre = padre;
+		p->iz = construye(nodos, ini, m, p);
+		p->dr = construye(nodos, m + 1, fin, p);
+		actualiza(p);
+		return p;
+	}
+
+	/**
+	 * Nodo con la primera clave mayor o igual que c (nullptr si no hay).
+	 * Al bajar, cada nodo que no es menor que c es candidato y se sigue por
+	 * su izquierda buscando uno más pequeño. O(log n)
+	 */
+	template <typename K>
+	Nodo *primeroNoMenor(const K &c) const {
+		Nodo *res = nullptr;
+		Nodo *p = ra;
+		while (p != nullptr) {
+			if (cless(p->clave, c)) // p->clave < c
+				p = p->dr;
+			else {
+				res = p;
+				p = p->iz;
+			}
+		}
+		return res;
+	}
+
+	/** Nodo con la primera clave estrictamente mayor que c (nullptr si no hay). O(log n) */
+	template <typename K>
+	Nodo *primeroMayor(const K &c) const {
+		Nodo *res = nullptr;
+		Nodo *p = ra;
+		while (p != nullptr) {
+			if (cless(c, p->clave)) { // c < p->clave
+				res = p;
+				p = p->iz;
+			} else
+				p = p->dr;
+		}
+		return res;
+	}
+
+	/** Nodo con la última clave menor o igual que c (nullptr si no hay). O(log n) */
+	template <typename K>
+	Nodo *ultimoNoMayor(const K &c) const {
+		Nodo *res = nullptr;
+		Nodo *p = ra;
+		while (p != nullptr) {
+			if (cless(c, p->clave)) // c < p->clave
+				p = p->iz;
+			else {
+				res = p;
+				p = p->dr;
+			}
+		}
+		return res;
+	}
+
+	/** Primer nodo en inorden (el menor) de la estructura que cuelga de p. O(log n) */
+	static Nodo *minimo(Nodo *p) {
+		if (p != nullptr)
+			while (p->iz != nullptr)
+				p = p->iz;
+		return p;
+	}
+
+	/** Último nodo en inorden (el mayor) de la estructura que cuelga de p. O(log n) */
+	static Nodo *maximo(Nodo *p) {
+		if (p != nullptr)
+			while (p->dr != nullptr)
+				p = p->dr;
+		return p;
+	}
+
+	/**
+	 * Siguiente nodo en inorden: el menor del hijo derecho o, si no hay hijo
+	 * derecho, el primer ascendiente del que se cuelga por la izquierda.
+	 * Devuelve nullptr si p es el último.
+	 * O(1) amortizado en un recorrido completo (O(log n) en el caso peor)
+	 */
+	static Nodo *siguiente(Nodo *p) {
+		if (p->dr != nullptr)
+			return minimo(p->dr);
+		while (p->padre != nullptr && p == p->padre->dr)
+			p = p->padre;
+		return p->padre;
+	}
+
+	/**
+	 * Anterior nodo en inorden (simétrico a siguiente).
+	 * Devuelve nullptr si p es el primero.
+	 * O(1) amortizado en un recorrido completo (O(log n) en el caso peor)
+	 */
+	static Nodo *anterior(Nodo *p) {
+		if (p->iz != nullptr)
+			return maximo(p->iz);
+		while (p->padre != nullptr && p == p->padre->iz)
+			p = p->padre;
+		return p->padre;
+	}
+
+    /**
+     * Busca un elemento en la estructura de nodos cuya raíz se pasa como parámetro.
+     * Devuelve un puntero al nodo si lo encuentra (o nullptr si no está).
+     * O(log n)
+     */
+	template <typename K>
+	Nodo *buscaAux(Nodo *p, const K &clave) const {
+		if (p == nullptr)
+			return nullptr;
+        if (cless(clave, p->clave)) //clave < p->clave
+            return buscaAux(p->iz, clave);
+        else if (cless(p->clave, clave)) //clave > p->clave
+            return buscaAux(p->dr, clave);
+		else // clave == p->clave
+			return p;
+	}
+
+
+	/**
+	 * Busca la clave y, si no está, la añade en un nodo nuevo (una hoja) cuyo
+	 * valor se construye con args (sin args, el valor por defecto). Devuelve el
+	 * nodo con la clave y deja en "insertado" si era nueva. Si no era nueva no
+	 * se usa ninguno de los argumentos, así que se pueden volver a usar.
+	 * Se baja por el árbol una sola vez y luego se reequilibra subiendo por
+	 * los punteros al padre.
+	 * O(log n)
+	 */
+	template <typename C, typename... Args>
+	Nodo *buscaOInserta(C &&clave, bool &insertado, Args&&... args) {
+		Nodo **p = &ra;
+		Nodo *padre = nullptr;
+		while (*p != nullptr) {
+			padre = *p;
+			if (cless(clave, (*p)->clave)) // clave < (*p)->clave
+				p = &(*p)->iz;
+			else if (cless((*p)->clave, clave)) // clave > (*p)->clave
+				p = &(*p)->dr;
+			else { // (*p)->clave == clave. La clave aparecía
+				insertado = false;
+				return *p;
+			}
+		}
+		// La clave es nueva
+		insertado = true;
+		Nodo *nuevo = asig().nuevo(nullptr, nullptr, std::forward<C>(clave), std::forward<Args>(args)...);
+		nuevo->padre = padre;
+		*p = nuevo;
+		++numElems;
+		// Reequilibramos los ascendientes de abajo a arriba (las rotaciones no
+		// mueven los nodos, así que nuevo sigue siendo válido).
+		reequilibraDesde(padre);
+		return nuevo;
+	}
+
+	/**
+	 * Quita del árbol el nodo "borrar" y lo destruye. Si tiene dos hijos, su
+	 * lugar lo ocupa el mínimo del hijo derecho (se mueve el nodo, no la
+	 * pareja, así que los demás nodos siguen siendo válidos). Después se
+	 * reequilibra subiendo por los punteros al padre desde el nodo más bajo
+	 * cuyo subárbol ha cambiado, así que no hace falta haber bajado desde la raíz.
+	 * O(log n)
+	 */
+	void borraNodo(Nodo *borrar) {
+		Nodo **enlace = enlaceA(borrar);
+		Nodo *desde; // el nodo más bajo cuyo subárbol ha cambiado
+		if (borrar->iz == nullptr || borrar->dr == nullptr) {
+			// Con un hijo (o ninguno), el hijo ocupa su lugar
+			Nodo *hijo = borrar->iz != nullptr ? borrar->iz : borrar->dr;
+			if (hijo != nullptr)
+				hijo->padre = borrar->padre;
+			*enlace = hijo;
+			desde = borrar->padre;
+		} else {
+			// Con dos hijos, buscamos el mínimo del hijo derecho
+			Nodo *m = minimo(borrar->dr);
+			if (m == borrar->dr) // m conserva su hijo derecho
+				desde = m;
+			else {
+				desde = m->padre;
+				m->padre->iz = m->dr; // sacamos el mínimo de donde estaba
+				if (m->dr != nullptr)
+					m->dr->padre = m->padre;
+				m->dr = borrar->dr;
+				m->dr->padre = m;
+			}
+			m->iz = borrar->iz;
+			m->iz->padre = m;
+			m->padre = borrar->padre;
+			*enlace = m; // y lo ponemos en el lugar del nodo borrado
+		}
+		asig().borra(borrar);
+		numElems--;
+		reequilibraDesde(desde);
+	}
+
+	/** Puntero (la raíz o un hijo de su padre) que apunta a p. O(1) */
+	Nodo **enlaceA(Nodo *p) {
+		if (p->padre == nullptr)
+			return &ra;
+		return p->padre->iz == p ? &p->padre->iz : &p->padre->dr;
+	}
+
+	/**
+	 * Reequilibra p y todos sus ascendientes, de abajo a arriba, subiendo por
+	 * los punteros al padre. O(log n)
+	 */
+	void reequilibraDesde(Nodo *p) {
+		while (p != nullptr) {
+			Nodo *padre = p->padre;
+			Nodo **enlace = enlaceA(p);
+			*enlace = reequilibra(p);
+			p = padre;
+		}
+	}
+
+	/**
+	 * Une los árboles iz y dr con el nodo suelto k entre ellos: las claves de
+	 * iz son menores que la de k y las de dr mayores. Si un árbol es más alto
+	 * que el otro en más de 1, se baja por su borde interior hasta un
+	 * subárbol de la altura del otro y se reequilibra al volver. Devuelve la
+	 * raíz del resultado.
+	 * O(|altura(iz) - altura(dr)| + 1)
+	 */
+	static Nodo *une(Nodo *iz, Nodo *k, Nodo *dr) {
+		if (altura(iz) > altura(dr) + 1) {
+			iz->dr = une(iz->dr, k, dr);
+			iz->dr->padre = iz;
+			return reequilibra(iz);
+		}
+		if (altura(dr) > altura(iz) + 1) {
+			dr->iz = une(iz, k, dr->iz);
+			dr->iz->padre = dr;
+			return reequilibra(dr);
+		}
+		k->iz = iz;
+		k->dr = dr;
+		k->padre = nullptr;
+		if (iz != nullptr)
+			iz->padre = k;
+		if (dr != nullptr)
+			dr->padre = k;
+		actualiza(k);
+		return k;
+	}
+
+	/**
+	 * Quita el menor nodo del árbol p (que no puede ser vacío), lo deja en
+	 * "menor" y devuelve la raíz de lo que queda, ya reequilibrado. O(log n)
+	 */
+	static Nodo *quitaMinimo(Nodo *p, Nodo *&menor) {
+		if (p->iz == nullptr) {
+			menor = p;
+			if (p->dr != nullptr)
+				p->dr->padre = p->padre;
+			return p->dr;
+		}
+		p->iz = quitaMinimo(p->iz, menor);
+		if (p->iz != nullptr)
+			p->iz->padre = p;
+		return reequilibra(p);
+	}
+
+	/**
+	 * Parte el árbol p en los árboles con las claves menores que c y con las
+	 * mayores o iguales. Cada nodo del camino de búsqueda se une, con une, a
+	 * los trozos que le quedan a su lado; las alturas de los trozos crecen a
+	 * medida que se sube, así que el coste total es el de la bajada.
+	 * O(log n)
+	 */
+	void parte(Nodo *p, const Clave &c, Nodo *&menores, Nodo *&mayores) const {
+		if (p == nullptr) {
+			menores = mayores = nullptr;
+			return;
+		}
+		Nodo *iz = p->iz, *dr = p->dr;
+		if (iz != nullptr)
+			iz->padre = nullptr;
+		if (dr != nullptr)
+			dr->padre = nullptr;
+		Nodo *medio;
+		if (cless(p->clave, c)) { // p y su hijo izquierdo van a menores
+			parte(dr, c, medio, mayores);
+			menores = une(iz, p, medio);
+		} else {
+			parte(iz, c, menores, medio);
+			mayores = une(medio, p, dr);
+		}
+	}
+
+	/** Número de nodos de la estructura que cuelga de p (0 si es vacía). O(1) */
+	static int tamSubarbol(Nodo *p) {
+		return p == nullptr ? 0 : p->tam;
+	}
+
+	/** Nodo con la k-ésima clave más pequeña, contando desde 0 (nullptr si no existe). O(log n) */
+	Nodo *seleccion(int k) const {
+		Nodo *p = ra;
+		while (p != nullptr) {
+			int iz = tamSubarbol(p->iz);
+			if (k < iz)
+				p = p->iz;
+			else if (k == iz)
+				return p;
+			else {
+				k -= iz + 1;
+				p = p->dr;
+			}
+		}
+		return nullptr;
+	}
+
+	/** Altura de un subárbol (0 si es vacío). O(1) */
+	static int altura(Nodo *p) {
+		return p == nullptr ? 0 : p->altura;
+	}
+
+	/** Recalcula la altura y el tamaño de un nodo a partir de los de sus hijos. O(1) */
+	static void actualiza(Nodo *p) {
+		int iz = altura(p->iz), dr = altura(p->dr);
+		p->altura = 1 + (iz > dr ? iz : dr);
+		p->tam = 1 + tamSubarbol(p->iz) + tamSubarbol(p->dr);
+	}
+
+	/**
+	 * Rotación a la derecha: el hijo izquierdo de p pasa a ser la raíz del
+	 * subárbol, que se devuelve. O(1)
+	 */
+	static Nodo *rotaDerecha(Nodo *p) {
+		Nodo *iz = p->iz;
+		p->iz = iz->dr;
+		if (p->iz != nullptr)
+			p->iz->padre = p;
+		iz->dr = p;
+		iz->padre = p->padre;
+		p->padre = iz;
+		actualiza(p);
+		actualiza(iz);
+		return iz;
+	}
+
+	/**
+	 * Rotación a la izquierda: el hijo derecho de p pasa a ser la raíz del
+	 * subárbol, que se devuelve. O(1)
+	 */
+	static Nodo *rotaIzquierda(Nodo *p) {
+		Nodo *dr = p->dr;
+		p->dr = dr->iz;
+		if (p->dr != nullptr)
+			p->dr->padre = p;
+		dr->iz = p;
+		dr->padre = p->padre;
+		p->padre = dr;
+		actualiza(p);
+		actualiza(dr);
+		return dr;
+	}
+
+	/**
+	 * Actualiza la altura (y el tamaño) de p y, si las alturas de sus hijos difieren en 2,
+	 * hace la rotación simple o doble que corresponda. Devuelve la nueva raíz
+	 * del subárbol. O(1)
+	 */
+	static Nodo *reequilibra(Nodo *p) {
+		actualiza(p);
+		int factor = altura(p->iz) - altura(p->dr);
+		if (factor > 1) { // demasiado alto por la izquierda
+			if (altura(p->iz->iz) < altura(p->iz->dr))
+				p->iz = rotaIzquierda(p->iz);
+			return rotaDerecha(p);
+		} else if (factor < -1) { // demasiado alto por la derecha
+			if (altura(p->dr->dr) < altura(p->dr->iz))
+				p->dr = rotaDerecha(p->dr);
+			return rotaIzquierda(p);
+		}
+		return p;
+	}
+
+    /**
+     * Método para dibujar el diccionario.
+     * Usado únicamente para debuguear.
+     */
+    static void muestra(Nodo *n, std::ostream &out) {
+        if (n != nullptr) {
+            if (n->iz != nullptr) {
+                muestra(n->iz, out);
+                out << ", ";
+            }
+            out << n->clave << " -> " << n->valor();
+            if (n->dr != nullptr) {
+                out << ", ";
+                muestra(n->dr, out);
+            }
+        }
+    }
+
+	/**
+	 * Indica si al liberar el árbol basta con que el asignador libere toda su
+	 * memoria de golpe (sin recorrer los nodos ni destruirlos).
+	 */
+	static const bool LIBERA_EN_BLOQUE =
+			Asignador<Nodo>::LIBERA_EN_BLOQUE && std::is_trivially_destructible<Nodo>::value;
+
+	/**
+	 * Indica si un diccionario puede borrar los nodos creados por otro, lo que
+	 * sólo pasa si el asignador no tiene estado (como NewAllocator).
+	 */
+	static const bool NODOS_COMPARTIDOS = std::is_empty<Asignador<Nodo>>::value;
+
+	/** Comparador: menor estricto. */
+	template <typename A, typename B>
+	bool cless(const A &a, const B &b) const {
+		return comparador()(a, b);
+	}
+
+	Comparador &comparador() {
+		return BaseComparador::get();
+	}
+
+	const Comparador &comparador() const {
+		return BaseComparador::get();
+	}
+
+	/** Asignador que crea y destruye los nodos */
+	Asignador<Nodo> &asig() {
+		return BaseAsignador::get();
+	}
+
+	/** Puntero a la raíz de la estructura jerárquica de nodos. */
+	Nodo *ra;
+
+    /** número de elementos en el conjunto */
+    int numElems;
+};
+
+#endif // __TREEMAP_H
@@ -8,13 +8,32 @@
 #define __TREESETC_H
 
 #include "Exceptions.h"
-#include "Stack.h" // Usado internamente por los iteradores
+#include "TreeMap.h"
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <utility>
+#include <vector>
 
 /**
- * Implementación dinámica del TAD Set utilizando árboles de búsqueda (no auto-balanceados).
+ * Valor que se guarda junto a cada elemento en el TreeMap sobre el que se
+ * construye TreeSetC. Es una clase vacía, así que no ocupa memoria en los nodos.
+ */
+class SinValor {};
+
+/**
+ * Implementación dinámica del TAD Set utilizando árboles de búsqueda auto-balanceados (AVL).
+ * Un conjunto es un diccionario (TreeMap) en el que cada elemento es una clave y el
+ *          valor es una clase vacía (SinValor), que no ocupa memoria en los nodos.
+ *          Así los nodos, el equilibrado, los iteradores y todas las búsquedas son
+ *          los de TreeMap y sólo hay un código que mantener.
  * Se añade un comparador: objeto función que acepta dos valores de tipo T y devuelve si el
  *          primero es menor que el segundo. Por defecto se toma el < T si está definido
+ *          Si el comparador no tiene estado (como std::less) tampoco ocupa memoria y
+ *          sus llamadas se pueden expandir en línea.
  * Como no necesitamos compartir subestructuras no es necesario usar punteros inteligentes
+ * Cada nodo guarda un puntero a su padre, así los iteradores son sólo un puntero al
+ *          nodo actual y pueden avanzar y retroceder sin memoria adicional.
  * Las operaciones son:
  *    - TreeSetVacio: operación generadora que construye un conjunto vacío (árbol de búsqueda vacío).
  *    - Insert(elem): generadora que añade un nuevo elem al conjunto. Si elem ya estaba no se hace nada.
@@ -22,43 +41,61 @@
  *    - contains(elem): operación observadora. Determina si elem pertenece conjunto.
  *    - empty(): operación observadora que indica si el conjunto es vacío.
  *    - size(): operación observadora que devuelve el tamaño del conjunto
+ * Para consultas ordenadas están lower_bound, upper_bound, equal_range, floor,
+ * ceiling y range(lo, hi), que permite recorrer los elementos de [lo, hi) en O(log n + k).
+ * Cada nodo guarda además el número de nodos de su subárbol, con lo que select(k),
+ * rank(elem) y count_range(lo, hi) son O(log n).
+ * Un conjunto se puede construir de golpe a partir de un rango de elementos y,
+ * si el rango viene ordenado, el árbol (perfectamente equilibrado) se construye
+ * en O(n); insert_sorted mezcla un rango así con un conjunto ya existente.
+ * union_with, intersect_with, difference_with e is_subset_of recorren los dos
+ * conjuntos a la vez, en orden, y son O(n + m).
+ * split(elem) parte el conjunto en dos por un elemento y join une dos conjuntos
+ * cuyos elementos no se solapan, ambos en O(log n).
  */
-
 template <class T, class Comparador = std::less<T>>
-class TreeSetC {
+class TreeSetC : private TreeMap<T, SinValor, Comparador> {
 private:
-	/**
-	 Clase nodo que almacena internamente el dato
-	 y los punteros al hijo izquierdo y al hijo derecho.
-	 */
-	class Nodo {
-	public:
-		Nodo() : iz(nullptr), dr(nullptr) {}
-		Nodo(const T &elem)
-			: elem(elem), iz(nullptr), dr(nullptr) {}
-		Nodo(Nodo *iz, const T &elem, Nodo *dr)
-			: elem(elem), iz(iz), dr(dr) {}
-
-		T elem;
-		Nodo *iz;
-		Nodo *dr;
-	};
+	/** Diccionario sobre el que se construye el conjunto. */
+	using Mapa = TreeMap<T, SinValor, Comparador>;
+
+	/** Los nodos son los del diccionario; el elemento es la clave. */
+	using Nodo = typename Mapa::Nodo;
+
+	using Mapa::ra;
+	using Mapa::cless;
+	using Mapa::asig;
+	using Mapa::minimo;
+	using Mapa::maximo;
+	using Mapa::siguiente;
+	using Mapa::anterior;
+	using Mapa::buscaAux;
+	using Mapa::primeroNoMenor;
+	using Mapa::primeroMayor;
+	using Mapa::ultimoNoMayor;
+	using Mapa::seleccion;
 
 public:
 
 	/** Constructor; operacion EmptyTreeSet. O(1) */
-	TreeSetC() : ra(nullptr) { numElems = 0;}
+	TreeSetC() {}
 
-	/** Destructor; elimina la estructura jerárquica de nodos. O(n) */
-	~TreeSetC() {
-		libera();
-        ra = nullptr;
-        numElems = 0;
+	/**
+	 * Constructor a partir de un rango [ini, fin) de elementos. Los repetidos
+	 * se añaden una sola vez. Los nodos se crean en una sola pasada y después
+	 * se enlazan formando un árbol perfectamente equilibrado.
+	 * O(n) si el rango está ordenado; O(n log n) si no lo está.
+	 */
+	template <typename It>
+	TreeSetC(It ini, It fin) {
+		std::vector<Nodo*> nodos;
+		creaNodos(ini, fin, nodos);
+		this->enlaza(nodos);
 	}
 
 	/** Operación generadora que añade un nuevo elemento al conjunto. O(log n) */
 	void insert(const T &elem) {
-        ra = insertaAux(elem, ra);
+		Mapa::try_emplace(elem);
 	}
 
 	/**
@@ -67,22 +104,36 @@ public:
 	 * O(log n)
 	 */
 	void erase(const T &elem) {
-        ra = borraAux(ra, elem);
+		Mapa::erase(elem);
+	}
+
+	/**
+	 * Añade todos los elementos del rango [ini, fin), que debería estar
+	 * ordenado. En vez de bajar desde la raíz por cada elemento, se mezclan en
+	 * orden los nodos del árbol con los nuevos y se vuelve a enlazar todo como
+	 * un árbol perfectamente equilibrado.
+	 * O(n + m) siendo m el tamaño del rango (O(n + m log m) si no está ordenado).
+	 */
+	template <typename It>
+	void insert_sorted(It ini, It fin) {
+		std::vector<Nodo*> nuevos;
+		creaNodos(ini, fin, nuevos);
+		this->mezclaNodos(nuevos);
 	}
 
-	/** Operación observadora que comprueba si elem pertenece al conjunto.*/
+	/** Operación observadora que comprueba si elem pertenece al conjunto. O(log n) */
 	bool contains(const T &elem) const {
-		return (buscaAux(ra, elem) != nullptr) ? true : false;
+		return Mapa::contains(elem);
 	}
 
 	/** Operación observadora que comprueba si el conjunto es vacío. */
 	bool empty() const {
-		return ra == nullptr;
+		return Mapa::empty();
 	}
 
     /** Operación observadora que que indica el tamaño del conjunto. */
     int size() const{
-        return numElems;
+        return Mapa::size();
     }
 
     /** Dibujo del árbol: Uso únicamente para debugear durante clase */
@@ -100,33 +151,34 @@ public:
 
 	/** Clase interna que implementa un iterador que permite
 	 * recorrer el árbol pero no  modificarlo.
+	 * Basta con el puntero al nodo actual: como cada nodo conoce a su padre,
+	 * se puede avanzar y retroceder sin guardar los ascendientes.
 	 */
 	class ConstIterator {
 	public:
 		ConstIterator() : act(nullptr) {}
 
-        /** O(log n) */
+        /** Avanza al siguiente en inorden. O(1) amortizado (O(log n) en el caso peor) */
 		void next() {
 			if (act == nullptr)
                 throw InvalidAccessException();
-			// Si hay hijo derecho, saltamos al primero en inorden del hijo derecho
-			if (act->dr != nullptr)
-                act = primeroInOrden(act->dr);
-			else {
-				// Si no, vamos al primer ascendiente no visitado
-				if (ascendientes.empty()) //Ya no hay por visitar
-                    act = nullptr;
-				else {
-                    act = ascendientes.top();
-					ascendientes.pop();
-				}
-			}
+			act = siguiente(act);
+		}
+
+        /**
+         * Retrocede al anterior en inorden. Desde el primero se pasa al final.
+         * O(1) amortizado (O(log n) en el caso peor)
+         */
+		void prev() {
+			if (act == nullptr)
+                throw InvalidAccessException();
+			act = anterior(act);
 		}
 
 		const T &elem() const {
 			if (act == nullptr)
                 throw InvalidAccessException();
-			return act->elem;
+			return act->clave;
 		}
 
 		const T& operator*() const {
@@ -141,45 +193,39 @@ public:
 			return !(this->operator==(other));
 		}
 
-        /** O(log n) */
+        /** O(1) amortizado */
 		ConstIterator &operator++() {
 			next();
 			return *this;
 		}
 
-        /** O(log n) */
+        /** O(1) amortizado */
 		ConstIterator operator++(int) {
 			ConstIterator ret(*this);
 			operator++();
 			return ret;
 		}
 
-	protected:
-		friend class TreeSetC;
-
-		ConstIterator(Nodo *act) {
-            this->act = primeroInOrden(act);
+        /** O(1) amortizado */
+		ConstIterator &operator--() {
+			prev();
+			return *this;
 		}
 
-		/**
-		 *  Busca el primer elemento en inorden de la estructura jerárquica de nodos.
-		 *  Va apilando sus ascendientes para poder "ir hacia atrás" cuando sea necesario.
-		 */
-		Nodo *primeroInOrden(Nodo *p) {
-			if (p == nullptr)
-				return nullptr;
-			while (p->iz != nullptr) {
-				ascendientes.push(p);
-				p = p->iz;
-			}
-			return p;
+        /** O(1) amortizado */
+		ConstIterator operator--(int) {
+			ConstIterator ret(*this);
+			operator--();
+			return ret;
 		}
 
+	protected:
+		friend class TreeSetC;
+
+		ConstIterator(Nodo *act) : act(act) {}
+
         /** Puntero al nodo actual del recorrido */
 		Nodo *act;
-
-		/** Ascendientes del nodo actual aún por visitar */
-		Stack<Nodo*> ascendientes;
 	};
 
 	/**
@@ -188,7 +234,7 @@ public:
 	 * O(log n)
 	 */
 	ConstIterator cbegin() const {
-		return ConstIterator(ra);
+		return ConstIterator(minimo(ra));
 	}
 
 	/** Devuelve un iterador constante al final del recorrido (fuera de éste). O(1) */
@@ -196,26 +242,22 @@ public:
 		return ConstIterator(nullptr);
 	}
 
+	/**
+	 * Devuelve el iterador constante al último elemento del recorrido inorden
+	 * (el más grande), para recorrer el conjunto hacia atrás con --.
+	 * O(log n)
+	 */
+	ConstIterator clast() const {
+		return ConstIterator(maximo(ra));
+	}
+
     /**
      * Devuelve un iterador constante al nodo con elemento c.
      * Usa el comparador
      * Devuelve el iterador cend si no está
      */
 	ConstIterator find(const T &c) const {
-		Stack<Nodo*> ascendientes;
-		Nodo *p = ra;
-		while ((p != nullptr) && cless(p->elem, c) && cless(c, p->elem)) {
-			if (cless(c, p->elem)){
-				ascendientes.push(p);
-				p = p->iz;
-			} else
-				p = p->dr;
-		}
-		ConstIterator ret;
-		ret.act = p;
-		if (p != nullptr)
-			ret.ascendientes = ascendientes;
-		return ret;
+		return ConstIterator(buscaAux(ra, c));
 	}
 
 	// //
@@ -231,28 +273,27 @@ public:
 	public:
 		Iterator() : act(nullptr) {}
 
-        /** O(log n) */
+        /** Avanza al siguiente en inorden. O(1) amortizado (O(log n) en el caso peor) */
         void next() {
             if (act == nullptr)
                 throw InvalidAccessException();
-            // Si hay hijo derecho, saltamos al primero en inorden del hijo derecho
-            if (act->dr != nullptr)
-                act = primeroInOrden(act->dr);
-            else {
-                // Si no, vamos al primer ascendiente no visitado
-                if (ascendientes.empty()) //Ya no hay por visitar
-                    act = nullptr;
-                else {
-                    act = ascendientes.top();
-                    ascendientes.pop();
-                }
-            }
+            act = siguiente(act);
+        }
+
+        /**
+         * Retrocede al anterior en inorden. Desde el primero se pasa al final.
+         * O(1) amortizado (O(log n) en el caso peor)
+         */
+        void prev() {
+            if (act == nullptr)
+                throw InvalidAccessException();
+            act = anterior(act);
         }
 
 		const T &elem() const {
 			if (act == nullptr)
                 throw InvalidAccessException();
-			return act->elem;
+			return act->clave;
 		}
 
 		const T& operator*() const {
@@ -267,46 +308,39 @@ public:
 			return !(this->operator==(other));
 		}
 
-        /** O(log n) */
+        /** O(1) amortizado */
 		Iterator &operator++() {
 			next();
 			return *this;
 		}
 
-        /** O(log n) */
+        /** O(1) amortizado */
 		Iterator operator++(int) {
 			Iterator ret(*this);
 			operator++();
 			return ret;
 		}
 
+        /** O(1) amortizado */
+		Iterator &operator--() {
+			prev();
+			return *this;
+		}
+
+        /** O(1) amortizado */
+		Iterator operator--(int) {
+			Iterator ret(*this);
+			operator--();
+			return ret;
+		}
+
 	protected:
 		friend class TreeSetC;
 
-		Iterator(Nodo *act) {
-            this->act = primeroInOrden(act);
-		}
+		Iterator(Nodo *act) : act(act) {}
 
-        /**
-         *  Busca el primer elemento en inorden de la estructura jerárquica de nodos.
-         *  Va apilando sus ascendientes para poder "ir hacia atrás" cuando sea necesario.
-         *  O(log n)
-         */
-		Nodo *primeroInOrden(Nodo *p) {
-			if (p == nullptr)
-				return nullptr;
-
-			while (p->iz != nullptr) {
-				ascendientes.push(p);
-				p = p->iz;
-			}
-			return p;
-		}
         /** Puntero al nodo actual del recorrido */
         Nodo *act;
-
-        /** Ascendientes del nodo actual aún por visitar */
-        Stack<Nodo*> ascendientes;
 	};
 
     /**
@@ -315,7 +349,7 @@ public:
      * O(log n)
      */
 	Iterator begin() {
-		return Iterator(ra);
+		return Iterator(minimo(ra));
 	}
 
     /** Devuelve un iterador constante al final del recorrido (fuera de éste). O(1) */
@@ -323,6 +357,15 @@ public:
 		return Iterator(nullptr);
     }
 
+    /**
+     * Devuelve el iterador al último elemento del recorrido inorden (el más
+     * grande), para recorrer el conjunto hacia atrás con --.
+     * O(log n)
+     */
+	Iterator last() {
+		return Iterator(maximo(ra));
+	}
+
     /**
      * Devuelve un iterador constante al nodo con elemento c.
      * Usa el comparador
@@ -330,212 +373,204 @@ public:
      * O(log n)
      */
 	Iterator find(const T &c) {
-		Stack<Nodo*> ascendientes;
-		Nodo *p = ra;
-		while ((p != nullptr) && cless(p->elem, c) && cless(c, p->elem)) {
-			if (cless(c, p->elem)) {
-				ascendientes.push(p);
-				p = p->iz;
-			} else
-				p = p->dr;
-		}
-		Iterator ret;
-		ret.act = p;
-		if (p != nullptr)
-			ret.ascendientes = ascendientes;
-		return ret;
+		return Iterator(buscaAux(ra, c));
 	}
 
 
 	// //
-	// MÉTODOS DE "FONTANERÍA" DE C++ QUE HACEN VERSÁTIL  A LA CLASE
+	// BÚSQUEDAS POR RANGO Y NAVEGACIÓN ORDENADA
 	// //
 
-	/** Constructor copia. O(n) */
-	TreeSetC(const TreeSetC<T, Comparador> &other) : ra(nullptr) {
-		copia(other);
+	/**
+	 * Devuelve un iterador constante al primer elemento mayor o igual que c
+	 * (cend si no hay ninguna). O(log n)
+	 */
+	ConstIterator lower_bound(const T &c) const {
+		return ConstIterator(primeroNoMenor(c));
 	}
 
-	/** Operador de asignación. O(n) */
-	TreeSetC<T, Comparador> &operator=(const TreeSetC<T, Comparador> &other) {
-		if (this != &other) {
-			libera();
-			copia(other);
-		}
-		return *this;
+	/**
+	 * Devuelve un iterador constante al primer elemento estrictamente mayor
+	 * que c (cend si no hay ninguna). O(log n)
+	 */
+	ConstIterator upper_bound(const T &c) const {
+		return ConstIterator(primeroMayor(c));
 	}
 
-protected:
-
-	void libera() {
-		libera(ra);
+	/**
+	 * Devuelve el par (lower_bound(c), upper_bound(c)): el rango de los
+	 * elementos equivalentes a c, que es vacío si c no está. O(log n)
+	 */
+	std::pair<ConstIterator, ConstIterator> equal_range(const T &c) const {
+		return std::make_pair(lower_bound(c), upper_bound(c));
 	}
 
-	void copia(const TreeSetC &other) {
-        ra = copiaAux(other.ra);
-        numElems = other.numElems;
+	/**
+	 * Devuelve un iterador constante al mayor elemento menor o igual que c
+	 * (cend si no hay ninguna). O(log n)
+	 */
+	ConstIterator floor(const T &c) const {
+		return ConstIterator(ultimoNoMayor(c));
 	}
 
-private:
-    /** para el dibujo del árbol */
-    static const int TREE_INDENTATION = 4;
+	/**
+	 * Devuelve un iterador constante al menor elemento mayor o igual que c
+	 * (cend si no hay ninguna). Es lo mismo que lower_bound. O(log n)
+	 */
+	ConstIterator ceiling(const T &c) const {
+		return ConstIterator(primeroNoMenor(c));
+	}
 
 	/**
-	 * Elimina todos los nodos de una estructura arbórea que comienza con el puntero ra.
-	 * O(n)
+	 * Rango de un recorrido: un par de iteradores [ini, fin) que se puede
+	 * recorrer con un bucle for, sin copiar ningún elemento.
 	 */
-	static void libera(Nodo *ra) {
-		if (ra != nullptr) {
-			libera(ra->iz);
-			libera(ra->dr);
-			delete ra;
+	template <typename It>
+	class Range {
+	public:
+		/** Iterador al primer elemento del rango. O(1) */
+		It begin() const {
+			return ini;
 		}
+
+		/** Iterador a la posición siguiente al último elemento del rango. O(1) */
+		It end() const {
+			return fin;
+		}
+
+		/** Indica si el rango no tiene ningún elemento. O(1) */
+		bool empty() const {
+			return ini == fin;
+		}
+
+	protected:
+		friend class TreeSetC;
+
+		Range(It ini, It fin) : ini(ini), fin(fin) {}
+
+		It ini;
+		It fin;
+	};
+
+	/**
+	 * Devuelve el rango con los elementos del intervalo [lo, hi). No se recorre nada
+	 * al crearlo: sólo se localizan sus extremos y después se avanza en inorden,
+	 * así que recorrer el rango cuesta O(log n + k), siendo k su número de elementos.
+	 * Si hi no es mayor que lo el rango es vacío.
+	 */
+	Range<ConstIterator> range(const T &lo, const T &hi) const {
+		if (!cless(lo, hi))
+			return Range<ConstIterator>(cend(), cend());
+		return Range<ConstIterator>(lower_bound(lo), lower_bound(hi));
 	}
 
+
+	// //
+	// ESTADÍSTICOS DE ORDEN
+	// //
+
 	/**
-	 * Copia la estructura jerárquica de nodos pasada como parámetro (puntero a su raiz).
-	 * Devuelve un puntero a una nueva estructura jerárquica, copia de la anterior
-	 * O(n)
+	 * Devuelve un iterador constante al k-ésimo elemento más pequeño, contando
+	 * desde 0 (cend si k no está entre 0 y size() - 1).
+	 * Cada nodo sabe cuántos nodos cuelgan de él, así que basta con bajar
+	 * una vez desde la raíz. O(log n)
 	 */
-	static Nodo* copiaAux(Nodo *raiz) {
-		if (raiz == nullptr)
-			return nullptr;
-		return new Nodo(copiaAux(raiz->iz), raiz->elem, copiaAux(raiz->dr));
+	ConstIterator select(int k) const {
+		return ConstIterator(seleccion(k));
 	}
 
 	/**
-	 * Inserta un elem en la estructura jerárquica que comienza ebn el puntero pasado como parámetro.
-	 * Usa el comparador.
-	 * EL puntero puede ser nullptr, por lo que se creará un nuevo nodo (la nueva raíz).
-	 * El método devuelve un puntero a la raíz de la estructura modificada.
-	 * En condiciones normales coincidirá con el parámetro redibido; sólo cambiará cuando era vacía.
-	 * O(log n)
+	 * Devuelve cuántos elementos del conjunto son estrictamente menores que c
+	 * (la posición que ocupa, o que ocuparía, c en el recorrido inorden). O(log n)
 	 */
-    Nodo* insertaAux(const T &elem, Nodo *p) {
-        if (p == nullptr) {
-            ++numElems; //hay un nuevo elemento
-            return new Nodo(elem);
-        }
-        else if (cless(elem, p->elem)) { // (elem < p->elem)
-            p->iz = insertaAux(elem, p->iz);
-            return p;
-        } else if (cless(p->elem, elem)) { // (p-> elem < elem)
-            p->dr = insertaAux(elem, p->dr);
-            return p;
-        } else // (elem === p->elem)
-            return p;
-    }
+	int rank(const T &c) const {
+		return Mapa::rank(c);
+	}
 
+	/** Devuelve cuántos elementos hay en el intervalo [lo, hi). O(log n) */
+	int count_range(const T &lo, const T &hi) const {
+		return Mapa::count_range(lo, hi);
+	}
 
-    /**
-	 * Busca un elemento en la estructura de nodos cuya raíz se pasa como parámetro.
-     * Usa el comparador.
-	 * Devuelve un puntero al nodo si lo encuentra (o nullptr si no está).
-	 * O(log n)
+
+	// //
+	// OPERACIONES ENTRE CONJUNTOS
+	// //
+
+	/*
+	 * Son las de TreeMap, que mezclan los dos recorridos en inorden y vuelven
+	 * a enlazar el resultado como un árbol perfectamente equilibrado.
 	 */
-	Nodo* buscaAux(Nodo *p, const T &elem) const {
-		if (p == nullptr)
-			return nullptr;
-        else if (cless(elem, p->elem))  // (elem < p->elem)
-            return buscaAux(p->iz, elem);
-         else if (cless(p->elem, elem)) // (p-> elem < elem)
-            return buscaAux(p->dr, elem);
-         else  // (elem === p->elem)
-            return p;
+
+	/** Añade al conjunto los elementos de other. O(n + m) */
+	void union_with(const TreeSetC &other) {
+		Mapa::union_with(other);
 	}
 
-	/**
-	 * Elimina (si existe) un elemento de la estructura de nodos apuntada por p.
-	 * Usa el comparador
-	 * Si el elemento estaba en la propia raíz, éste cambiará. Si no cambia se devuelve p.
-	 * O(log n)
-	*/
-	Nodo* borraAux(Nodo *p, const T &elem) {
-		if (p == nullptr)
-			return nullptr;
-        else if (cless(elem, p->elem)) { // (elem < p->elem)
-            p->iz = borraAux(p->iz, elem);
-            return p;
-        } else if (cless(p->elem, elem)) { // (p-> elem < elem)
-            p->dr = borraAux(p->dr, elem);
-            return p;
-        } else { // (elem === p->elem)
-            --numElems; //eliminamos un elemento
-            return borraRaiz(p);
-        }
+	/** Deja en el conjunto sólo los elementos que también están en other. O(n + m) */
+	void intersect_with(const TreeSetC &other) {
+		Mapa::intersect_with(other);
 	}
 
+	/** Quita del conjunto los elementos que están en other. O(n + m) */
+	void difference_with(const TreeSetC &other) {
+		Mapa::difference_with(other);
+	}
+
+	/** Indica si todos los elementos del conjunto están en other. O(n + m) */
+	bool is_subset_of(const TreeSetC &other) const {
+		return Mapa::is_subset_of(other);
+	}
+
+	// //
+	// PARTIR Y UNIR CONJUNTOS
+	// //
+
 	/**
-	 * Borra la raíz de la estructura de nodos y devuelve un puntero a la nueva raíz.
-	 * Ésta raíz nueva garantiza que la estructura sigue siendo un árbol de búsqueda correcto.
-	 * O(log n) (si hay que buscar el mínimo)
+	 * Quita del conjunto los elementos mayores o iguales que c y los devuelve
+	 * en otro conjunto. O(log n)
 	 */
-	static Nodo* borraRaiz(Nodo *p) {
-		Nodo *aux;
-		if (p->iz == nullptr) {// Si no hay hijo izquierdo, la raíz pasa a ser el hijo derecho
-			aux = p->dr;
-			delete p;
-			return aux;
-		} else
-		if (p->dr == nullptr) {// Si no hay hijo derecho, la raíz pasa a ser el hijo izquierdo
-			aux = p->iz;
-			delete p;
-			return aux;
-		} else { //hay hijo derecho e izquierdo
-                 //Convertimos el elemento más pequeño del hijo derecho en la raíz
-			return mueveMinYBorra(p);
-		}
+	TreeSetC split(const T &c) {
+		TreeSetC ret;
+		Mapa::parteEn(c, ret);
+		return ret;
 	}
 
 	/**
-	 * Método auxiliar para el borrado. Busca el elemento más pequeóo del hijo derecho
-	 * que pasa a ser la nueva raíz (que devolverá), borra la antigua raíz y cose los punteros:
-	 *   - El mínimo pasa a ser la raíz.
-	 *   - El hijo izquierdo del padre del mínimo pasa a ser el antiguo hijo derecho de ese mínimo.
-	 * O(log n)
+	 * Añade los elementos de other, que queda vacío. Todos tienen que ser
+	 * mayores que los del conjunto; si no, se lanza EClaveErronea.
+	 * O(log n + log m)
 	 */
-	static Nodo *mueveMinYBorra(Nodo *p) {
-        /*
-         * Vamos bajando hasta encontrar el elemento más pequeño (aquel sin hijo izquierdo).
-         * También guardamos el padre.
-         */
-		Nodo *padre = nullptr;
-		Nodo *aux = p->dr;
-		while (aux->iz != nullptr) {
-			padre = aux;
-			aux = aux->iz;
-		}
-		if (padre != nullptr) { //hay un padre, se cambia
-			padre->iz = aux->dr;
-			aux->iz = p->iz;
-			aux->dr = p->dr;
-		} else { //si es la raíz directamente
-			aux->iz = p->iz;
-		}
+	void join(TreeSetC &other) {
+		Mapa::join(other);
+	}
 
-		delete p;
-		return aux;
+	// La copia, la asignación y el movimiento son los de TreeMap.
+
+private:
+    /** para el dibujo del árbol */
+    static const int TREE_INDENTATION = 4;
+
+	/**
+	 * Crea (sin enlazarlos) un nodo por cada elemento del rango [ini, fin) y
+	 * los deja en "nodos" ordenados y sin repetidos.
+	 * O(n) si el rango está ordenado; O(n log n) si no.
+	 */
+	template <typename It>
+	void creaNodos(It ini, It fin, std::vector<Nodo*> &nodos) {
+		for (; ini != fin; ++ini)
+			nodos.push_back(asig().nuevo(nullptr, nullptr, *ini));
+		this->ordenaNodos(nodos);
 	}
 
     /** Dubujo del árbol interno */
     static void graph_rec(std::ostream & out, int indent, Nodo* raiz) {
         if (raiz != nullptr) {
             graph_rec(out, indent + TREE_INDENTATION, raiz->dr);
-            out << std::setw(indent) << " " << raiz->elem << std::endl;
+            out << std::setw(indent) << " " << raiz->clave << std::endl;
             graph_rec(out, indent + TREE_INDENTATION, raiz->iz);
         }
     }
-
-	/** Puntero a la raíz de la estructura jerárquica de nodos. */
-	Nodo *ra;
-
-    /** Comparador: menor estricto. */
-    Comparador cless;
-
-    /** número de elementos en el conjunto */
-    int numElems;
-
 };
 
 #endif // __TREESETC_H
-
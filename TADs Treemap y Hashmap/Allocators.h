@@ -0,0 +1,222 @@
+/**
+ * Asignadores de memoria para los nodos de los diccionarios (HashMap y TreeMap).
+ */
+#ifndef __ALLOCATORS_H
+#define __ALLOCATORS_H
+
+#include <cstddef>
+#include <new>
+#include <utility>
+
+/**
+ * Los diccionarios reciben como parámetro de plantilla la clase que crea y
+ * destruye sus nodos. Un asignador para nodos de tipo T debe ofrecer:
+ *    - nuevo(args...): crea un nodo construido con esos argumentos.
+ *    - borra(nodo): destruye el nodo y libera (o recicla) su memoria.
+ *    - liberaTodo(): libera de golpe la memoria de todos los nodos, sin destruirlos.
+ *       Sólo se usa si LIBERA_EN_BLOQUE es true y los nodos no necesitan destructor.
+ *    - LIBERA_EN_BLOQUE: indica si liberaTodo hace algo útil.
+ *    - SEGURO_ENTRE_HILOS: indica si varios hilos pueden llamar a nuevo a la
+ *       vez sobre el mismo asignador (lo usan las operaciones en paralelo).
+ * Cada diccionario tiene su propio asignador: copiar un diccionario no comparte
+ * memoria con el original.
+ */
+
+/**
+ * Asignador por defecto: cada nodo se crea con new y se destruye con delete.
+ */
+template <typename T>
+class NewAllocator {
+public:
+	/** liberaTodo no hace nada: los nodos hay que borrarlos uno a uno. */
+	static const bool LIBERA_EN_BLOQUE = false;
+
+	/** new y delete ya se pueden usar desde varios hilos a la vez. */
+	static const bool SEGURO_ENTRE_HILOS = true;
+
+	/** Crea un nodo con new. O(1) */
+	template <typename... Args>
+	T *nuevo(Args&&... args) {
+		return new T(std::forward<Args>(args)...);
+	}
+
+	/** Destruye un nodo con delete. O(1) */
+	void borra(T *nodo) {
+		delete nodo;
+	}
+
+	/** No hay nada que liberar de golpe. */
+	void liberaTodo() {}
+};
+
+/**
+ * Asignador por regiones (arena). Los nodos se reservan dentro de bloques grandes
+ * (cada bloque tiene el doble de huecos que el anterior, hasta un máximo), los
+ * nodos borrados se reciclan a través de una lista de huecos libres, y todos los
+ * bloques se liberan de golpe, en O(número de bloques), al destruir el asignador
+ * o al llamar a liberaTodo.
+ */
+template <typename T>
+class ArenaAllocator {
+public:
+	/** liberaTodo libera todos los bloques de golpe. */
+	static const bool LIBERA_EN_BLOQUE = true;
+
+	/** La lista de huecos libres y el bloque actual no están protegidos. */
+	static const bool SEGURO_ENTRE_HILOS = false;
+
+	/** Número de huecos del primer bloque. */
+	static const std::size_t HUECOS_INICIAL = 32;
+
+	/** Número máximo de huecos de un bloque. */
+	static const std::size_t HUECOS_MAXIMO = 65536;
+
+	/** Constructor: arena vacía, sin ningún bloque. O(1) */
+	ArenaAllocator() : bloques(nullptr), libres(nullptr), sigHueco(0), numHuecos(0),
+			tamSigBloque(HUECOS_INICIAL) {}
+
+	/** Constructor copia: la copia empieza con una arena vacía propia. O(1) */
+	ArenaAllocator(const ArenaAllocator &) : ArenaAllocator() {}
+
+	/** Asignación: cada arena conserva sus propios bloques. O(1) */
+	ArenaAllocator &operator=(const ArenaAllocator &) {
+		return *this;
+	}
+
+	/**
+	 * Constructor de movimiento: se queda con los bloques de other, que queda
+	 * como una arena vacía. Los nodos ya creados siguen siendo válidos. O(1)
+	 */
+	ArenaAllocator(ArenaAllocator &&other) noexcept : ArenaAllocator() {
+		intercambia(other);
+	}
+
+	/**
+	 * Asignación de movimiento: libera los bloques propios y se queda con los
+	 * de other. O(número de bloques)
+	 */
+	ArenaAllocator &operator=(ArenaAllocator &&other) noexcept {
+		if (this != &other) {
+			liberaTodo();
+			intercambia(other);
+		}
+		return *this;
+	}
+
+	/** Destructor: libera todos los bloques. O(número de bloques) */
+	~ArenaAllocator() {
+		liberaTodo();
+	}
+
+	/**
+	 * Crea un nodo en un hueco libre (reciclado o nuevo).
+	 * O(1) amortizado.
+	 */
+	template <typename... Args>
+	T *nuevo(Args&&... args) {
+		void *mem;
+		if (libres != nullptr) {
+			mem = libres;
+			libres = libres->sig;
+		} else {
+			if (sigHueco == numHuecos)
+				nuevoBloque();
+			mem = primerHueco(bloques) + sigHueco * TAM_HUECO;
+			++sigHueco;
+		}
+		return new (mem) T(std::forward<Args>(args)...);
+	}
+
+	/** Destruye el nodo y guarda su hueco en la lista de libres. O(1) */
+	void borra(T *nodo) {
+		nodo->~T();
+		Libre *l = reinterpret_cast<Libre*>(nodo);
+		l->sig = libres;
+		libres = l;
+	}
+
+	/**
+	 * Libera todos los bloques sin destruir los nodos que contienen.
+	 * O(número de bloques)
+	 */
+	void liberaTodo() {
+		while (bloques != nullptr) {
+			Bloque *aux = bloques;
+			bloques = bloques->sig;
+			::operator delete(aux);
+		}
+		libres = nullptr;
+		sigHueco = 0;
+		numHuecos = 0;
+		tamSigBloque = HUECOS_INICIAL;
+	}
+
+private:
+	/** Un hueco libre guarda el puntero al siguiente hueco libre. */
+	struct Libre {
+		Libre *sig;
+	};
+
+	/** Cabecera de cada bloque: los bloques forman una lista enlazada. */
+	struct Bloque {
+		Bloque *sig;
+	};
+
+	/** Redondea n al siguiente múltiplo de a. */
+	static constexpr std::size_t redondea(std::size_t n, std::size_t a) {
+		return (n + a - 1) / a * a;
+	}
+
+	/** Alineamiento de los huecos: el de T, y al menos el de un puntero. */
+	static constexpr std::size_t ALINEAMIENTO =
+			alignof(T) > alignof(Libre) ? alignof(T) : alignof(Libre);
+
+	/** Tamaño de cada hueco: cabe un T o un puntero a otro hueco libre. */
+	static constexpr std::size_t TAM_HUECO =
+			redondea(sizeof(T) > sizeof(Libre) ? sizeof(T) : sizeof(Libre), ALINEAMIENTO);
+
+	/** Desplazamiento del primer hueco respecto al principio del bloque. */
+	static constexpr std::size_t CABECERA = redondea(sizeof(Bloque), ALINEAMIENTO);
+
+	/** Dirección del primer hueco de un bloque. */
+	static unsigned char *primerHueco(Bloque *b) {
+		return reinterpret_cast<unsigned char*>(b) + CABECERA;
+	}
+
+	/** Intercambia los bloques y huecos de las dos arenas. */
+	void intercambia(ArenaAllocator &other) {
+		std::swap(bloques, other.bloques);
+		std::swap(libres, other.libres);
+		std::swap(sigHueco, other.sigHueco);
+		std::swap(numHuecos, other.numHuecos);
+		std::swap(tamSigBloque, other.tamSigBloque);
+	}
+
+	/** Reserva un bloque nuevo, que pasa a ser el bloque actual. */
+	void nuevoBloque() {
+		Bloque *b = static_cast<Bloque*>(::operator new(CABECERA + tamSigBloque * TAM_HUECO));
+		b->sig = bloques;
+		bloques = b;
+		numHuecos = tamSigBloque;
+		sigHueco = 0;
+		if (tamSigBloque < HUECOS_MAXIMO)
+			tamSigBloque *= 2;
+	}
+
+	/** Lista de bloques reservados; el primero es el actual. */
+	Bloque *bloques;
+
+	/** Lista de huecos de nodos borrados, para reutilizarlos. */
+	Libre *libres;
+
+	/** Primer hueco aún sin usar del bloque actual. */
+	std::size_t sigHueco;
+
+	/** Número de huecos del bloque actual. */
+	std::size_t numHuecos;
+
+	/** Número de huecos que tendrá el siguiente bloque. */
+	std::size_t tamSigBloque;
+};
+
+#endif // __ALLOCATORS_H
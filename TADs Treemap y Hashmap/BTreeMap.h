@@ -0,0 +1,888 @@
+/**
+ * Implementación del TAD Dictionary utilizando árboles B+.
+ */
+
+#ifndef __BTREEMAP_H
+#define __BTREEMAP_H
+
+#include <algorithm>
+#include <cstddef>
+#include <functional>
+#include <iostream>
+#include <utility>
+#include "Exceptions.h"
+
+/**
+ * Implementación dinámica del TAD Dictionary utilizando árboles B+, con la misma
+ * interfaz que TreeMap.
+ * A diferencia de los árboles binarios, cada nodo guarda muchas claves seguidas
+ * en un array (unas cuatro líneas de caché), así que hay muchos menos niveles y
+ * cada nivel se resuelve con una búsqueda binaria en memoria contigua:
+ *    - Las hojas guardan las parejas (clave, valor) ordenadas y están enlazadas
+ *          entre sí en orden, de modo que los iteradores recorren las hojas una
+ *          tras otra sin volver a subir por el árbol.
+ *    - Los nodos internos sólo guardan claves separadoras y punteros a sus hijos:
+ *          las claves del hijo i son menores que claves[i] y las del hijo i+1 son
+ *          mayores o iguales.
+ *    - Todos los nodos, salvo la raíz, están al menos medio llenos. Al insertar
+ *          se dividen los nodos llenos que se encuentran al bajar y al borrar se
+ *          toma prestada una clave de un hermano o se fusionan dos hermanos.
+ * Clave y Valor deben tener constructor por defecto (los arrays de los nodos se
+ * crean enteros). Cualquier inserción o borrado invalida los iteradores.
+ * Las operaciones son:
+ *    - BTreeMapVacio: operación generadora que construye un árbol B+ vacío.
+ *    - Insert(clave, valor): generadora que añade una nueva pareja (clave, valor) al árbol.
+ *          Si la clave ya estaba se sustituye el valor.
+ *    - erase(clave): operación modificadora. Elimina la clave del árbol.
+ *          Si la clave no está la operación no tiene efecto.
+ *    - at(clave): operación observadora que devuelve el valor asociado a una clave.
+ *          Es un error preguntar por una clave que no existe.
+ *    - contains(clave): operación observadora. Sirve para averiguar si se ha introducido una
+ *          clave en el árbol
+ *    - empty(): operación observadora que indica si el árbol tiene alguna clave introducida.
+ *    - size(): operación observadora que indica el tamaño del diccionario.
+ * Como en TreeMap, están también emplace, try_emplace e insert_or_assign, y si el
+ * comparador es transparente at, contains y find admiten claves de otros tipos.
+ */
+
+template <typename Clave, typename Valor, typename Comparador = std::less<Clave>>
+class BTreeMap {
+private:
+	/** Bytes que se dedican, aproximadamente, a las entradas de un nodo. */
+	static const std::size_t BYTES_NODO = 256;
+
+	/** Número máximo de parejas (clave, valor) de una hoja (al menos 8). */
+	static const int CAP_HOJA = BYTES_NODO / (sizeof(Clave) + sizeof(Valor)) < 8 ? 8 :
+			(int) (BYTES_NODO / (sizeof(Clave) + sizeof(Valor)));
+
+	/** Número máximo de claves de un nodo interno (al menos 8), que tiene una hijo más. */
+	static const int CAP_INTERNO = BYTES_NODO / (sizeof(Clave) + sizeof(void*)) < 8 ? 8 :
+			(int) (BYTES_NODO / (sizeof(Clave) + sizeof(void*)));
+
+	/** Número mínimo de claves de los nodos que no son la raíz. */
+	static const int MIN_HOJA = CAP_HOJA / 2;
+	static const int MIN_INTERNO = CAP_INTERNO / 2;
+
+	/**
+	 * Parte común de los nodos: si es una hoja y cuántas claves tiene.
+	 */
+	class Nodo {
+	public:
+		Nodo(bool hoja) : hoja(hoja), n(0) {}
+
+		bool hoja;
+		int n;
+	};
+
+	/** Hoja: parejas (clave, valor) ordenadas y puntero a la hoja siguiente. */
+	class Hoja : public Nodo {
+	public:
+		Hoja() : Nodo(true), sig(nullptr) {}
+
+		Clave claves[CAP_HOJA];
+		Valor valores[CAP_HOJA];
+		Hoja *sig;
+	};
+
+	/** Nodo interno: n claves separadoras y n + 1 hijos. */
+	class Interno : public Nodo {
+	public:
+		Interno() : Nodo(false) {}
+
+		Clave claves[CAP_INTERNO];
+		Nodo *hijos[CAP_INTERNO + 1];
+	};
+
+public:
+
+	/** Constructor; operación EmptyBTreeMap */
+	BTreeMap() : ra(nullptr), numElems(0) {}
+
+	/** Destructor; elimina la estructura de nodos. */
+	~BTreeMap() {
+		libera(ra);
+		ra = nullptr;
+		numElems = 0;
+	}
+
+	/**
+	 * Operación generadora que añade una nueva clave/valor al árbol.
+	 * Si la clave ya existía, sustituimos el valor viejo por el nuevo.
+	 * O(log n)
+	 */
+	void insert(const Clave &clave, const Valor &valor) {
+		bool insertado;
+		Valor &v = buscaOInserta(clave, insertado, valor);
+		if (!insertado)
+			v = valor;
+	}
+
+	/** Como insert, pero moviendo la clave y el valor en vez de copiarlos. O(log n) */
+	void insert(Clave &&clave, Valor &&valor) {
+		bool insertado;
+		Valor &v = buscaOInserta(std::move(clave), insertado, std::move(valor));
+		if (!insertado)
+			v = std::move(valor);
+	}
+
+	/**
+	 * Añade la clave con un valor construido a partir de args. Si la clave ya
+	 * estaba no se hace nada. Devuelve si la clave era nueva.
+	 * O(log n)
+	 */
+	template <typename... Args>
+	bool try_emplace(const Clave &clave, Args&&... args) {
+		bool insertado;
+		buscaOInserta(clave, insertado, std::forward<Args>(args)...);
+		return insertado;
+	}
+
+	template <typename... Args>
+	bool try_emplace(Clave &&clave, Args&&... args) {
+		bool insertado;
+		buscaOInserta(std::move(clave), insertado, std::forward<Args>(args)...);
+		return insertado;
+	}
+
+	/**
+	 * Añade una pareja construyendo la clave a partir de c y el valor a partir
+	 * de args. Si la clave ya estaba no se hace nada. Devuelve si era nueva.
+	 * O(log n)
+	 */
+	template <typename C, typename... Args>
+	bool emplace(C &&c, Args&&... args) {
+		return try_emplace(Clave(std::forward<C>(c)), std::forward<Args>(args)...);
+	}
+
+	/**
+	 * Como insert (si la clave ya estaba se sustituye el valor), pero
+	 * devuelve si la clave era nueva.
+	 * O(log n)
+	 */
+	template <typename V>
+	bool insert_or_assign(const Clave &clave, V &&valor) {
+		bool insertado;
+		Valor &v = buscaOInserta(clave, insertado, std::forward<V>(valor));
+		if (!insertado)
+			v = std::forward<V>(valor);
+		return insertado;
+	}
+
+	template <typename V>
+	bool insert_or_assign(Clave &&clave, V &&valor) {
+		bool insertado;
+		Valor &v = buscaOInserta(std::move(clave), insertado, std::forward<V>(valor));
+		if (!insertado)
+			v = std::forward<V>(valor);
+		return insertado;
+	}
+
+	/**
+	 * Operación modificadora que elimina una clave del árbol.
+	 * Si la clave no existía la operación no tiene efecto.
+	 * O(log n)
+	 */
+	void erase(const Clave &clave) {
+		if (ra == nullptr)
+			return;
+		if (borraAux(ra, clave))
+			numElems--;
+		// Si la raíz se ha quedado sin claves, el árbol pierde un nivel
+		if (ra->n == 0) {
+			Nodo *aux = ra;
+			ra = ra->hoja ? nullptr : static_cast<Interno*>(ra)->hijos[0];
+			borraNodo(aux);
+		}
+	}
+
+	/**
+	 * Operación observadora que devuelve el valor asociado
+	 * a una clave dada. O(log n)
+	 */
+	const Valor &at(const Clave &clave) const {
+		int pos;
+		Hoja *h = buscaHoja(clave, pos);
+		if (h == nullptr)
+			throw EClaveErronea();
+		return h->valores[pos];
+	}
+
+	/**
+	 * Operación observadora que permite averiguar si una clave
+	 * determinada está en el árbol. O(log n)
+	 */
+	bool contains(const Clave &clave) const {
+		int pos;
+		return buscaHoja(clave, pos) != nullptr;
+	}
+
+	/**
+	 * Versiones de at y contains que buscan con una clave de otro tipo K sin
+	 * construir una Clave temporal. Sólo existen si el comparador es
+	 * transparente. O(log n)
+	 */
+	template <typename K, typename C = Comparador, typename = typename C::is_transparent>
+	const Valor &at(const K &clave) const {
+		int pos;
+		Hoja *h = buscaHoja(clave, pos);
+		if (h == nullptr)
+			throw EClaveErronea();
+		return h->valores[pos];
+	}
+
+	template <typename K, typename C = Comparador, typename = typename C::is_transparent>
+	bool contains(const K &clave) const {
+		int pos;
+		return buscaHoja(clave, pos) != nullptr;
+	}
+
+	/** Operación observadora que devuelve si un diccionario es vacío */
+	bool empty() const {
+		return numElems == 0;
+	}
+
+	/** Operación observadora que devuelve el número de elementos del diccionario */
+	int size() const {
+		return numElems;
+	}
+
+	/**
+	 * Sobrecarga del operador [] que permite acceder al valor asociado a una clave y modificarlo.
+	 * Si el elemento buscado no estaba, se inserta uno con el valor por defecto del tipo Valor.
+	 */
+	Valor &operator[](const Clave &clave) {
+		bool insertado;
+		return buscaOInserta(clave, insertado);
+	}
+
+	Valor &operator[](Clave &&clave) {
+		bool insertado;
+		return buscaOInserta(std::move(clave), insertado);
+	}
+
+	/** Dibujo del diccionario: Uso únicamente para debugear durante clase */
+	friend std::ostream& operator<<(std::ostream& o, const BTreeMap& t) {
+		o << "{";
+		for (ConstIterator it = t.cbegin(); it != t.cend(); ++it) {
+			if (it != t.cbegin())
+				o << ", ";
+			o << it.key() << " -> " << it.value();
+		}
+		o << "}";
+		return o;
+	}
+
+
+	// //
+	// ITERADOR CONSTANTE Y FUNCIONES RELACIONADAS
+	// //
+
+	/**
+	 * Clase interna que implementa un iterador que permite
+	 * recorrer el diccionario pero no modificarlo.
+	 * Es una hoja y una posición dentro de ella.
+	 */
+	class ConstIterator {
+	public:
+		ConstIterator() : act(nullptr), pos(0) {}
+
+		/** O(1) */
+		void next() {
+			if (act == nullptr)
+				throw InvalidAccessException();
+			++pos;
+			if (pos == act->n) { // pasamos a la hoja siguiente
+				act = act->sig;
+				pos = 0;
+			}
+		}
+
+		/** O(1) */
+		const Clave &key() const {
+			if (act == nullptr) throw InvalidAccessException();
+			return act->claves[pos];
+		}
+
+		/** O(1) */
+		const Valor &value() const {
+			if (act == nullptr) throw InvalidAccessException();
+			return act->valores[pos];
+		}
+
+		/** O(1) */
+		bool operator==(const ConstIterator &other) const {
+			return act == other.act && pos == other.pos;
+		}
+
+		/** O(1) */
+		bool operator!=(const ConstIterator &other) const {
+			return !(this->operator==(other));
+		}
+
+		/** O(1) */
+		ConstIterator &operator++() {
+			next();
+			return *this;
+		}
+
+		/** O(1) */
+		ConstIterator operator++(int) {
+			ConstIterator ret(*this);
+			operator++();
+			return ret;
+		}
+
+	protected:
+		friend class BTreeMap;
+
+		ConstIterator(Hoja *act, int pos) : act(act), pos(pos) {}
+
+		/** Hoja del elemento actual (nullptr al final del recorrido) */
+		Hoja *act;
+
+		/** Posición del elemento actual en la hoja */
+		int pos;
+	};
+
+	/**
+	 * Devuelve el iterador constante al principio del recorrido.
+	 * Es decir, empieza por el elemento más pequeño.
+	 * O(log n)
+	 */
+	ConstIterator cbegin() const {
+		return ConstIterator(primeraHoja(), 0);
+	}
+
+	/** Devuelve un iterador constante al final del recorrido (fuera de éste). O(1) */
+	ConstIterator cend() const {
+		return ConstIterator(nullptr, 0);
+	}
+
+	/**
+	 * Devuelve un iterador constante al elemento con clave c.
+	 * Devuelve el iterador cend si no está.
+	 * O(log n)
+	 */
+	ConstIterator find(const Clave &c) const {
+		int pos;
+		Hoja *h = buscaHoja(c, pos);
+		return h == nullptr ? cend() : ConstIterator(h, pos);
+	}
+
+	/** find con una clave de otro tipo (sólo si el comparador es transparente). */
+	template <typename K, typename C = Comparador, typename = typename C::is_transparent>
+	ConstIterator find(const K &c) const {
+		int pos;
+		Hoja *h = buscaHoja(c, pos);
+		return h == nullptr ? cend() : ConstIterator(h, pos);
+	}
+
+	// //
+	// ITERADOR NO CONSTANTE Y FUNCIONES RELACIONADAS
+	// //
+
+	/**
+	 * Clase interna que implementa un iterador sobre el árbol
+	 * que permite recorrerlo e incluso alterar el valor de sus elementos.
+	 */
+	class Iterator {
+	public:
+		Iterator() : act(nullptr), pos(0) {}
+
+		/** O(1) */
+		void next() {
+			if (act == nullptr)
+				throw InvalidAccessException();
+			++pos;
+			if (pos == act->n) { // pasamos a la hoja siguiente
+				act = act->sig;
+				pos = 0;
+			}
+		}
+
+		/** O(1) */
+		const Clave &key() const {
+			if (act == nullptr) throw InvalidAccessException();
+			return act->claves[pos];
+		}
+
+		/** O(1) */
+		Valor &value() const {
+			if (act == nullptr) throw InvalidAccessException();
+			return act->valores[pos];
+		}
+
+		/** O(1) */
+		bool operator==(const Iterator &other) const {
+			return act == other.act && pos == other.pos;
+		}
+
+		/** O(1) */
+		bool operator!=(const Iterator &other) const {
+			return !(this->operator==(other));
+		}
+
+		/** O(1) */
+		Iterator &operator++() {
+			next();
+			return *this;
+		}
+
+		/** O(1) */
+		Iterator operator++(int) {
+			Iterator ret(*this);
+			operator++();
+			return ret;
+		}
+
+	protected:
+		friend class BTreeMap;
+
+		Iterator(Hoja *act, int pos) : act(act), pos(pos) {}
+
+		/** Hoja del elemento actual (nullptr al final del recorrido) */
+		Hoja *act;
+
+		/** Posición del elemento actual en la hoja */
+		int pos;
+	};
+
+	/**
+	 * Devuelve el iterador al principio del recorrido.
+	 * Es decir, empieza por el elemento más pequeño.
+	 * O(log n)
+	 */
+	Iterator begin() {
+		return Iterator(primeraHoja(), 0);
+	}
+
+	/** Devuelve un iterador al final del recorrido (fuera de éste). O(1) */
+	Iterator end() const {
+		return Iterator(nullptr, 0);
+	}
+
+	/**
+	 * Devuelve un iterador al elemento con clave c.
+	 * Devuelve el iterador end si no está.
+	 * O(log n)
+	 */
+	Iterator find(const Clave &c) {
+		int pos;
+		Hoja *h = buscaHoja(c, pos);
+		return h == nullptr ? end() : Iterator(h, pos);
+	}
+
+	/** find con una clave de otro tipo (sólo si el comparador es transparente). */
+	template <typename K, typename C = Comparador, typename = typename C::is_transparent>
+	Iterator find(const K &c) {
+		int pos;
+		Hoja *h = buscaHoja(c, pos);
+		return h == nullptr ? end() : Iterator(h, pos);
+	}
+
+
+	// //
+	// MÉTODOS DE "FONTANERÍA" DE C++ QUE HACEN VERSÁTIL A LA CLASE
+	// //
+
+	/** Constructor copia */
+	BTreeMap(const BTreeMap &other) : ra(nullptr), numElems(0) {
+		copia(other);
+	}
+
+	/** Operador de asignación. O(n) */
+	BTreeMap &operator=(const BTreeMap &other) {
+		if (this != &other) {
+			libera(ra);
+			copia(other);
+		}
+		return *this;
+	}
+
+	/** Constructor de movimiento: other queda vacío. O(1) */
+	BTreeMap(BTreeMap &&other) noexcept : ra(other.ra), cless(std::move(other.cless)),
+			numElems(other.numElems) {
+		other.ra = nullptr;
+		other.numElems = 0;
+	}
+
+	/** Asignación de movimiento. O(n) para liberar el árbol actual */
+	BTreeMap &operator=(BTreeMap &&other) noexcept {
+		if (this != &other) {
+			libera(ra);
+			ra = other.ra;
+			numElems = other.numElems;
+			cless = std::move(other.cless);
+			other.ra = nullptr;
+			other.numElems = 0;
+		}
+		return *this;
+	}
+
+protected:
+
+	void copia(const BTreeMap &other) {
+		Hoja *ultima = nullptr;
+		ra = copiaAux(other.ra, ultima);
+		numElems = other.numElems;
+		cless = other.cless;
+	}
+
+private:
+
+	/** Destruye un nodo del tipo que corresponda (sin sus hijos). O(1) */
+	static void borraNodo(Nodo *p) {
+		if (p->hoja)
+			delete static_cast<Hoja*>(p);
+		else
+			delete static_cast<Interno*>(p);
+	}
+
+	/**
+	 * Elimina todos los nodos de una estructura que comienza con el puntero p.
+	 * O(n)
+	 */
+	static void libera(Nodo *p) {
+		if (p == nullptr)
+			return;
+		if (!p->hoja) {
+			Interno *in = static_cast<Interno*>(p);
+			for (int i = 0; i <= in->n; ++i)
+				libera(in->hijos[i]);
+		}
+		borraNodo(p);
+	}
+
+	/**
+	 * Copia la estructura de nodos que comienza en p. "ultima" es la última
+	 * hoja copiada hasta el momento, para enlazar las hojas de la copia.
+	 * O(n)
+	 */
+	static Nodo *copiaAux(Nodo *p, Hoja *&ultima) {
+		if (p == nullptr)
+			return nullptr;
+		if (p->hoja) {
+			Hoja *h = static_cast<Hoja*>(p);
+			Hoja *c = new Hoja();
+			std::copy(h->claves, h->claves + h->n, c->claves);
+			std::copy(h->valores, h->valores + h->n, c->valores);
+			c->n = h->n;
+			if (ultima != nullptr)
+				ultima->sig = c;
+			ultima = c;
+			return c;
+		}
+		Interno *in = static_cast<Interno*>(p);
+		Interno *c = new Interno();
+		std::copy(in->claves, in->claves + in->n, c->claves);
+		c->n = in->n;
+		for (int i = 0; i <= in->n; ++i)
+			c->hijos[i] = copiaAux(in->hijos[i], ultima);
+		return c;
+	}
+
+	/** Hoja con las claves más pequeñas (nullptr si el árbol es vacío). O(log n) */
+	Hoja *primeraHoja() const {
+		Nodo *p = ra;
+		if (p == nullptr)
+			return nullptr;
+		while (!p->hoja)
+			p = static_cast<Interno*>(p)->hijos[0];
+		return static_cast<Hoja*>(p);
+	}
+
+	/** Primera posición de claves[0..n) cuya clave no es menor que clave. O(log n) */
+	template <typename K>
+	int cotaInferior(const K &clave, const Clave *claves, int n) const {
+		int iz = 0, dr = n;
+		while (iz < dr) {
+			int m = (iz + dr) / 2;
+			if (cless(claves[m], clave))
+				iz = m + 1;
+			else
+				dr = m;
+		}
+		return iz;
+	}
+
+	/**
+	 * Primera posición de claves[0..n) cuya clave es mayor que clave. En un
+	 * nodo interno, es el hijo por el que hay que bajar. O(log n)
+	 */
+	template <typename K>
+	int cotaSuperior(const K &clave, const Clave *claves, int n) const {
+		int iz = 0, dr = n;
+		while (iz < dr) {
+			int m = (iz + dr) / 2;
+			if (cless(clave, claves[m]))
+				dr = m;
+			else
+				iz = m + 1;
+		}
+		return iz;
+	}
+
+	/**
+	 * Busca la clave. Si está devuelve su hoja y deja en pos su posición;
+	 * si no está devuelve nullptr.
+	 * O(log n)
+	 */
+	template <typename K>
+	Hoja *buscaHoja(const K &clave, int &pos) const {
+		Nodo *p = ra;
+		if (p == nullptr)
+			return nullptr;
+		while (!p->hoja) {
+			Interno *in = static_cast<Interno*>(p);
+			p = in->hijos[cotaSuperior(clave, in->claves, in->n)];
+		}
+		Hoja *h = static_cast<Hoja*>(p);
+		pos = cotaInferior(clave, h->claves, h->n);
+		if (pos == h->n || cless(clave, h->claves[pos]))
+			return nullptr;
+		return h;
+	}
+
+	/** Indica si un nodo está lleno. */
+	static bool lleno(Nodo *p) {
+		return p->n == (p->hoja ? CAP_HOJA : CAP_INTERNO);
+	}
+
+	/** Indica si un nodo (que no es la raíz) tiene menos claves de las debidas. */
+	static bool escaso(Nodo *p) {
+		return p->n < (p->hoja ? MIN_HOJA : MIN_INTERNO);
+	}
+
+	/** Indica si un nodo puede prestar una clave sin quedarse escaso. */
+	static bool sobrante(Nodo *p) {
+		return p->n > (p->hoja ? MIN_HOJA : MIN_INTERNO);
+	}
+
+	/**
+	 * Busca la clave y, si no está, la añade con un valor construido con args
+	 * (sin args, el valor por defecto). Devuelve el valor asociado a la clave
+	 * y deja en "insertado" si era nueva. Si no era nueva no se usa ninguno
+	 * de los argumentos.
+	 * Se baja una sola vez: los nodos llenos que se encuentran por el camino
+	 * se dividen antes de bajar, así que la hoja siempre tiene sitio.
+	 * O(log n)
+	 */
+	template <typename C, typename... Args>
+	Valor &buscaOInserta(C &&clave, bool &insertado, Args&&... args) {
+		if (ra == nullptr)
+			ra = new Hoja();
+		if (lleno(ra)) { // se divide la raíz: el árbol crece un nivel
+			Interno *r = new Interno();
+			r->hijos[0] = ra;
+			ra = r;
+			divideHijo(r, 0);
+		}
+		Nodo *p = ra;
+		while (!p->hoja) {
+			Interno *in = static_cast<Interno*>(p);
+			int i = cotaSuperior(clave, in->claves, in->n);
+			if (lleno(in->hijos[i])) {
+				divideHijo(in, i);
+				if (!cless(clave, in->claves[i])) // clave >= nuevo separador
+					++i;
+			}
+			p = in->hijos[i];
+		}
+		Hoja *h = static_cast<Hoja*>(p);
+		int i = cotaInferior(clave, h->claves, h->n);
+		if (i < h->n && !cless(clave, h->claves[i])) { // la clave aparecía
+			insertado = false;
+			return h->valores[i];
+		}
+		// La clave es nueva: le hacemos hueco en la posición i
+		std::move_backward(h->claves + i, h->claves + h->n, h->claves + h->n + 1);
+		std::move_backward(h->valores + i, h->valores + h->n, h->valores + h->n + 1);
+		h->claves[i] = std::forward<C>(clave);
+		h->valores[i] = Valor(std::forward<Args>(args)...);
+		h->n++;
+		numElems++;
+		insertado = true;
+		return h->valores[i];
+	}
+
+	/**
+	 * Divide el hijo i (lleno) de padre, que no está lleno, en dos nodos.
+	 * En una hoja el separador es una copia de la primera clave de la mitad
+	 * derecha; en un nodo interno la clave central sube al padre.
+	 * O(CAP)
+	 */
+	void divideHijo(Interno *padre, int i) {
+		Nodo *hijo = padre->hijos[i];
+		Nodo *nuevo;
+		Clave separador;
+		if (hijo->hoja) {
+			Hoja *iz = static_cast<Hoja*>(hijo);
+			Hoja *dr = new Hoja();
+			int mitad = iz->n / 2;
+			std::move(iz->claves + mitad, iz->claves + iz->n, dr->claves);
+			std::move(iz->valores + mitad, iz->valores + iz->n, dr->valores);
+			dr->n = iz->n - mitad;
+			iz->n = mitad;
+			dr->sig = iz->sig;
+			iz->sig = dr;
+			separador = dr->claves[0];
+			nuevo = dr;
+		} else {
+			Interno *iz = static_cast<Interno*>(hijo);
+			Interno *dr = new Interno();
+			int mitad = iz->n / 2;
+			separador = std::move(iz->claves[mitad]);
+			std::move(iz->claves + mitad + 1, iz->claves + iz->n, dr->claves);
+			std::copy(iz->hijos + mitad + 1, iz->hijos + iz->n + 1, dr->hijos);
+			dr->n = iz->n - mitad - 1;
+			iz->n = mitad;
+			nuevo = dr;
+		}
+		// Hacemos hueco en el padre para el separador y el nuevo hijo
+		std::move_backward(padre->claves + i, padre->claves + padre->n, padre->claves + padre->n + 1);
+		std::copy_backward(padre->hijos + i + 1, padre->hijos + padre->n + 1, padre->hijos + padre->n + 2);
+		padre->claves[i] = std::move(separador);
+		padre->hijos[i + 1] = nuevo;
+		padre->n++;
+	}
+
+	/**
+	 * Elimina (si existe) la clave del subárbol p y devuelve si estaba.
+	 * Al volver de cada hijo, si éste se ha quedado escaso se repara
+	 * pidiendo prestado a un hermano o fusionándolo con él.
+	 * O(log n)
+	 */
+	bool borraAux(Nodo *p, const Clave &clave) {
+		if (p->hoja) {
+			Hoja *h = static_cast<Hoja*>(p);
+			int i = cotaInferior(clave, h->claves, h->n);
+			if (i == h->n || cless(clave, h->claves[i])) // no está
+				return false;
+			std::move(h->claves + i + 1, h->claves + h->n, h->claves + i);
+			std::move(h->valores + i + 1, h->valores + h->n, h->valores + i);
+			h->n--;
+			vacia(h, h->n);
+			return true;
+		}
+		Interno *in = static_cast<Interno*>(p);
+		int i = cotaSuperior(clave, in->claves, in->n);
+		bool borrado = borraAux(in->hijos[i], clave);
+		if (borrado && escaso(in->hijos[i]))
+			repara(in, i);
+		return borrado;
+	}
+
+	/** Deja la posición i de una hoja (ya sin uso) con los valores por defecto. */
+	static void vacia(Hoja *h, int i) {
+		h->claves[i] = Clave();
+		h->valores[i] = Valor();
+	}
+
+	/**
+	 * Repara el hijo i de padre, que tiene una clave menos de las debidas:
+	 * si un hermano puede prestarle una clave se la presta, y si no se
+	 * fusiona con uno de ellos. O(CAP)
+	 */
+	void repara(Interno *padre, int i) {
+		if (i > 0 && sobrante(padre->hijos[i - 1]))
+			prestaIzquierdo(padre, i);
+		else if (i < padre->n && sobrante(padre->hijos[i + 1]))
+			prestaDerecho(padre, i);
+		else if (i > 0)
+			fusiona(padre, i - 1);
+		else
+			fusiona(padre, i);
+	}
+
+	/** El hermano izquierdo del hijo i le pasa su última clave. O(CAP) */
+	void prestaIzquierdo(Interno *padre, int i) {
+		if (padre->hijos[i]->hoja) {
+			Hoja *h = static_cast<Hoja*>(padre->hijos[i]);
+			Hoja *iz = static_cast<Hoja*>(padre->hijos[i - 1]);
+			std::move_backward(h->claves, h->claves + h->n, h->claves + h->n + 1);
+			std::move_backward(h->valores, h->valores + h->n, h->valores + h->n + 1);
+			h->claves[0] = std::move(iz->claves[iz->n - 1]);
+			h->valores[0] = std::move(iz->valores[iz->n - 1]);
+			h->n++;
+			iz->n--;
+			vacia(iz, iz->n);
+			padre->claves[i - 1] = h->claves[0];
+		} else {
+			Interno *h = static_cast<Interno*>(padre->hijos[i]);
+			Interno *iz = static_cast<Interno*>(padre->hijos[i - 1]);
+			std::move_backward(h->claves, h->claves + h->n, h->claves + h->n + 1);
+			std::copy_backward(h->hijos, h->hijos + h->n + 1, h->hijos + h->n + 2);
+			h->claves[0] = std::move(padre->claves[i - 1]);
+			h->hijos[0] = iz->hijos[iz->n];
+			h->n++;
+			padre->claves[i - 1] = std::move(iz->claves[iz->n - 1]);
+			iz->n--;
+		}
+	}
+
+	/** El hermano derecho del hijo i le pasa su primera clave. O(CAP) */
+	void prestaDerecho(Interno *padre, int i) {
+		if (padre->hijos[i]->hoja) {
+			Hoja *h = static_cast<Hoja*>(padre->hijos[i]);
+			Hoja *dr = static_cast<Hoja*>(padre->hijos[i + 1]);
+			h->claves[h->n] = std::move(dr->claves[0]);
+			h->valores[h->n] = std::move(dr->valores[0]);
+			h->n++;
+			std::move(dr->claves + 1, dr->claves + dr->n, dr->claves);
+			std::move(dr->valores + 1, dr->valores + dr->n, dr->valores);
+			dr->n--;
+			vacia(dr, dr->n);
+			padre->claves[i] = dr->claves[0];
+		} else {
+			Interno *h = static_cast<Interno*>(padre->hijos[i]);
+			Interno *dr = static_cast<Interno*>(padre->hijos[i + 1]);
+			h->claves[h->n] = std::move(padre->claves[i]);
+			h->hijos[h->n + 1] = dr->hijos[0];
+			h->n++;
+			padre->claves[i] = std::move(dr->claves[0]);
+			std::move(dr->claves + 1, dr->claves + dr->n, dr->claves);
+			std::copy(dr->hijos + 1, dr->hijos + dr->n + 1, dr->hijos);
+			dr->n--;
+		}
+	}
+
+	/**
+	 * Fusiona los hijos i e i + 1 de padre en el hijo i y quita del padre
+	 * el separador entre ambos. O(CAP)
+	 */
+	void fusiona(Interno *padre, int i) {
+		Nodo *der = padre->hijos[i + 1];
+		if (der->hoja) {
+			Hoja *iz = static_cast<Hoja*>(padre->hijos[i]);
+			Hoja *dr = static_cast<Hoja*>(der);
+			std::move(dr->claves, dr->claves + dr->n, iz->claves + iz->n);
+			std::move(dr->valores, dr->valores + dr->n, iz->valores + iz->n);
+			iz->n += dr->n;
+			iz->sig = dr->sig;
+		} else {
+			Interno *iz = static_cast<Interno*>(padre->hijos[i]);
+			Interno *dr = static_cast<Interno*>(der);
+			iz->claves[iz->n] = std::move(padre->claves[i]);
+			std::move(dr->claves, dr->claves + dr->n, iz->claves + iz->n + 1);
+			std::copy(dr->hijos, dr->hijos + dr->n + 1, iz->hijos + iz->n + 1);
+			iz->n += dr->n + 1;
+		}
+		borraNodo(der);
+		// Quitamos del padre el separador i y el hijo i + 1
+		std::move(padre->claves + i + 1, padre->claves + padre->n, padre->claves + i);
+		std::copy(padre->hijos + i + 2, padre->hijos + padre->n + 1, padre->hijos + i + 1);
+		padre->n--;
+		padre->claves[padre->n] = Clave();
+	}
+
+	/** Puntero a la raíz (una hoja o un nodo interno; nullptr si es vacío). */
+	Nodo *ra;
+
+	/** Comparador: menor estricto. */
+	Comparador cless;
+
+	/** número de elementos en el diccionario */
+	int numElems;
+};
+
+#endif // __BTREEMAP_H
@@ -0,0 +1,514 @@
+#include <algorithm>
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <mutex>
+#include <cmath>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+using namespace std;
+
+#include "Allocators.h"
+#include "BTreeMap.h"
+#include "HashMap.h"
+#include "TreeMap.h"
+#include "ClosedHashMap.h"
+#include "ConcurrentHashMap.h"
+#include "LockFreeHashMap.h"
+#include "Hash.h"
+
+// Cada prueba imprime una tabla con lo que tarda cada operación. Para que el
+// compilador no se salte las búsquedas, lo que devuelven se acumula en
+// "resultado", que se imprime al final de cada prueba.
+
+static long long resultado = 0;
+
+/** Segundos que tarda en ejecutarse fn */
+template <typename F>
+static double cronometra(F fn){
+	auto ini = chrono::steady_clock::now();
+	fn();
+	return chrono::duration<double>(chrono::steady_clock::now() - ini).count();
+}
+
+/** Nanosegundos por operación si n operaciones tardan "segundos" */
+static double nsPorOp(double segundos, size_t n){
+	return segundos * 1e9 / n;
+}
+
+/** Los enteros 0..n-1 desordenados */
+static vector<int> desordenados(size_t n, unsigned int semilla){
+	vector<int> v(n);
+	for (size_t i = 0; i < n; ++i)
+		v[i] = (int) i;
+	shuffle(v.begin(), v.end(), mt19937(semilla));
+	return v;
+}
+
+/**
+ * Llena una tabla hasta justo por debajo de la ocupación dada (con ella como
+ * ocupación máxima, la tabla acaba con "tam" cubetas) y mide búsquedas con
+ * éxito (aciertos) y sin él (fallos).
+ */
+template <typename Mapa>
+static void pruebaOcupacion(const char *nombre, float ocupacion, unsigned int tam){
+	// Las claves presentes son pares y las ausentes impares
+	size_t n = (size_t) (ocupacion * tam) - 1;
+	vector<int> claves = desordenados(n, 1);
+	for (int &c : claves)
+		c *= 2;
+	Mapa m;
+	m.max_load_factor(ocupacion);
+	for (int c : claves)
+		m.insert(c, c);
+	shuffle(claves.begin(), claves.end(), mt19937(2));
+	double aciertos = cronometra([&](){
+		for (int c : claves)
+			resultado += m.contains(c);
+	});
+	double fallos = cronometra([&](){
+		for (int c : claves)
+			resultado += m.contains(c + 1);
+	});
+	cout << setw(15) << nombre << setw(8) << fixed << setprecision(2) << m.load_factor()
+		<< setw(10) << m.bucket_count()
+		<< setw(12) << setprecision(1) << nsPorOp(aciertos, n)
+		<< setw(12) << nsPorOp(fallos, n) << endl;
+}
+
+void benchClosedHashMap(){
+	const unsigned int TAM = 1 << 20;
+	cout << "ClosedHashMap vs HashMap: contains, ns/op" << endl;
+	cout << setw(15) << "table" << setw(8) << "load" << setw(10) << "buckets"
+		<< setw(12) << "hit" << setw(12) << "miss" << endl;
+	for (float ocupacion : {0.5f, 0.6f, 0.7f, 0.8f, 0.9f}){
+		pruebaOcupacion<HashMap<int, int>>("HashMap", ocupacion, TAM);
+		pruebaOcupacion<ClosedHashMap<int, int>>("ClosedHashMap", ocupacion, TAM);
+	}
+	cout << "(" << resultado << ")" << endl;
+}
+
+/**
+ * Reparto de unos hashes en "cubetas" listas, eligiendo la lista con los bits
+ * bajos como hacen las tablas. Se compara el porcentaje de listas vacías con
+ * el que saldría con un hash aleatorio, y se da la lista más larga.
+ */
+static void reparto(const char *nombre, const vector<size_t> &hashes, unsigned int cubetas){
+	vector<unsigned int> cuenta(cubetas, 0);
+	for (size_t h : hashes)
+		cuenta[h & (cubetas - 1)]++;
+	size_t vacias = count(cuenta.begin(), cuenta.end(), 0u);
+	unsigned int maxima = *max_element(cuenta.begin(), cuenta.end());
+	double esperadas = 100 * exp(-(double) hashes.size() / cubetas);
+	cout << setw(24) << nombre << setw(10) << fixed << setprecision(1) << 100.0 * vacias / cubetas
+		<< setw(10) << esperadas << setw(8) << maxima << endl;
+}
+
+/** Aplica fn a cada clave */
+template <typename T, typename F>
+static vector<size_t> hashes(const vector<T> &claves, F fn){
+	vector<size_t> v;
+	v.reserve(claves.size());
+	for (const T &c : claves)
+		v.push_back(fn(c));
+	return v;
+}
+
+/** Mide insertar todas las claves en un HashMap con la función hash H y buscarlas después. */
+template <typename T, typename H>
+static void rendimientoHash(const char *nombre, const vector<T> &claves){
+	HashMap<T, int, H> m;
+	double insertar = cronometra([&](){
+		for (const T &c : claves)
+			m.insert(c, 0);
+	});
+	double buscar = cronometra([&](){
+		for (const T &c : claves)
+			resultado += m.contains(c);
+	});
+	cout << setw(24) << nombre << setw(12) << fixed << setprecision(1) << nsPorOp(insertar, claves.size())
+		<< setw(12) << nsPorOp(buscar, claves.size()) << endl;
+}
+
+void benchHash(){
+	const unsigned int N = 1 << 20;
+	const unsigned int CUBETAS = 1 << 20;
+	// Identificadores consecutivos, con paso fijo y cadenas con un prefijo común
+	vector<int> seguidos(N), paso(N);
+	vector<string> cadenas(N);
+	for (unsigned int i = 0; i < N; ++i){
+		seguidos[i] = (int) i;
+		paso[i] = (int) (i * 1024);
+		string num = to_string(i);
+		cadenas[i] = "customers/europe/account-" + string(10 - num.size(), '0') + num;
+	}
+
+	cout << "Hash distribution: " << N << " keys in " << CUBETAS << " buckets" << endl;
+	cout << setw(24) << "keys / hash" << setw(10) << "empty %" << setw(10) << "ideal %"
+		<< setw(8) << "max" << endl;
+	auto stdInt = [](int c){ return hash<int>()(c); };
+	auto stdCadena = [](const string &c){ return hash<string>()(c); };
+	auto mihashCadena = [](const string &c){ return Hash<string>()(c); };
+	reparto("seq / identity", hashes(seguidos, stdInt), CUBETAS);
+	reparto("seq / mezcla", hashes(seguidos, [&](int c){ return mezcla(stdInt(c)); }), CUBETAS);
+	reparto("x1024 / identity", hashes(paso, stdInt), CUBETAS);
+	reparto("x1024 / mezcla", hashes(paso, [&](int c){ return mezcla(stdInt(c)); }), CUBETAS);
+	reparto("prefix / std::hash", hashes(cadenas, stdCadena), CUBETAS);
+	reparto("prefix / Murmur", hashes(cadenas, mihashCadena), CUBETAS);
+	reparto("prefix / Murmur+mezcla", hashes(cadenas, [&](const string &c){ return mezcla(mihashCadena(c)); }), CUBETAS);
+
+	cout << "HashMap throughput, ns/op" << endl;
+	cout << setw(24) << "keys / hash" << setw(12) << "insert" << setw(12) << "contains" << endl;
+	rendimientoHash<int, hash<int>>("seq / std::hash", seguidos);
+	rendimientoHash<int, Hash<int>>("seq / mihash", seguidos);
+	rendimientoHash<int, hash<int>>("x1024 / std::hash", paso);
+	rendimientoHash<int, Hash<int>>("x1024 / mihash", paso);
+	rendimientoHash<string, hash<string>>("prefix / std::hash", cadenas);
+	rendimientoHash<string, Hash<string>>("prefix / Murmur", cadenas);
+	cout << "(" << resultado << ")" << endl;
+}
+
+/**
+ * Mide las tres fases de la vida de un diccionario: construirlo con n claves
+ * desordenadas, sustituir n veces una clave por otra nueva (borrar e insertar,
+ * con lo que se reciclan nodos) y destruirlo.
+ */
+template <typename Mapa>
+static void pruebaArena(const char *nombre, unsigned int n){
+	vector<int> claves = desordenados(2 * (size_t) n, 3);
+	Mapa *m = new Mapa();
+	double construir = cronometra([&](){
+		for (unsigned int i = 0; i < n; ++i)
+			m->insert(claves[i], claves[i]);
+	});
+	double renovar = cronometra([&](){
+		for (unsigned int i = 0; i < n; ++i){
+			m->erase(claves[i]);
+			m->insert(claves[n + i], i);
+		}
+	});
+	resultado += m->size();
+	double destruir = cronometra([&](){
+		delete m;
+	});
+	cout << setw(26) << nombre << setw(12) << fixed << setprecision(1) << nsPorOp(construir, n)
+		<< setw(12) << nsPorOp(renovar, n) << setw(12) << nsPorOp(destruir, n) << endl;
+}
+
+void benchArena(){
+	const unsigned int N = 1 << 20;
+	cout << "NewAllocator vs ArenaAllocator: " << N << " keys, ns/key" << endl;
+	cout << setw(26) << "map" << setw(12) << "build" << setw(12) << "churn"
+		<< setw(12) << "teardown" << endl;
+	pruebaArena<HashMap<int, int>>("HashMap", N);
+	pruebaArena<HashMap<int, int, hash<int>, ArenaAllocator>>("HashMap (arena)", N);
+	pruebaArena<TreeMap<int, int>>("TreeMap", N);
+	pruebaArena<TreeMap<int, int, less<int>, ArenaAllocator>>("TreeMap (arena)", N);
+	cout << "(" << resultado << ")" << endl;
+}
+
+/**
+ * Inserta, busca y borra las claves en el orden en que vienen. Un árbol sin
+ * equilibrar degeneraría en una lista con las secuencias ordenadas.
+ */
+template <typename Mapa>
+static void pruebaOrden(const char *nombre, const char *orden, const vector<int> &claves){
+	Mapa m;
+	double insertar = cronometra([&](){
+		for (int c : claves)
+			m.insert({c, c});
+	});
+	double buscar = cronometra([&](){
+		for (int c : claves)
+			resultado += m.count(c);
+	});
+	double borrar = cronometra([&](){
+		for (int c : claves)
+			m.erase(c);
+	});
+	cout << setw(10) << nombre << setw(10) << orden << setw(12) << fixed << setprecision(1)
+		<< nsPorOp(insertar, claves.size()) << setw(12) << nsPorOp(buscar, claves.size())
+		<< setw(12) << nsPorOp(borrar, claves.size()) << endl;
+}
+
+/** TreeMap con los nombres de std::map que usa pruebaOrden */
+class TreeMapComoMap : public TreeMap<int, int> {
+public:
+	void insert(const pair<int, int> &p){
+		TreeMap<int, int>::insert(p.first, p.second);
+	}
+
+	int count(int c) const {
+		return contains(c) ? 1 : 0;
+	}
+};
+
+void benchTreeMapOrden(){
+	const unsigned int N = 1 << 20;
+	vector<int> ordenadas(N), inversas(N);
+	for (unsigned int i = 0; i < N; ++i){
+		ordenadas[i] = (int) i;
+		inversas[i] = (int) (N - 1 - i);
+	}
+	vector<int> aleatorias = desordenados(N, 4);
+	cout << "TreeMap (AVL) vs std::map: " << N << " keys, ns/op" << endl;
+	cout << setw(10) << "map" << setw(10) << "order" << setw(12) << "insert"
+		<< setw(12) << "contains" << setw(12) << "erase" << endl;
+	pruebaOrden<TreeMapComoMap>("TreeMap", "sorted", ordenadas);
+	pruebaOrden<map<int, int>>("std::map", "sorted", ordenadas);
+	pruebaOrden<TreeMapComoMap>("TreeMap", "reverse", inversas);
+	pruebaOrden<map<int, int>>("std::map", "reverse", inversas);
+	pruebaOrden<TreeMapComoMap>("TreeMap", "random", aleatorias);
+	pruebaOrden<map<int, int>>("std::map", "random", aleatorias);
+	cout << "(" << resultado << ")" << endl;
+}
+
+/**
+ * Mide las operaciones de un diccionario ordenado con n claves: insertarlas
+ * desordenadas, buscarlas, recorrerlo en orden y borrarlas.
+ */
+template <typename Mapa>
+static void pruebaOrdenado(const char *nombre, const vector<int> &claves){
+	Mapa m;
+	double insertar = cronometra([&](){
+		for (int c : claves)
+			m.insert(c, c);
+	});
+	double buscar = cronometra([&](){
+		for (int c : claves)
+			resultado += m.contains(c);
+	});
+	double recorrer = cronometra([&](){
+		for (auto it = m.cbegin(); it != m.cend(); ++it)
+			resultado += it.value();
+	});
+	double borrar = cronometra([&](){
+		for (int c : claves)
+			m.erase(c);
+	});
+	size_t n = claves.size();
+	cout << setw(10) << nombre << setw(12) << fixed << setprecision(1) << nsPorOp(insertar, n)
+		<< setw(12) << nsPorOp(buscar, n) << setw(12) << nsPorOp(recorrer, n)
+		<< setw(12) << nsPorOp(borrar, n) << endl;
+}
+
+void benchBTreeMap(){
+	cout << "BTreeMap vs TreeMap: shuffled keys, ns/op" << endl;
+	for (unsigned int n : {1u << 10, 1u << 16, 1u << 20}){
+		vector<int> claves = desordenados(n, 5);
+		cout << n << " keys" << endl;
+		cout << setw(10) << "map" << setw(12) << "insert" << setw(12) << "contains"
+			<< setw(12) << "iterate" << setw(12) << "erase" << endl;
+		pruebaOrdenado<TreeMap<int, int>>("TreeMap", claves);
+		pruebaOrdenado<BTreeMap<int, int>>("BTreeMap", claves);
+	}
+	cout << "(" << resultado << ")" << endl;
+}
+
+/** HashMap protegido por un único cerrojo, con el que se comparan los diccionarios concurrentes */
+template <typename Clave, typename Valor>
+class HashMapConCerrojo {
+public:
+	void insert(const Clave &clave, const Valor &valor){
+		lock_guard<mutex> l(cerrojo);
+		mapa.insert(clave, valor);
+	}
+
+	void erase(const Clave &clave){
+		lock_guard<mutex> l(cerrojo);
+		mapa.erase(clave);
+	}
+
+	bool contains(const Clave &clave) const {
+		lock_guard<mutex> l(cerrojo);
+		return mapa.contains(clave);
+	}
+
+private:
+	mutable mutex cerrojo;
+	HashMap<Clave, Valor> mapa;
+};
+
+/** Número de hilos hasta el que se mide: los del procesador, y al menos 4 */
+static unsigned int maxHilos(){
+	return max(4u, thread::hardware_concurrency());
+}
+
+/**
+ * Lanza "hilos" hilos que hacen "ops" operaciones cada uno sobre claves al
+ * azar de [0, rango): un "lecturas" por ciento son contains y el resto,
+ * a partes iguales, insert y erase (así el tamaño se mantiene). Devuelve
+ * millones de operaciones por segundo entre todos los hilos.
+ */
+template <typename Mapa>
+static double pruebaMezcla(Mapa &m, unsigned int hilos, unsigned int lecturas, unsigned int ops, unsigned int rango){
+	vector<long long> encontradas(hilos, 0);
+	double segundos = cronometra([&](){
+		vector<thread> trabajadores;
+		for (unsigned int t = 0; t < hilos; ++t)
+			trabajadores.emplace_back([&, t](){
+				mt19937 gen(t + 1);
+				long long n = 0;
+				for (unsigned int i = 0; i < ops; ++i){
+					unsigned int r = gen();
+					int c = (int) ((r >> 8) % rango);
+					unsigned int tipo = r % 100;
+					if (tipo < lecturas)
+						n += m.contains(c);
+					else if (tipo % 2 == 0)
+						m.insert(c, c);
+					else
+						m.erase(c);
+				}
+				encontradas[t] = n;
+			});
+		for (thread &h : trabajadores)
+			h.join();
+	});
+	for (long long n : encontradas)
+		resultado += n;
+	return (double) hilos * ops / segundos / 1e6;
+}
+
+/** Diccionario de tipo Mapa con la mitad de las claves de [0, rango) */
+template <typename Mapa>
+static void llenaMitad(Mapa &m, unsigned int rango){
+	for (unsigned int i = 0; i < rango; i += 2)
+		m.insert((int) i, (int) i);
+}
+
+void benchConcurrentHashMap(){
+	const unsigned int RANGO = 1 << 20;
+	const unsigned int OPS = 1 << 20;
+	cout << "ConcurrentHashMap vs HashMap + mutex: Mops/s with 1.." << maxHilos() << " threads"
+		<< " (" << thread::hardware_concurrency() << " hardware threads)" << endl;
+	cout << setw(8) << "reads %" << setw(9) << "threads" << setw(14) << "mutex" << setw(14) << "concurrent" << endl;
+	for (unsigned int lecturas : {50u, 90u, 99u})
+		for (unsigned int hilos = 1; hilos <= maxHilos(); hilos *= 2){
+			HashMapConCerrojo<int, int> conCerrojo;
+			ConcurrentHashMap<int, int> concurrente;
+			llenaMitad(conCerrojo, RANGO);
+			llenaMitad(concurrente, RANGO);
+			double a = pruebaMezcla(conCerrojo, hilos, lecturas, OPS, RANGO);
+			double b = pruebaMezcla(concurrente, hilos, lecturas, OPS, RANGO);
+			cout << setw(8) << lecturas << setw(9) << hilos << setw(14) << fixed << setprecision(2) << a
+				<< setw(14) << b << endl;
+		}
+	cout << "(" << resultado << ")" << endl;
+}
+
+void benchLockFreeHashMap(){
+	const unsigned int RANGO = 1 << 20;
+	const unsigned int OPS = 1 << 20;
+	cout << "LockFreeHashMap vs ConcurrentHashMap vs HashMap + mutex: Mops/s with 1.." << maxHilos()
+		<< " threads (" << thread::hardware_concurrency() << " hardware threads)" << endl;
+	cout << setw(8) << "reads %" << setw(9) << "threads" << setw(14) << "mutex" << setw(14) << "concurrent"
+		<< setw(14) << "lock-free" << endl;
+	for (unsigned int lecturas : {100u, 99u})
+		for (unsigned int hilos = 1; hilos <= maxHilos(); hilos *= 2){
+			HashMapConCerrojo<int, int> conCerrojo;
+			ConcurrentHashMap<int, int> concurrente;
+			LockFreeHashMap<int, int> sinCerrojos;
+			llenaMitad(conCerrojo, RANGO);
+			llenaMitad(concurrente, RANGO);
+			llenaMitad(sinCerrojos, RANGO);
+			double a = pruebaMezcla(conCerrojo, hilos, lecturas, OPS, RANGO);
+			double b = pruebaMezcla(concurrente, hilos, lecturas, OPS, RANGO);
+			double c = pruebaMezcla(sinCerrojos, hilos, lecturas, OPS, RANGO);
+			cout << setw(8) << lecturas << setw(9) << hilos << setw(14) << fixed << setprecision(2) << a
+				<< setw(14) << b << setw(14) << c << endl;
+		}
+	cout << "(" << resultado << ")" << endl;
+}
+
+void benchBuildParallel(){
+	const unsigned int N = 1 << 22;
+	vector<int> claves = desordenados(N, 6);
+	vector<pair<int, int>> parejas;
+	parejas.reserve(N);
+	for (int c : claves)
+		parejas.push_back({c, c});
+	cout << "HashMap::build_parallel: " << N << " pairs, ms (" << thread::hardware_concurrency()
+		<< " hardware threads)" << endl;
+	cout << setw(20) << "build" << setw(12) << "ms" << endl;
+	double secuencial = cronometra([&](){
+		HashMap<int, int> m(N);
+		for (const pair<int, int> &p : parejas)
+			m.insert(p.first, p.second);
+		resultado += m.size();
+	});
+	cout << setw(20) << "insert loop" << setw(12) << fixed << setprecision(1) << secuencial * 1e3 << endl;
+	for (unsigned int hilos = 1; hilos <= maxHilos(); hilos *= 2){
+		double paralelo = cronometra([&](){
+			HashMap<int, int> m = HashMap<int, int>::build_parallel(parejas.begin(), parejas.end(), hilos);
+			resultado += m.size();
+		});
+		cout << setw(20) << "build_parallel, " + to_string(hilos) + "t" << setw(12) << paralelo * 1e3 << endl;
+	}
+	cout << "(" << resultado << ")" << endl;
+}
+
+/**
+ * Compara buscar claves una a una (contains y at) con buscarlas en grupos
+ * (contains_batch y at_batch) en una tabla con las claves dadas. Se buscan
+ * CONSULTAS claves de la tabla tomadas al azar.
+ */
+template <typename Clave>
+static void pruebaBatch(const vector<Clave> &claves){
+	const size_t CONSULTAS = 1 << 20;
+	HashMap<Clave, int> m;
+	for (size_t i = 0; i < claves.size(); ++i)
+		m.insert(claves[i], (int) i);
+	vector<Clave> consultas;
+	consultas.reserve(CONSULTAS);
+	mt19937 gen(7);
+	for (size_t i = 0; i < CONSULTAS; ++i)
+		consultas.push_back(claves[gen() % claves.size()]);
+	vector<char> estan(CONSULTAS);
+	vector<int> valores(CONSULTAS);
+
+	double sueltas = cronometra([&](){
+		for (size_t i = 0; i < CONSULTAS; ++i)
+			estan[i] = m.contains(consultas[i]);
+	});
+	double grupos = cronometra([&](){
+		m.contains_batch(consultas.begin(), consultas.end(), estan.begin());
+	});
+	double atSueltas = cronometra([&](){
+		for (size_t i = 0; i < CONSULTAS; ++i)
+			valores[i] = m.at(consultas[i]);
+	});
+	double atGrupos = cronometra([&](){
+		m.at_batch(consultas.begin(), consultas.end(), valores.begin());
+	});
+	resultado += count(estan.begin(), estan.end(), 1) + valores[CONSULTAS / 2];
+	cout << setw(10) << claves.size() << setw(12) << fixed << setprecision(1)
+		<< nsPorOp(sueltas, CONSULTAS) << setw(12) << nsPorOp(grupos, CONSULTAS)
+		<< setw(12) << nsPorOp(atSueltas, CONSULTAS) << setw(12) << nsPorOp(atGrupos, CONSULTAS) << endl;
+}
+
+void benchBatch(){
+	const unsigned int TAMS[] = {1 << 10, 1 << 14, 1 << 18, 1 << 20, 1 << 22};
+	cout << "HashMap batch lookups vs one by one, ns/key" << endl;
+	for (int cadenas = 0; cadenas < 2; ++cadenas){
+		cout << (cadenas ? "string keys" : "int keys") << endl;
+		cout << setw(10) << "keys" << setw(12) << "contains" << setw(12) << "c_batch"
+			<< setw(12) << "at" << setw(12) << "at_batch" << endl;
+		for (unsigned int n : TAMS){
+			vector<int> enteros = desordenados(n, 8);
+			if (!cadenas)
+				pruebaBatch(enteros);
+			else {
+				vector<string> v;
+				v.reserve(n);
+				for (int c : enteros)
+					v.push_back("key-" + to_string(c) + "-of-the-batch-benchmark");
+				pruebaBatch(v);
+			}
+		}
+	}
+	cout << "(" << resultado << ")" << endl;
+}
@@ -0,0 +1,14 @@
+#ifndef BENCHMARKS_H_
+#define BENCHMARKS_H_
+
+void benchClosedHashMap();
+void benchHash();
+void benchArena();
+void benchTreeMapOrden();
+void benchBTreeMap();
+void benchConcurrentHashMap();
+void benchLockFreeHashMap();
+void benchBuildParallel();
+void benchBatch();
+
+#endif /* BENCHMARKS_H_ */
@@ -0,0 +1,624 @@
+/**
+ * Implementación del TAD Diccionario usando una tabla hash cerrada
+ * (direccionamiento abierto con exploración lineal).
+ * Basada en la implementación de HashMap de Antonio Sánchez Ruiz-Granados
+ * e Ignacio Fábregas.
+ */
+#ifndef __CLOSEDHASHMAP_H
+#define __CLOSEDHASHMAP_H
+
+#include <cstddef>
+#include <iostream>
+#include <new>
+#include <utility>
+#include "Exceptions.h"
+#include "Hash.h"
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define CLOSEDHASHMAP_SSE2
+#endif
+
+/**
+ * Implementación del TAD Diccionario usando una tabla hash cerrada.
+ * A diferencia de HashMap, no hay nodos: las claves y los valores se guardan
+ * directamente en un array contiguo de celdas, de modo que buscar una clave
+ * recorre posiciones consecutivas de memoria en vez de seguir punteros.
+ * Las colisiones se resuelven con exploración lineal y el borrado desplaza hacia
+ * atrás los elementos siguientes (no se usan marcas de "borrado").
+ * Junto a las celdas se guarda un array de bytes de control con 7 bits del hash
+ * de cada clave (su "huella"). Las búsquedas comparan la huella con un grupo de
+ * 16 bytes de control a la vez (con SSE2 si está disponible) y sólo comparan
+ * claves cuando la huella coincide.
+ * Ofrece exactamente las mismas operaciones e iteradores que HashMap:
+ *    - ClosedHashMapVacio: operación generadora que construye una tabla vacía
+ *    - Insert(clave, valor): generadora que añade una nueva pareja (clave, valor)
+ *       a la tabla. Si la clave ya estaba se sustituye el valor.
+ *    - erase(clave): operación modificadora. Elimina la clave de la tabla.
+ *       Si la clave no está, la operación no tiene efecto.
+ *    - at(clave): operación observadora que devuelve el valor asociado a una clave.
+ *       Es un error preguntar por una clave que no existe.
+ *    - contains(clave): operación observadora. Sirve para averiguar si una clave
+ *       está presente en la tabla.
+ *    - empty(): operación observadora que indica si la tabla tiene alguna clave introducida.
+ *    - size(): operación observadora que indica el tamaño del diccionario.
+ * El tamaño de la tabla es siempre una potencia de 2, por lo que el índice se
+ * obtiene con una máscara en vez de con el módulo.
+ */
+template <typename Clave, typename Valor, typename Hash = std::hash<Clave>>
+class ClosedHashMap {
+private:
+	/**
+	 * Cada celda de la tabla contiene una clave y su valor. Las celdas se crean
+	 * y destruyen "a mano" (placement new) para que las posiciones libres no
+	 * necesiten un objeto construido.
+	 */
+	class Celda {
+	public:
+		Celda(const Clave &clave, const Valor &valor) : clave(clave), valor(valor) {}
+
+		/** Clave */
+		Clave clave;
+
+		/** Valor */
+		Valor valor;
+	};
+
+public:
+
+	/** Número de bytes de control que se examinan a la vez. */
+	static const unsigned int GRUPO = 16;
+
+	/** Tamaño inicial de la tabla. Debe ser potencia de 2 y no menor que GRUPO. */
+	static const int TAM_INICIAL = GRUPO;
+
+	/** Constructor por defecto que implementa ClosedHashMapVacio. O(1) */
+	ClosedHashMap() : numElems(0), maxOcupacion(MAX_OCUPACION) {
+		inicia(TAM_INICIAL);
+	}
+
+	/** Destructor; destruye las celdas ocupadas y libera la tabla */
+	~ClosedHashMap() {
+		libera();
+	}
+
+	/**
+	 * Operación generadora que añade una nueva clave/valor a la tabla.
+	 * Si la clave ya estaba, se sustituye el valor.
+	 * O(1) amortizado y en media (la ocupación está acotada).
+	 */
+	void insert(const Clave &clave, const Valor &valor) {
+		std::size_t h = hashMezclado(clave);
+		unsigned int ind;
+		if (buscaPosicion(clave, h, ind)) {
+			celdas[ind].valor = valor;
+		} else {
+			if (necesitaAmpliar()) {
+				amplia();
+				buscaPosicion(clave, h, ind); // la posición libre ha cambiado
+			}
+			construye(ind, h, clave, valor);
+		}
+	}
+
+	/**
+	 * Operación modificadora que elimina una clave de la tabla.
+	 * Si la clave no existía la operación no tiene efecto.
+	 * O(1) en media.
+	 */
+	void erase(const Clave &clave) {
+		unsigned int ind;
+		if (buscaPosicion(clave, hashMezclado(clave), ind))
+			borraCelda(ind);
+	}
+
+	/**
+	 * Operación observadora que devuelve el valor asociado a una clave.
+	 * Si no existe se lanza una excepción.
+	 * O(1) en media.
+	 */
+	const Valor &at(const Clave &clave) const {
+		unsigned int ind;
+		if (!buscaPosicion(clave, hashMezclado(clave), ind))
+			throw EClaveErronea();
+		return celdas[ind].valor;
+	}
+
+	/** Operación observadora que indica si una clave aparece. O(1) en media */
+	bool contains(const Clave &clave) const {
+		unsigned int ind;
+		return buscaPosicion(clave, hashMezclado(clave), ind);
+	}
+
+	/** Operación observadora que devuelve si el diccionario es vacío. O(1) */
+	bool empty() const {
+		return numElems == 0;
+	}
+
+	/** Operación observadora que devuelve el tamaño del diccionario. O(1) */
+	int size() const {
+		return numElems;
+	}
+
+	/**
+	 * Sobrecarga del operador [] que permite acceder al valor asociado
+	 * a una clave y modificarlo. Si el elemento buscado no estaba, se inserta uno
+	 * con el valor por defecto del tipo Valor.
+	 * O(1) en media.
+	 */
+	Valor &operator[](const Clave &clave) {
+		std::size_t h = hashMezclado(clave);
+		unsigned int ind;
+		if (!buscaPosicion(clave, h, ind)) {
+			if (necesitaAmpliar()) {
+				amplia();
+				buscaPosicion(clave, h, ind);
+			}
+			construye(ind, h, clave, Valor());
+		}
+		return celdas[ind].valor;
+	}
+
+	/** Número de celdas de la tabla. O(1) */
+	unsigned int bucket_count() const {
+		return tam;
+	}
+
+	/** Ocupación actual: fracción de celdas ocupadas. O(1) */
+	float load_factor() const {
+		return ((float) numElems) / tam;
+	}
+
+	/** Ocupación máxima antes de ampliar la tabla (por defecto 0.8). O(1) */
+	float max_load_factor() const {
+		return maxOcupacion / 100;
+	}
+
+	/**
+	 * Cambia la ocupación máxima antes de ampliar la tabla. Tiene que ser
+	 * menor que 1, porque las búsquedas terminan al encontrar una celda vacía;
+	 * un valor fuera de (0, 1) no tiene efecto. Si la ocupación actual ya
+	 * supera la nueva máxima, la tabla se amplía.
+	 * O(n) si hay que ampliar y O(1) si no.
+	 */
+	void max_load_factor(float maxima) {
+		if (maxima <= 0 || maxima >= 1)
+			return;
+		maxOcupacion = 100 * maxima;
+		while (100 * numElems > maxOcupacion * tam)
+			amplia();
+	}
+
+	// //
+	// ITERADOR CONSTANTE Y FUNCIONES RELACIONADAS
+	// //
+
+	/**
+	 * Clase interna que implementa un iterador que permite recorrer
+	 * la tabla pero no modificarla. Recorre el array de celdas en orden.
+	 */
+	class ConstIterator {
+	public:
+		ConstIterator() : tabla(nullptr), ind(0) {}
+
+		void next() {
+			if (tabla == nullptr || ind == tabla->tam)
+				throw InvalidAccessException();
+			ind = tabla->siguienteOcupada(ind + 1);
+		}
+
+		const Clave &key() const {
+			if (tabla == nullptr || ind == tabla->tam)
+				throw InvalidAccessException();
+			return tabla->celdas[ind].clave;
+		}
+
+		const Valor &value() const {
+			if (tabla == nullptr || ind == tabla->tam)
+				throw InvalidAccessException();
+			return tabla->celdas[ind].valor;
+		}
+
+		bool operator==(const ConstIterator &other) const {
+			return tabla == other.tabla && ind == other.ind;
+		}
+
+		bool operator!=(const ConstIterator &other) const {
+			return !(this->operator==(other));
+		}
+
+		ConstIterator &operator++() {
+			next();
+			return *this;
+		}
+
+		ConstIterator operator++(int) {
+			ConstIterator ret(*this);
+			operator++();
+			return ret;
+		}
+
+	protected:
+		friend class ClosedHashMap;
+
+		ConstIterator(const ClosedHashMap *tabla, unsigned int ind)
+			: tabla(tabla), ind(ind) { }
+
+		/** Puntero a la tabla que se está recorriendo */
+		const ClosedHashMap *tabla;
+
+		/** Índice de la celda actual (tam si estamos al final) */
+		unsigned int ind;
+	};
+
+	/** Devuelve un iterador constante al principio del diccionario. */
+	ConstIterator cbegin() const {
+		return ConstIterator(this, siguienteOcupada(0));
+	}
+
+	/** Devuelve un iterador constante al final del recorrido */
+	ConstIterator cend() const {
+		return ConstIterator(this, tam);
+	}
+
+	/**
+	 * Devuelve un iterador a la posición de la clave.
+	 * Si no existe la clave devuelve un iterador al final.
+	 */
+	ConstIterator find(const Clave &clave) const {
+		unsigned int ind;
+		if (!buscaPosicion(clave, hashMezclado(clave), ind))
+			ind = tam;
+		return ConstIterator(this, ind);
+	}
+
+	// //
+	// ITERADOR NO CONSTANTE Y FUNCIONES RELACIONADAS
+	// //
+
+	/**
+	 * Clase interna que implementa un iterador que permite
+	 * recorrer la tabla y modificar los valores.
+	 */
+	class Iterator {
+	public:
+		Iterator() : tabla(nullptr), ind(0) {}
+
+		void next() {
+			if (tabla == nullptr || ind == tabla->tam)
+				throw InvalidAccessException();
+			ind = tabla->siguienteOcupada(ind + 1);
+		}
+
+		const Clave &key() const {
+			if (tabla == nullptr || ind == tabla->tam)
+				throw InvalidAccessException();
+			return tabla->celdas[ind].clave;
+		}
+
+		Valor &value() const {
+			if (tabla == nullptr || ind == tabla->tam)
+				throw InvalidAccessException();
+			return tabla->celdas[ind].valor;
+		}
+
+		bool operator==(const Iterator &other) const {
+			return tabla == other.tabla && ind == other.ind;
+		}
+
+		bool operator!=(const Iterator &other) const {
+			return !(this->operator==(other));
+		}
+
+		Iterator &operator++() {
+			next();
+			return *this;
+		}
+
+		Iterator operator++(int) {
+			Iterator ret(*this);
+			operator++();
+			return ret;
+		}
+
+	protected:
+		friend class ClosedHashMap;
+
+		Iterator(const ClosedHashMap *tabla, unsigned int ind)
+			: tabla(tabla), ind(ind) { }
+
+		/** Puntero a la tabla que se está recorriendo */
+		const ClosedHashMap *tabla;
+
+		/** Índice de la celda actual (tam si estamos al final) */
+		unsigned int ind;
+	};
+
+	/** Devuelve un iterador al principio del diccionario. */
+	Iterator begin() {
+		return Iterator(this, siguienteOcupada(0));
+	}
+
+	/** Devuelve un iterador al final del recorrido. */
+	Iterator end() const {
+		return Iterator(this, tam);
+	}
+
+	/**
+	 * Devuelve un iterador a la posición de la clave.
+	 * Si no existe la clave devuelve un iterador al final.
+	 */
+	Iterator find(const Clave &clave) {
+		unsigned int ind;
+		if (!buscaPosicion(clave, hashMezclado(clave), ind))
+			ind = tam;
+		return Iterator(this, ind);
+	}
+
+
+	// //
+	// MÉTODOS DE "FONTANERÍA" DE C++ QUE HACEN VERSÁTIL A LA CLASE
+	// //
+
+	/** Dibujo del diccionario: Uso únicamente para debugear durante clase */
+	friend std::ostream& operator<<(std::ostream& o, const ClosedHashMap& t){
+		o<<"{";
+		t.muestra(o);
+		o<<"}";
+		return o;
+	}
+
+	/** Constructor copia */
+	ClosedHashMap(const ClosedHashMap &other) {
+		copia(other);
+	}
+
+	/** Operador de asignación */
+	ClosedHashMap &operator=(const ClosedHashMap &other) {
+		if (this != &other) {
+			libera();
+			copia(other);
+		}
+		return *this;
+	}
+
+private:
+
+	/**
+	 * Reserva una tabla vacía de n celdas (n potencia de 2, n >= GRUPO).
+	 * El array de control tiene GRUPO bytes más que replican los GRUPO primeros,
+	 * para poder leer un grupo completo a partir de cualquier posición.
+	 */
+	void inicia(unsigned int n) {
+		tam = n;
+		celdas = static_cast<Celda*>(::operator new(tam * sizeof(Celda)));
+		control = new signed char[tam + GRUPO];
+		for (unsigned int i = 0; i < tam + GRUPO; ++i)
+			control[i] = VACIA;
+	}
+
+	/** Destruye las celdas ocupadas y libera la memoria de la tabla. */
+	void libera() {
+		if (celdas != nullptr) {
+			for (unsigned int i = 0; i < tam; ++i)
+				if (control[i] != VACIA)
+					celdas[i].~Celda();
+			::operator delete(celdas);
+			delete[] control;
+			celdas = nullptr;
+			control = nullptr;
+		}
+	}
+
+	/**
+	 * Hace una copia de la tabla que recibe como parámetro.
+	 * Antes de llamar a este método se debe invocar al método "libera".
+	 * Como el tamaño es el mismo, cada celda se copia en la misma posición.
+	 */
+	void copia(const ClosedHashMap &other) {
+		numElems = other.numElems;
+		maxOcupacion = other.maxOcupacion;
+		inicia(other.tam);
+		for (unsigned int i = 0; i < tam; ++i)
+			if (other.control[i] != VACIA)
+				new (&celdas[i]) Celda(other.celdas[i]);
+		for (unsigned int i = 0; i < tam + GRUPO; ++i)
+			control[i] = other.control[i];
+	}
+
+	/** Construye una nueva celda en la posición libre ind. */
+	void construye(unsigned int ind, std::size_t h, const Clave &clave, const Valor &valor) {
+		new (&celdas[ind]) Celda(clave, valor);
+		ponControl(ind, huella(h));
+		numElems++;
+	}
+
+	/** Cambia el byte de control ind, manteniendo la réplica del final. */
+	void ponControl(unsigned int ind, signed char c) {
+		control[ind] = c;
+		if (ind < GRUPO)
+			control[tam + ind] = c;
+	}
+
+	/** Indica si añadir un elemento más supera la ocupación máxima. */
+	bool necesitaAmpliar() const {
+		return 100 * (numElems + 1) > maxOcupacion * tam;
+	}
+
+	/**
+	 * Hash de la clave tras la mezcla final de Hash.h, para que tanto los bits
+	 * bajos (posición) como los altos (huella) dependan de toda la clave aunque
+	 * la función hash sea débil (std::hash<int> es la identidad).
+	 */
+	std::size_t hashMezclado(const Clave &clave) const {
+		return mezcla((std::size_t) hash(clave));
+	}
+
+	/** Huella de 7 bits que se guarda en el byte de control: los bits altos del hash. */
+	static signed char huella(std::size_t h) {
+		return (signed char) (h >> (sizeof(std::size_t) * 8 - 7));
+	}
+
+	/** Posición inicial (sin colisiones) de una clave: los bits bajos del hash. */
+	unsigned int posicionInicial(std::size_t h) const {
+		return (unsigned int) h & (tam - 1);
+	}
+
+	/**
+	 * Devuelve una máscara de bits con las posiciones del grupo que empieza
+	 * en "g" cuyo byte de control es igual a c.
+	 */
+	static unsigned int coincidencias(const signed char *g, signed char c) {
+#ifdef CLOSEDHASHMAP_SSE2
+		__m128i grupo = _mm_loadu_si128(reinterpret_cast<const __m128i*>(g));
+		return (unsigned int) _mm_movemask_epi8(_mm_cmpeq_epi8(grupo, _mm_set1_epi8(c)));
+#else
+		unsigned int ret = 0;
+		for (unsigned int i = 0; i < GRUPO; ++i)
+			if (g[i] == c)
+				ret |= 1u << i;
+		return ret;
+#endif
+	}
+
+	/** Posición del bit a 1 menos significativo de m (m != 0). */
+	static unsigned int primerBit(unsigned int m) {
+#if defined(__GNUC__) || defined(__clang__)
+		return (unsigned int) __builtin_ctz(m);
+#else
+		unsigned int i = 0;
+		while ((m & 1u) == 0) {
+			m >>= 1;
+			++i;
+		}
+		return i;
+#endif
+	}
+
+	/**
+	 * Busca la clave (cuyo hash mezclado es h) en la tabla. Si está devuelve true
+	 * y deja en "ind" su posición. Si no está devuelve false y deja en "ind" la
+	 * posición libre donde habría que insertarla.
+	 * Se examinan los bytes de control de GRUPO en GRUPO: la clave sólo se
+	 * compara en las posiciones cuya huella coincide, y la búsqueda termina en
+	 * el primer grupo que tenga una posición vacía.
+	 * O(k) donde k es la longitud de la secuencia de exploración.
+	 */
+	bool buscaPosicion(const Clave &clave, std::size_t h, unsigned int &ind) const {
+		signed char hu = huella(h);
+		unsigned int pos = posicionInicial(h);
+		while (true) {
+			const signed char *g = control + pos;
+			unsigned int m = coincidencias(g, hu);
+			while (m != 0) {
+				ind = (pos + primerBit(m)) & (tam - 1);
+				if (celdas[ind].clave == clave)
+					return true;
+				m &= m - 1;
+			}
+			unsigned int vacias = coincidencias(g, VACIA);
+			if (vacias != 0) {
+				ind = (pos + primerBit(vacias)) & (tam - 1);
+				return false;
+			}
+			pos = (pos + GRUPO) & (tam - 1);
+		}
+	}
+
+	/**
+	 * Elimina la celda ocupada "ind" y desplaza hacia atrás las celdas
+	 * siguientes de la misma secuencia de exploración, de modo que ninguna
+	 * búsqueda se corte por el hueco que queda.
+	 */
+	void borraCelda(unsigned int ind) {
+		unsigned int hueco = ind;
+		unsigned int sig = (hueco + 1) & (tam - 1);
+		while (control[sig] != VACIA) {
+			// La celda "sig" se puede adelantar al hueco si su posición inicial
+			// no está entre el hueco y ella misma (en orden circular).
+			unsigned int ini = posicionInicial(hashMezclado(celdas[sig].clave));
+			if (((sig - ini) & (tam - 1)) >= ((sig - hueco) & (tam - 1))) {
+				celdas[hueco].~Celda();
+				new (&celdas[hueco]) Celda(std::move(celdas[sig]));
+				ponControl(hueco, control[sig]);
+				hueco = sig;
+			}
+			sig = (sig + 1) & (tam - 1);
+		}
+		celdas[hueco].~Celda();
+		ponControl(hueco, VACIA);
+		numElems--;
+	}
+
+	/** Devuelve la primera celda ocupada a partir de ind (tam si no hay). */
+	unsigned int siguienteOcupada(unsigned int ind) const {
+		while (ind < tam && control[ind] == VACIA)
+			++ind;
+		return ind;
+	}
+
+	/** Duplica el tamaño de la tabla y recoloca todas las celdas. */
+	void amplia() {
+		Celda *celdasAnt = celdas;
+		signed char *controlAnt = control;
+		unsigned int tamAnt = tam;
+		inicia(tam * 2);
+		for (unsigned int i = 0; i < tamAnt; ++i)
+			if (controlAnt[i] != VACIA) {
+				std::size_t h = hashMezclado(celdasAnt[i].clave);
+				unsigned int ind = posicionInicial(h);
+				while (control[ind] != VACIA)
+					ind = (ind + 1) & (tam - 1);
+				new (&celdas[ind]) Celda(std::move(celdasAnt[i]));
+				ponControl(ind, huella(h));
+				celdasAnt[i].~Celda();
+			}
+		::operator delete(celdasAnt);
+		delete[] controlAnt;
+	}
+
+	/**
+	 * Método para dibujar el diccionario. (Usado únicamente paa debuguear).
+	 */
+	void muestra(std::ostream &out) const {
+		bool primero = true;
+		for (unsigned int i = 0; i < tam; i++) {
+			if (control[i] != VACIA) {
+				out << (primero ? " " : ", ");
+				primero = false;
+				out << celdas[i].clave << " -> " << celdas[i].valor;
+			}
+		}
+	}
+
+	/**
+	 * Ocupación máxima por defecto antes de ampliar la tabla en tanto por cientos.
+	 */
+	static const unsigned int MAX_OCUPACION = 80;
+
+	/** Byte de control de una celda vacía (las ocupadas guardan su huella, 0..127). */
+	static const signed char VACIA = -128;
+
+	/** Array de celdas (sólo están construidas las ocupadas) */
+	Celda *celdas;
+
+	/**
+	 * Bytes de control: VACIA o la huella de la clave de cada celda.
+	 * Tiene tam + GRUPO posiciones; las GRUPO últimas replican las primeras.
+	 */
+	signed char *control;
+
+	/** Función hash usada */
+	Hash hash;
+
+	/** Tamaño del array de celdas (potencia de 2) */
+	unsigned int tam;
+
+	/** Número de elementos en la tabla */
+	unsigned int numElems;
+
+	/** Ocupación máxima permitida antes de ampliar la tabla en tanto por cientos */
+	float maxOcupacion;
+};
+
+#endif // __CLOSEDHASHMAP_H
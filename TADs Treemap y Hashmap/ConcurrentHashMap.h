@@ -0,0 +1,280 @@
+/**
+ * Implementación del TAD Diccionario para varios hilos usando tablas hash
+ * fragmentadas.
+ */
+#ifndef __CONCURRENTHASHMAP_H
+#define __CONCURRENTHASHMAP_H
+
+#include <algorithm>
+#include <cstddef>
+#include <mutex>
+#include <shared_mutex>
+#include <stdexcept>
+#include <thread>
+#include <utility>
+#include "Allocators.h"
+#include "Exceptions.h"
+#include "Hash.h"
+#include "HashMap.h"
+
+/**
+ * Implementación del TAD Diccionario que admite que varios hilos lo consulten y
+ * lo modifiquen a la vez.
+ * En vez de proteger una única tabla con un único cerrojo (con el que todos los
+ * hilos acaban esperándose unos a otros), las claves se reparten entre varios
+ * fragmentos, cada uno con su propio HashMap y su propio cerrojo de
+ * lectores/escritores: las operaciones sobre fragmentos distintos no se
+ * esperan nunca, y las consultas sobre un mismo fragmento pueden hacerse a la vez.
+ * El fragmento de una clave se elige con los bits altos de su hash mezclado,
+ * mientras que el HashMap de cada fragmento usa los bits bajos, así que ambos
+ * repartos son independientes.
+ * Cada fragmento crece por su cuenta y con la redimensión incremental de
+ * HashMap, de modo que ampliar la tabla nunca para todo el diccionario: sólo
+ * retrasa un poco las operaciones sobre un fragmento.
+ * Cada fragmento ocupa su propia línea de caché para que los cerrojos de
+ * fragmentos vecinos no se estorben.
+ * Las operaciones son:
+ *    - ConcurrentHashMapVacio: operación generadora que construye un diccionario vacío.
+ *    - Insert(clave, valor): generadora que añade una nueva pareja (clave, valor).
+ *       Si la clave ya estaba se sustituye el valor.
+ *    - erase(clave): operación modificadora. Elimina la clave del diccionario.
+ *       Si la clave no está, la operación no tiene efecto.
+ *    - at(clave): operación observadora que devuelve (una copia de) el valor
+ *       asociado a una clave. Es un error preguntar por una clave que no existe.
+ *    - contains(clave): operación observadora. Sirve para averiguar si una clave
+ *       está presente en el diccionario.
+ *    - update(clave, fn): operación modificadora que aplica fn al valor de la
+ *       clave de forma atómica (ningún otro hilo ve el valor a medias).
+ *    - empty(), size(): operaciones observadoras sobre el tamaño del diccionario.
+ * No hay referencias al valor ni iteradores, porque dejarían de ser válidos en
+ * cuanto otro hilo modificase el diccionario; para recorrerlo está for_each.
+ */
+template <typename Clave, typename Valor, typename Hash = std::hash<Clave>,
+		template <typename> class Asignador = NewAllocator>
+class ConcurrentHashMap {
+private:
+	/** Tamaño de línea de caché que se supone para separar los fragmentos. */
+	static const std::size_t TAM_LINEA = 64;
+
+	/** Un fragmento: una tabla hash y el cerrojo que la protege. */
+	class alignas(TAM_LINEA) Fragmento {
+	public:
+		Fragmento() {
+			mapa.set_incremental_rehash(true);
+		}
+
+		/** Cerrojo de lectores/escritores */
+		mutable std::shared_mutex cerrojo;
+
+		/** Tabla con las claves del fragmento */
+		HashMap<Clave, Valor, Hash, Asignador> mapa;
+	};
+
+	using Lectura = std::shared_lock<std::shared_mutex>;
+	using Escritura = std::unique_lock<std::shared_mutex>;
+
+public:
+
+	/**
+	 * Constructor que implementa ConcurrentHashMapVacio. El número de
+	 * fragmentos se redondea a una potencia de 2; por defecto son
+	 * FRAGMENTOS_POR_HILO por cada hilo que el procesador puede ejecutar a la vez.
+	 * Si se piden más de MAX_FRAGMENTOS se lanza std::length_error.
+	 * O(fragmentos)
+	 */
+	explicit ConcurrentHashMap(unsigned int fragmentos = 0) : frags(nullptr), numFrags(1) {
+		if (fragmentos == 0)
+			fragmentos = FRAGMENTOS_POR_HILO * std::max(1u, std::thread::hardware_concurrency());
+		while (numFrags < fragmentos) {
+			if (numFrags >= MAX_FRAGMENTOS)
+				throw std::length_error("ConcurrentHashMap: demasiados fragmentos");
+			numFrags *= 2;
+		}
+		frags = new Fragmento[numFrags];
+	}
+
+	/** Destructor; elimina todos los fragmentos */
+	~ConcurrentHashMap() {
+		delete[] frags;
+	}
+
+	/**
+	 * Operación generadora que añade una nueva clave/valor.
+	 * Si la clave ya estaba, se sustituye el valor.
+	 * O(k) amortizado donde k es el número de colisiones en el hash.
+	 */
+	void insert(const Clave &clave, const Valor &valor) {
+		Fragmento &f = fragmento(clave);
+		Escritura e(f.cerrojo);
+		f.mapa.insert(clave, valor);
+	}
+
+	/**
+	 * Añade la clave con un valor construido a partir de args si la clave no
+	 * estaba. Devuelve si la clave era nueva.
+	 * O(k) amortizado donde k es el número de colisiones en el hash.
+	 */
+	template <typename... Args>
+	bool try_emplace(const Clave &clave, Args&&... args) {
+		Fragmento &f = fragmento(clave);
+		Escritura e(f.cerrojo);
+		return f.mapa.try_emplace(clave, std::forward<Args>(args)...);
+	}
+
+	/**
+	 * Operación modificadora que elimina una clave.
+	 * Si la clave no existía la operación no tiene efecto.
+	 * O(k) donde k es el número de colisiones en el hash.
+	 */
+	void erase(const Clave &clave) {
+		Fragmento &f = fragmento(clave);
+		Escritura e(f.cerrojo);
+		f.mapa.erase(clave);
+	}
+
+	/**
+	 * Operación observadora que devuelve una copia del valor asociado a una
+	 * clave (una referencia podría quedar colgando si otro hilo la borra).
+	 * Si no existe se lanza una excepción.
+	 * O(k) donde k es el número de colisiones en el hash.
+	 */
+	Valor at(const Clave &clave) const {
+		const Fragmento &f = fragmento(clave);
+		Lectura l(f.cerrojo);
+		return f.mapa.at(clave);
+	}
+
+	/** Operación observadora que indica si una clave aparece. */
+	bool contains(const Clave &clave) const {
+		const Fragmento &f = fragmento(clave);
+		Lectura l(f.cerrojo);
+		return f.mapa.contains(clave);
+	}
+
+	/**
+	 * Aplica fn (que recibe un Valor&) al valor asociado a la clave mientras
+	 * ningún otro hilo puede leer ni modificar su fragmento, de modo que
+	 * operaciones como "leer, sumar uno y escribir" no se pisan entre hilos.
+	 * Devuelve si la clave estaba (si no estaba no se hace nada).
+	 * fn no debe usar este mismo diccionario.
+	 * O(k) donde k es el número de colisiones en el hash, más lo que tarde fn.
+	 */
+	template <typename F>
+	bool update(const Clave &clave, F fn) {
+		Fragmento &f = fragmento(clave);
+		Escritura e(f.cerrojo);
+		auto it = f.mapa.find(clave);
+		if (it == f.mapa.end())
+			return false;
+		fn(it.value());
+		return true;
+	}
+
+	/**
+	 * Como update, pero si la clave no estaba se inserta con el valor inicial
+	 * (y no se llama a fn). Todo ello de forma atómica.
+	 * O(k) amortizado donde k es el número de colisiones en el hash.
+	 */
+	template <typename F>
+	void upsert(const Clave &clave, const Valor &inicial, F fn) {
+		Fragmento &f = fragmento(clave);
+		Escritura e(f.cerrojo);
+		auto it = f.mapa.find(clave);
+		if (it == f.mapa.end())
+			f.mapa.insert(clave, inicial);
+		else
+			fn(it.value());
+	}
+
+	/**
+	 * Número de elementos. Con otros hilos modificando el diccionario el
+	 * resultado es aproximado: cada fragmento se cuenta en un instante distinto.
+	 * O(fragmentos)
+	 */
+	int size() const {
+		int ret = 0;
+		for (unsigned int i = 0; i < numFrags; ++i) {
+			Lectura l(frags[i].cerrojo);
+			ret += frags[i].mapa.size();
+		}
+		return ret;
+	}
+
+	/** Indica si el diccionario es vacío (con la misma salvedad que size). */
+	bool empty() const {
+		for (unsigned int i = 0; i < numFrags; ++i) {
+			Lectura l(frags[i].cerrojo);
+			if (!frags[i].mapa.empty())
+				return false;
+		}
+		return true;
+	}
+
+	/**
+	 * Reserva espacio para n elementos repartidos entre los fragmentos, para
+	 * que ninguno tenga que ampliarse mientras se llenan.
+	 * O(n)
+	 */
+	void reserve(unsigned int n) {
+		unsigned int porFragmento = n / numFrags + 1;
+		for (unsigned int i = 0; i < numFrags; ++i) {
+			Escritura e(frags[i].cerrojo);
+			frags[i].mapa.reserve(porFragmento);
+		}
+	}
+
+	/**
+	 * Llama a fn(clave, valor) con cada pareja del diccionario, fragmento a
+	 * fragmento. Mientras se recorre un fragmento los demás hilos pueden
+	 * consultarlo pero no modificarlo, así que cada fragmento se ve entero y
+	 * coherente, aunque el conjunto no sea una foto de un único instante.
+	 * fn no debe modificar este mismo diccionario.
+	 * O(n + cubetas)
+	 */
+	template <typename F>
+	void for_each(F fn) const {
+		for (unsigned int i = 0; i < numFrags; ++i) {
+			Lectura l(frags[i].cerrojo);
+			for (auto it = frags[i].mapa.cbegin(); it != frags[i].mapa.cend(); ++it)
+				fn(it.key(), it.value());
+		}
+	}
+
+	/** Número de fragmentos. O(1) */
+	unsigned int shard_count() const {
+		return numFrags;
+	}
+
+	// Copiar o mover el diccionario mientras otros hilos lo usan no tendría
+	// sentido, así que no se permite.
+	ConcurrentHashMap(const ConcurrentHashMap &other) = delete;
+	ConcurrentHashMap &operator=(const ConcurrentHashMap &other) = delete;
+
+private:
+
+	/**
+	 * Fragmento que le corresponde a una clave: los bits altos de su hash
+	 * mezclado (el HashMap del fragmento usará los bajos).
+	 */
+	Fragmento &fragmento(const Clave &clave) const {
+		std::size_t h = mezcla((std::size_t) hash(clave));
+		return frags[(h >> (4 * sizeof(std::size_t))) & (numFrags - 1)];
+	}
+
+	/** Fragmentos por defecto por cada hilo del procesador */
+	static const unsigned int FRAGMENTOS_POR_HILO = 4;
+
+	/** Mayor número de fragmentos: la mayor potencia de 2 que cabe en un unsigned int. */
+	static const unsigned int MAX_FRAGMENTOS = 1u << (8 * sizeof(unsigned int) - 1);
+
+	/** Array de fragmentos */
+	Fragmento *frags;
+
+	/** Número de fragmentos (potencia de 2) */
+	unsigned int numFrags;
+
+	/** Función hash usada para elegir el fragmento */
+	Hash hash;
+};
+
+#endif // __CONCURRENTHASHMAP_H
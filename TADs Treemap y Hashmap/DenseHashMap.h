@@ -0,0 +1,496 @@
+/**
+ * Implementación del TAD Diccionario usando una tabla hash con las entradas
+ * guardadas de forma compacta.
+ * Basada en la implementación de HashMap de Antonio Sánchez Ruiz-Granados
+ * e Ignacio Fábregas.
+ */
+#ifndef __DENSEHASHMAP_H
+#define __DENSEHASHMAP_H
+
+#include <cstddef>
+#include <iostream>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+#include "Exceptions.h"
+#include "Hash.h"
+
+/**
+ * Implementación del TAD Diccionario usando una tabla hash abierta en la que
+ * las parejas (clave, valor) no están en nodos sueltos sino todas seguidas en
+ * un vector de entradas, sin huecos. Las listas de colisiones se enlazan con
+ * índices dentro de ese vector, y la tabla sólo guarda, para cada lista, el
+ * índice de su primera entrada.
+ * Así recorrer el diccionario es recorrer un vector de principio a fin (sin
+ * pasar por las listas vacías ni saltar de nodo en nodo), y el orden del
+ * recorrido es siempre el mismo para las mismas operaciones: el orden de
+ * inserción, salvo que al borrar una entrada su hueco lo ocupa la última.
+ * Cada entrada guarda el hash de su clave, de modo que al ampliar la tabla
+ * no hay que volver a calcularlo y las búsquedas sólo comparan claves cuando
+ * los hash coinciden.
+ * Ofrece las mismas operaciones que HashMap:
+ *    - DenseHashMapVacio: operación generadora que construye una tabla vacía
+ *    - Insert(clave, valor): generadora que añade una nueva pareja (clave, valor)
+ *       a la tabla. Si la clave ya estaba se sustituye el valor.
+ *    - erase(clave): operación modificadora. Elimina la clave de la tabla.
+ *       Si la clave no está, la operación no tiene efecto.
+ *    - at(clave): operación observadora que devuelve el valor asociado a una clave.
+ *       Es un error preguntar por una clave que no existe.
+ *    - contains(clave): operación observadora. Sirve para averiguar si una clave
+ *       está presente en la tabla.
+ *    - empty(): operación observadora que indica si la tabla tiene alguna clave introducida.
+ *    - size(): operación observadora que indica el tamaño del diccionario.
+ * El tamaño de la tabla es siempre una potencia de 2, por lo que el índice se
+ * obtiene con una máscara en vez de con el módulo.
+ * Cualquier inserción o borrado puede invalidar los iteradores y las
+ * referencias a los valores.
+ */
+template <typename Clave, typename Valor, typename Hash = std::hash<Clave>>
+class DenseHashMap {
+private:
+	/** Entrada del vector: la pareja, el hash de la clave y la siguiente de su lista. */
+	class Entrada {
+	public:
+		template <typename C, typename... Args>
+		Entrada(std::size_t hash, unsigned int sig, C &&clave, Args&&... args) :
+				clave(std::forward<C>(clave)), valor(std::forward<Args>(args)...),
+				hash(hash), sig(sig) {}
+
+		/** Clave */
+		Clave clave;
+
+		/** Valor */
+		Valor valor;
+
+		/** Hash (ya mezclado) de la clave */
+		std::size_t hash;
+
+		/** Índice de la siguiente entrada de la lista (NINGUNA si es la última) */
+		unsigned int sig;
+	};
+
+	/** Índice que indica que no hay entrada (fin de lista o lista vacía). */
+	static constexpr unsigned int NINGUNA = ~0u;
+
+public:
+
+	/** Tamaño inicial de la tabla. */
+	static const unsigned int TAM_INICIAL = 8;
+
+	/** Constructor por defecto que implementa DenseHashMapVacio. O(1) */
+	DenseHashMap() : cubetas(TAM_INICIAL, NINGUNA) {}
+
+	/**
+	 * Constructor de una tabla vacía con espacio para numEsperado elementos:
+	 * se pueden insertar todos sin que la tabla tenga que ampliarse.
+	 * Si harían falta más de TAM_MAXIMO listas se lanza std::length_error.
+	 * O(numEsperado)
+	 */
+	explicit DenseHashMap(unsigned int numEsperado) : cubetas(cubetasPara(numEsperado), NINGUNA) {
+		entradas.reserve(numEsperado);
+	}
+
+	/**
+	 * Operación generadora que añade una nueva clave/valor a la tabla.
+	 * Si la clave ya estaba, se sustituye el valor.
+	 * O(k) amortizado donde k es el número de colisiones en el hash.
+	 */
+	void insert(const Clave &clave, const Valor &valor) {
+		bool insertado;
+		unsigned int i = buscaOInserta(clave, insertado, valor);
+		if (!insertado)
+			entradas[i].valor = valor;
+	}
+
+	/**
+	 * Añade la clave con un valor construido a partir de args.
+	 * Si la clave ya estaba no se hace nada (y no se construye ningún valor).
+	 * Devuelve si la clave era nueva.
+	 * O(k) amortizado donde k es el número de colisiones en el hash.
+	 */
+	template <typename... Args>
+	bool try_emplace(const Clave &clave, Args&&... args) {
+		bool insertado;
+		buscaOInserta(clave, insertado, std::forward<Args>(args)...);
+		return insertado;
+	}
+
+	/**
+	 * Operación modificadora que elimina una clave de la tabla.
+	 * Si la clave no existía la operación no tiene efecto.
+	 * La última entrada del vector pasa a ocupar su hueco.
+	 * O(k) donde k es el número de colisiones en el hash.
+	 */
+	void erase(const Clave &clave) {
+		unsigned int i = localiza(clave, hashDe(clave));
+		if (i != NINGUNA)
+			borraEntrada(i);
+	}
+
+	/**
+	 * Operación observadora que devuelve el valor asociado a una clave.
+	 * Si no existe se lanza una excepción.
+	 * O(k) donde k es el número de colisiones en el hash.
+	 */
+	const Valor &at(const Clave &clave) const {
+		unsigned int i = localiza(clave, hashDe(clave));
+		if (i == NINGUNA)
+			throw EClaveErronea();
+		return entradas[i].valor;
+	}
+
+	/** Operación observadora que indica si una clave aparece. */
+	bool contains(const Clave &clave) const {
+		return localiza(clave, hashDe(clave)) != NINGUNA;
+	}
+
+	/** Operación observadora que devuelve si el diccionario es vacío. O(1) */
+	bool empty() const {
+		return entradas.empty();
+	}
+
+	/** Operación observadora que devuelve el tamaño del diccionario. O(1) */
+	int size() const {
+		return (int) entradas.size();
+	}
+
+	/** Número de listas (cubetas) de la tabla. O(1) */
+	unsigned int bucket_count() const {
+		return (unsigned int) cubetas.size();
+	}
+
+	/** Ocupación actual: número medio de elementos por lista. O(1) */
+	float load_factor() const {
+		if (cubetas.empty())
+			return 0;
+		return ((float) entradas.size()) / cubetas.size();
+	}
+
+	/**
+	 * Reserva espacio para n elementos: se pueden insertar hasta tener n sin
+	 * que la tabla ni el vector de entradas tengan que ampliarse.
+	 * Si harían falta más de TAM_MAXIMO listas se lanza std::length_error.
+	 * O(n) si hay que redimensionar y O(1) si no.
+	 */
+	void reserve(unsigned int n) {
+		unsigned int nuevoTam = cubetasPara(n);
+		entradas.reserve(n);
+		if (nuevoTam > cubetas.size())
+			redimensiona(nuevoTam);
+	}
+
+	/**
+	 * Sobrecarga del operador [] que permite acceder al valor asociado
+	 * a una clave y modificarlo. Si el elemento buscado no estaba, se inserta uno
+	 * con el valor por defecto del tipo Valor.
+	 * O(k) amortizado donde k es el número de colisiones en el hash.
+	 */
+	Valor &operator[](const Clave &clave) {
+		bool insertado;
+		return entradas[buscaOInserta(clave, insertado)].valor;
+	}
+
+	/** Dibujo del diccionario: Uso únicamente para debugear durante clase */
+	friend std::ostream& operator<<(std::ostream& o, const DenseHashMap& t) {
+		o << "{";
+		for (std::size_t i = 0; i < t.entradas.size(); ++i) {
+			o << (i == 0 ? " " : ", ");
+			o << t.entradas[i].clave << " -> " << t.entradas[i].valor;
+		}
+		o << "}";
+		return o;
+	}
+
+	// //
+	// ITERADOR CONSTANTE Y FUNCIONES RELACIONADAS
+	// //
+
+	/**
+	 * Clase interna que implementa un iterador que permite recorrer la tabla
+	 * pero no modificarla. Basta con la posición en el vector de entradas.
+	 */
+	class ConstIterator {
+	public:
+		ConstIterator() : tabla(nullptr), pos(0) {}
+
+		void next() {
+			if (tabla == nullptr || pos == tabla->entradas.size())
+				throw InvalidAccessException();
+			++pos;
+		}
+
+		const Clave &key() const {
+			if (tabla == nullptr || pos == tabla->entradas.size())
+				throw InvalidAccessException();
+			return tabla->entradas[pos].clave;
+		}
+
+		const Valor &value() const {
+			if (tabla == nullptr || pos == tabla->entradas.size())
+				throw InvalidAccessException();
+			return tabla->entradas[pos].valor;
+		}
+
+		bool operator==(const ConstIterator &other) const {
+			return tabla == other.tabla && pos == other.pos;
+		}
+
+		bool operator!=(const ConstIterator &other) const {
+			return !(this->operator==(other));
+		}
+
+		ConstIterator &operator++() {
+			next();
+			return *this;
+		}
+
+		ConstIterator operator++(int) {
+			ConstIterator ret(*this);
+			operator++();
+			return ret;
+		}
+
+	protected:
+		friend class DenseHashMap;
+
+		ConstIterator(const DenseHashMap *tabla, std::size_t pos) : tabla(tabla), pos(pos) {}
+
+		/** Puntero a la tabla que se está recorriendo */
+		const DenseHashMap *tabla;
+
+		/** Posición de la entrada actual (el número de entradas al final) */
+		std::size_t pos;
+	};
+
+	/** Devuelve un iterador constante al principio del diccionario. O(1) */
+	ConstIterator cbegin() const {
+		return ConstIterator(this, 0);
+	}
+
+	/** Devuelve un iterador constante al final del recorrido. O(1) */
+	ConstIterator cend() const {
+		return ConstIterator(this, entradas.size());
+	}
+
+	/**
+	 * Devuelve un iterador a la posición de la clave.
+	 * Si no existe la clave devuelve un iterador al final.
+	 */
+	ConstIterator find(const Clave &clave) const {
+		unsigned int i = localiza(clave, hashDe(clave));
+		return i == NINGUNA ? cend() : ConstIterator(this, i);
+	}
+
+	// //
+	// ITERADOR NO CONSTANTE Y FUNCIONES RELACIONADAS
+	// //
+
+	/**
+	 * Clase interna que implementa un iterador que permite recorrer la tabla
+	 * y modificar los valores (no las claves).
+	 */
+	class Iterator {
+	public:
+		Iterator() : tabla(nullptr), pos(0) {}
+
+		void next() {
+			if (tabla == nullptr || pos == tabla->entradas.size())
+				throw InvalidAccessException();
+			++pos;
+		}
+
+		const Clave &key() const {
+			if (tabla == nullptr || pos == tabla->entradas.size())
+				throw InvalidAccessException();
+			return tabla->entradas[pos].clave;
+		}
+
+		Valor &value() const {
+			if (tabla == nullptr || pos == tabla->entradas.size())
+				throw InvalidAccessException();
+			return tabla->entradas[pos].valor;
+		}
+
+		bool operator==(const Iterator &other) const {
+			return tabla == other.tabla && pos == other.pos;
+		}
+
+		bool operator!=(const Iterator &other) const {
+			return !(this->operator==(other));
+		}
+
+		Iterator &operator++() {
+			next();
+			return *this;
+		}
+
+		Iterator operator++(int) {
+			Iterator ret(*this);
+			operator++();
+			return ret;
+		}
+
+	protected:
+		friend class DenseHashMap;
+
+		Iterator(DenseHashMap *tabla, std::size_t pos) : tabla(tabla), pos(pos) {}
+
+		/** Puntero a la tabla que se está recorriendo */
+		DenseHashMap *tabla;
+
+		/** Posición de la entrada actual (el número de entradas al final) */
+		std::size_t pos;
+	};
+
+	/** Devuelve un iterador al principio del diccionario. O(1) */
+	Iterator begin() {
+		return Iterator(this, 0);
+	}
+
+	/** Devuelve un iterador al final del recorrido. O(1) */
+	Iterator end() {
+		return Iterator(this, entradas.size());
+	}
+
+	/**
+	 * Devuelve un iterador a la posición de la clave.
+	 * Si no existe la clave devuelve un iterador al final.
+	 */
+	Iterator find(const Clave &clave) {
+		unsigned int i = localiza(clave, hashDe(clave));
+		return i == NINGUNA ? end() : Iterator(this, i);
+	}
+
+	/**
+	 * Elimina la entrada a la que apunta it. Su hueco lo ocupa la última
+	 * entrada, así que el iterador devuelto (el mismo it) apunta a ella y un
+	 * recorrido que borra sobre la marcha sigue viendo todas las entradas.
+	 * O(k) donde k es el número de colisiones en el hash.
+	 */
+	Iterator erase(Iterator it) {
+		if (it.tabla != this || it.pos == entradas.size())
+			throw InvalidAccessException();
+		borraEntrada((unsigned int) it.pos);
+		return it;
+	}
+
+private:
+
+	/**
+	 * Busca la clave (cuyo hash mezclado es h) y devuelve el índice de su
+	 * entrada, o NINGUNA si no está.
+	 */
+	unsigned int localiza(const Clave &clave, std::size_t h) const {
+		if (entradas.empty())
+			return NINGUNA;
+		unsigned int i = cubetas[h & (cubetas.size() - 1)];
+		while (i != NINGUNA && !(entradas[i].hash == h && entradas[i].clave == clave))
+			i = entradas[i].sig;
+		return i;
+	}
+
+	/**
+	 * Busca la clave y, si no está, la añade al final del vector con un valor
+	 * construido con args (sin args, el valor por defecto). Devuelve el índice
+	 * de la entrada y deja en "insertado" si era nueva.
+	 * O(k) amortizado donde k es el número de colisiones en el hash.
+	 */
+	template <typename... Args>
+	unsigned int buscaOInserta(const Clave &clave, bool &insertado, Args&&... args) {
+		std::size_t h = hashDe(clave);
+		unsigned int i = localiza(clave, h);
+		insertado = i == NINGUNA;
+		if (insertado) {
+			if (cubetas.empty()) // la tabla se movió a otra
+				cubetas.assign(TAM_INICIAL, NINGUNA);
+			else if (100 * (double) (entradas.size() + 1) > MAX_OCUPACION * (double) cubetas.size())
+				redimensiona(doble((unsigned int) cubetas.size()));
+			unsigned int &lista = cubetas[h & (cubetas.size() - 1)];
+			i = (unsigned int) entradas.size();
+			entradas.emplace_back(h, lista, clave, std::forward<Args>(args)...);
+			lista = i;
+		}
+		return i;
+	}
+
+	/**
+	 * Saca la entrada i de su lista y lleva la última entrada del vector a su
+	 * hueco, corrigiendo el índice que apuntaba a ella.
+	 */
+	void borraEntrada(unsigned int i) {
+		*enlaceA(i) = entradas[i].sig;
+		unsigned int ultima = (unsigned int) entradas.size() - 1;
+		if (i != ultima) {
+			*enlaceA(ultima) = i;
+			entradas[i] = std::move(entradas[ultima]);
+		}
+		entradas.pop_back();
+	}
+
+	/** Índice (de la tabla o de la entrada anterior) que apunta a la entrada i. */
+	unsigned int *enlaceA(unsigned int i) {
+		unsigned int *enlace = &cubetas[entradas[i].hash & (cubetas.size() - 1)];
+		while (*enlace != i)
+			enlace = &entradas[*enlace].sig;
+		return enlace;
+	}
+
+	/**
+	 * Cambia la tabla por una de nuevoTam listas (potencia de 2) y vuelve a
+	 * enlazar las entradas usando el hash que ya guardan. Las entradas no se
+	 * mueven. O(n + nuevoTam)
+	 */
+	void redimensiona(unsigned int nuevoTam) {
+		cubetas.assign(nuevoTam, NINGUNA);
+		for (unsigned int i = 0; i < entradas.size(); ++i) {
+			unsigned int &lista = cubetas[entradas[i].hash & (nuevoTam - 1)];
+			entradas[i].sig = lista;
+			lista = i;
+		}
+	}
+
+	/**
+	 * Menor tamaño de la tabla (potencia de 2, no menor que TAM_INICIAL) en el
+	 * que caben n elementos sin superar la ocupación máxima.
+	 */
+	static unsigned int cubetasPara(unsigned int n) {
+		unsigned int ret = TAM_INICIAL;
+		while (100 * (double) n > MAX_OCUPACION * (double) ret)
+			ret = doble(ret);
+		return ret;
+	}
+
+	/**
+	 * Doble de un tamaño de la tabla. Más allá de TAM_MAXIMO el tamaño ya no
+	 * cabe en un unsigned int, así que se lanza std::length_error.
+	 */
+	static unsigned int doble(unsigned int t) {
+		if (t >= TAM_MAXIMO)
+			throw std::length_error("DenseHashMap: demasiadas listas");
+		return t * 2;
+	}
+
+	/** Resultado de la función hash para la clave, ya mezclado (ver HashMap). */
+	std::size_t hashDe(const Clave &clave) const {
+		return mezcla((std::size_t) hash(clave));
+	}
+
+	/**
+	 * Ocupación máxima antes de ampliar la tabla en tanto por cientos.
+	 */
+	static const unsigned int MAX_OCUPACION = 80;
+
+	/** Mayor tamaño de la tabla: la mayor potencia de 2 que cabe en un unsigned int. */
+	static const unsigned int TAM_MAXIMO = 1u << (8 * sizeof(unsigned int) - 1);
+
+	/** Entradas del diccionario, seguidas y sin huecos */
+	std::vector<Entrada> entradas;
+
+	/** Índice de la primera entrada de cada lista (NINGUNA si está vacía) */
+	std::vector<unsigned int> cubetas;
+
+	/** Función hash usada */
+	Hash hash;
+};
+
+#endif // __DENSEHASHMAP_H
@@ -0,0 +1,504 @@
+/**
+ * Implementación del TAD Dictionary utilizando vectores ordenados.
+ */
+
+#ifndef __FLATMAP_H
+#define __FLATMAP_H
+
+#include <algorithm>
+#include <functional>
+#include <iostream>
+#include <utility>
+#include <vector>
+#include "Exceptions.h"
+#include "FlatSet.h"
+
+/**
+ * Implementación del TAD Dictionary utilizando un vector de claves ordenado y
+ * sin repetidos y, en paralelo, un vector con el valor de cada clave.
+ * Pensado para diccionarios que se construyen una vez (o a bloques) y después
+ * sobre todo se consultan: no hay nodos ni punteros, así que ocupa mucho menos
+ * que un TreeMap, y como las búsquedas sólo recorren el vector de claves (sin
+ * mezclar los valores entre medias) caben más claves en cada línea de caché.
+ * La búsqueda es la búsqueda binaria sin saltos de FlatSet.h.
+ * A cambio, insertar o borrar una clave suelta es O(n) porque hay que desplazar
+ * las que van detrás.
+ * Se añade un comparador entre claves: objeto función que acepta dos valores de tipo T y devuelve si el
+ *          primero es menor que el segundo. Por defecto se toma el "<" en T si está definido
+ * Las operaciones son:
+ *    - FlatMapVacio: operación generadora que construye un diccionario vacío.
+ *    - Insert(clave, valor): generadora que añade una nueva pareja (clave, valor) al diccionario.
+ *          Si la clave ya estaba se sustituye el valor.
+ *    - erase(clave): operación modificadora. Elimina la clave del diccionario.
+ *          Si la clave no está la operación no tiene efecto.
+ *    - at(clave): operación observadora que devuelve el valor asociado a una clave.
+ *          Es un error preguntar por una clave que no existe.
+ *    - contains(clave): operación observadora. Sirve para averiguar si se ha introducido una
+ *          clave en el diccionario
+ *    - empty(): operación observadora que indica si el diccionario tiene alguna clave introducida.
+ *    - size(): operación observadora que indica el tamaño del diccionario.
+ * Un diccionario se construye de golpe a partir de un rango de parejas
+ * (clave, valor), esté o no ordenado (se ordena y, si una clave se repite, se
+ * queda el último valor), e insert_sorted añade un bloque de parejas
+ * mezclándolo con las que ya había en O(n + m).
+ * Cualquier inserción o borrado invalida los iteradores.
+ */
+template <typename Clave, typename Valor, typename Comparador = std::less<Clave>>
+class FlatMap {
+private:
+	/**
+	 * Los valores se guardan envueltos en una celda para que cada uno sea un
+	 * objeto con su propia dirección aunque Valor sea bool (std::vector<bool>
+	 * guarda bits sueltos y no puede devolver un bool&).
+	 */
+	class Celda {
+	public:
+		Celda() : valor() {}
+		Celda(const Valor &valor) : valor(valor) {}
+		Celda(Valor &&valor) : valor(std::move(valor)) {}
+
+		Valor valor;
+	};
+
+public:
+
+	/** Constructor; operación FlatMapVacio. O(1) */
+	FlatMap() {}
+
+	/**
+	 * Constructor a partir de un rango [ini, fin) de parejas (clave, valor),
+	 * en cualquier orden. Si una clave aparece varias veces se queda con el
+	 * último valor, como si se hubieran insertado una a una.
+	 * O(n) si el rango está ordenado por clave; O(n log n) si no lo está.
+	 */
+	template <typename It>
+	FlatMap(It ini, It fin) {
+		std::vector<std::pair<Clave, Valor>> parejas(ini, fin);
+		normaliza(parejas);
+		claves.reserve(parejas.size());
+		valores.reserve(parejas.size());
+		for (std::pair<Clave, Valor> &p : parejas) {
+			claves.push_back(std::move(p.first));
+			valores.push_back(std::move(p.second));
+		}
+	}
+
+	/**
+	 * Operación generadora que añade una nueva clave/valor al diccionario.
+	 * Si la clave ya estaba se sustituye el valor.
+	 * O(log n) si la clave ya estaba; O(n) si no.
+	 */
+	void insert(const Clave &clave, const Valor &valor) {
+		int pos = posicion(clave);
+		if (pos < size() && !cless(clave, claves[pos]))
+			valores[pos].valor = valor;
+		else {
+			claves.insert(claves.begin() + pos, clave);
+			valores.insert(valores.begin() + pos, valor);
+		}
+	}
+
+	/**
+	 * Añade todas las parejas (clave, valor) del rango [ini, fin). Como en
+	 * insert, si una clave ya estaba se sustituye su valor. Se ordenan (si no
+	 * lo estaban) y se mezclan con las del diccionario de una sola vez, en vez
+	 * de desplazar las claves una vez por cada inserción.
+	 * O(n + m) siendo m el tamaño del rango (O(n + m log m) si no está ordenado).
+	 */
+	template <typename It>
+	void insert_sorted(It ini, It fin) {
+		std::vector<std::pair<Clave, Valor>> nuevas(ini, fin);
+		normaliza(nuevas);
+		std::vector<Clave> resClaves;
+		std::vector<Celda> resValores;
+		resClaves.reserve(claves.size() + nuevas.size());
+		resValores.reserve(claves.size() + nuevas.size());
+		std::size_t i = 0, j = 0;
+		while (i < claves.size() || j < nuevas.size()) {
+			if (j == nuevas.size() || (i < claves.size() && cless(claves[i], nuevas[j].first))) {
+				resClaves.push_back(std::move(claves[i]));
+				resValores.push_back(std::move(valores[i]));
+				++i;
+			}
+			else {
+				// La nueva va antes o sustituye a la que había con la misma clave
+				if (i < claves.size() && !cless(nuevas[j].first, claves[i]))
+					++i;
+				resClaves.push_back(std::move(nuevas[j].first));
+				resValores.push_back(std::move(nuevas[j].second));
+				++j;
+			}
+		}
+		claves.swap(resClaves);
+		valores.swap(resValores);
+	}
+
+	/**
+	 * Operación modificadora que elimina una clave del diccionario.
+	 * Si la clave no existía la operación no tiene efecto.
+	 * O(n)
+	 */
+	void erase(const Clave &clave) {
+		int pos = posicion(clave);
+		if (pos < size() && !cless(clave, claves[pos])) {
+			claves.erase(claves.begin() + pos);
+			valores.erase(valores.begin() + pos);
+		}
+	}
+
+	/**
+	 * Operación observadora que devuelve el valor asociado
+	 * a una clave dada. O(log n)
+	 */
+	const Valor &at(const Clave &clave) const {
+		int pos = posicion(clave);
+		if (pos == size() || cless(clave, claves[pos]))
+			throw EClaveErronea();
+		return valores[pos].valor;
+	}
+
+	/**
+	 * Operación observadora que permite averiguar si una clave
+	 * determinada está en el diccionario. O(log n)
+	 */
+	bool contains(const Clave &clave) const {
+		int pos = posicion(clave);
+		return pos < size() && !cless(clave, claves[pos]);
+	}
+
+	/** Operación observadora que devuelve si un diccionario es vacío */
+	bool empty() const {
+		return claves.empty();
+	}
+
+	/** Operación observadora que devuelve el número de elementos del diccionario */
+	int size() const {
+		return (int) claves.size();
+	}
+
+	/**
+	 * Sobrecarga del operador [] que permite acceder al valor asociado a una clave y modificarlo.
+	 * Si el elemento buscado no estaba, se inserta uno con el valor por defecto del tipo Valor.
+	 * O(log n) si la clave ya estaba; O(n) si no.
+	 */
+	Valor &operator[](const Clave &clave) {
+		int pos = posicion(clave);
+		if (pos == size() || cless(clave, claves[pos])) {
+			claves.insert(claves.begin() + pos, clave);
+			valores.insert(valores.begin() + pos, Valor());
+		}
+		return valores[pos].valor;
+	}
+
+	/** Dibujo del diccionario: Uso únicamente para debugear durante clase */
+	friend std::ostream& operator<<(std::ostream& o, const FlatMap& t) {
+		o << "{";
+		for (int i = 0; i < t.size(); ++i) {
+			if (i > 0)
+				o << ", ";
+			o << t.claves[i] << " -> " << t.valores[i].valor;
+		}
+		o << "}";
+		return o;
+	}
+
+
+	// //
+	// ITERADOR CONSTANTE Y FUNCIONES RELACIONADAS
+	// //
+
+	/**
+	 * Clase interna que implementa un iterador que permite
+	 * recorrer el diccionario pero no modificarlo.
+	 * Basta con la posición de la clave actual en el vector.
+	 */
+	class ConstIterator {
+	public:
+		ConstIterator() : mapa(nullptr), pos(0) {}
+
+		/** Avanza a la siguiente clave. O(1) */
+		void next() {
+			if (mapa == nullptr || pos == mapa->size())
+				throw InvalidAccessException();
+			++pos;
+		}
+
+		/** Retrocede a la clave anterior. Desde la primera se pasa al final. O(1) */
+		void prev() {
+			if (mapa == nullptr || pos == mapa->size())
+				throw InvalidAccessException();
+			pos = pos == 0 ? mapa->size() : pos - 1;
+		}
+
+		/** O(1) */
+		const Clave &key() const {
+			if (mapa == nullptr || pos == mapa->size()) throw InvalidAccessException();
+			return mapa->claves[pos];
+		}
+
+		/** O(1) */
+		const Valor &value() const {
+			if (mapa == nullptr || pos == mapa->size()) throw InvalidAccessException();
+			return mapa->valores[pos].valor;
+		}
+
+		/** O(1) */
+		bool operator==(const ConstIterator &other) const {
+			return mapa == other.mapa && pos == other.pos;
+		}
+
+		/** O(1) */
+		bool operator!=(const ConstIterator &other) const {
+			return !(this->operator==(other));
+		}
+
+		ConstIterator &operator++() {
+			next();
+			return *this;
+		}
+
+		ConstIterator operator++(int) {
+			ConstIterator ret(*this);
+			operator++();
+			return ret;
+		}
+
+		ConstIterator &operator--() {
+			prev();
+			return *this;
+		}
+
+		ConstIterator operator--(int) {
+			ConstIterator ret(*this);
+			operator--();
+			return ret;
+		}
+
+	protected:
+		friend class FlatMap;
+
+		ConstIterator(const FlatMap *mapa, int pos) : mapa(mapa), pos(pos) {}
+
+		/** Diccionario que se recorre */
+		const FlatMap *mapa;
+
+		/** Posición de la clave actual (size() al final) */
+		int pos;
+	};
+
+	/** Devuelve el iterador constante al principio del diccionario (clave más pequeña). O(1) */
+	ConstIterator cbegin() const {
+		return ConstIterator(this, 0);
+	}
+
+	/** Devuelve un iterador constante al final del recorrido (fuera de éste). O(1) */
+	ConstIterator cend() const {
+		return ConstIterator(this, size());
+	}
+
+	/** Devuelve el iterador constante a la última clave (cend si es vacío). O(1) */
+	ConstIterator clast() const {
+		return ConstIterator(this, empty() ? 0 : size() - 1);
+	}
+
+	/** Devuelve un iterador constante a la clave c, o cend si no está. O(log n) */
+	ConstIterator find(const Clave &c) const {
+		int pos = posicion(c);
+		if (pos < size() && !cless(c, claves[pos]))
+			return ConstIterator(this, pos);
+		return cend();
+	}
+
+	/** Iterador constante a la primera clave mayor o igual que c (cend si no hay). O(log n) */
+	ConstIterator lower_bound(const Clave &c) const {
+		return ConstIterator(this, posicion(c));
+	}
+
+	/** Iterador constante a la primera clave estrictamente mayor que c (cend si no hay). O(log n) */
+	ConstIterator upper_bound(const Clave &c) const {
+		return ConstIterator(this, posicionMayor(c));
+	}
+
+
+	// //
+	// ITERADOR NO CONSTANTE Y FUNCIONES RELACIONADAS
+	// //
+
+	/**
+	 * Clase interna que implementa un iterador que permite
+	 * recorrer el diccionario y cambiar los valores (no las claves).
+	 */
+	class Iterator {
+	public:
+		Iterator() : mapa(nullptr), pos(0) {}
+
+		/** Avanza a la siguiente clave. O(1) */
+		void next() {
+			if (mapa == nullptr || pos == mapa->size())
+				throw InvalidAccessException();
+			++pos;
+		}
+
+		/** Retrocede a la clave anterior. Desde la primera se pasa al final. O(1) */
+		void prev() {
+			if (mapa == nullptr || pos == mapa->size())
+				throw InvalidAccessException();
+			pos = pos == 0 ? mapa->size() : pos - 1;
+		}
+
+		/** O(1) */
+		const Clave &key() const {
+			if (mapa == nullptr || pos == mapa->size()) throw InvalidAccessException();
+			return mapa->claves[pos];
+		}
+
+		/** O(1) */
+		Valor &value() const {
+			if (mapa == nullptr || pos == mapa->size()) throw InvalidAccessException();
+			return mapa->valores[pos].valor;
+		}
+
+		/** O(1) */
+		bool operator==(const Iterator &other) const {
+			return mapa == other.mapa && pos == other.pos;
+		}
+
+		/** O(1) */
+		bool operator!=(const Iterator &other) const {
+			return !(this->operator==(other));
+		}
+
+		Iterator &operator++() {
+			next();
+			return *this;
+		}
+
+		Iterator operator++(int) {
+			Iterator ret(*this);
+			operator++();
+			return ret;
+		}
+
+		Iterator &operator--() {
+			prev();
+			return *this;
+		}
+
+		Iterator operator--(int) {
+			Iterator ret(*this);
+			operator--();
+			return ret;
+		}
+
+	protected:
+		friend class FlatMap;
+
+		Iterator(FlatMap *mapa, int pos) : mapa(mapa), pos(pos) {}
+
+		/** Diccionario que se recorre */
+		FlatMap *mapa;
+
+		/** Posición de la clave actual (size() al final) */
+		int pos;
+	};
+
+	/** Devuelve el iterador al principio del diccionario (clave más pequeña). O(1) */
+	Iterator begin() {
+		return Iterator(this, 0);
+	}
+
+	/** Devuelve un iterador al final del recorrido (fuera de éste). O(1) */
+	Iterator end() {
+		return Iterator(this, size());
+	}
+
+	/** Devuelve el iterador a la última clave (end si es vacío). O(1) */
+	Iterator last() {
+		return Iterator(this, empty() ? 0 : size() - 1);
+	}
+
+	/** Devuelve un iterador a la clave c, o end si no está. O(log n) */
+	Iterator find(const Clave &c) {
+		int pos = posicion(c);
+		if (pos < size() && !cless(c, claves[pos]))
+			return Iterator(this, pos);
+		return end();
+	}
+
+	/**
+	 * Elimina la clave a la que apunta it y devuelve un iterador a la
+	 * siguiente (end si era la última). O(n)
+	 */
+	Iterator erase(Iterator it) {
+		if (it.mapa != this || it.pos == size())
+			throw InvalidAccessException();
+		claves.erase(claves.begin() + it.pos);
+		valores.erase(valores.begin() + it.pos);
+		return it;
+	}
+
+	/** Iterador a la primera clave mayor o igual que c (end si no hay). O(log n) */
+	Iterator lower_bound(const Clave &c) {
+		return Iterator(this, posicion(c));
+	}
+
+	/** Iterador a la primera clave estrictamente mayor que c (end si no hay). O(log n) */
+	Iterator upper_bound(const Clave &c) {
+		return Iterator(this, posicionMayor(c));
+	}
+
+private:
+	/** Posición de la primera clave mayor o igual que c (size() si no hay). O(log n) */
+	int posicion(const Clave &c) const {
+		return busquedaSinSaltos(claves.data(), size(), c, cless);
+	}
+
+	/** Posición de la primera clave estrictamente mayor que c (size() si no hay). O(log n) */
+	int posicionMayor(const Clave &c) const {
+		int pos = posicion(c);
+		if (pos < size() && !cless(c, claves[pos]))
+			++pos;
+		return pos;
+	}
+
+	/**
+	 * Ordena v por clave y deja una sola pareja por clave, la última que
+	 * aparecía en v. Si ya estaba ordenado basta con comprobarlo.
+	 * O(n) si está ordenado; O(n log n) si no.
+	 */
+	void normaliza(std::vector<std::pair<Clave, Valor>> &v) const {
+		bool ordenado = true;
+		for (std::size_t i = 1; i < v.size() && ordenado; ++i)
+			if (!cless(v[i - 1].first, v[i].first))
+				ordenado = false;
+		if (ordenado)
+			return;
+		// Estable para que, entre claves iguales, la última siga siendo la última
+		std::stable_sort(v.begin(), v.end(),
+				[this](const std::pair<Clave, Valor> &a, const std::pair<Clave, Valor> &b) {
+					return cless(a.first, b.first);
+				});
+		std::size_t k = 0; // parejas ya colocadas en su sitio definitivo
+		for (std::size_t i = 0; i < v.size(); ++i) {
+			if (k > 0 && !cless(v[k - 1].first, v[i].first))
+				v[k - 1] = std::move(v[i]); // misma clave: gana la posterior
+			else {
+				if (k != i)
+					v[k] = std::move(v[i]);
+				++k;
+			}
+		}
+		v.erase(v.begin() + k, v.end());
+	}
+
+	/** Claves ordenadas y sin repetidos */
+	std::vector<Clave> claves;
+
+	/** valores[i] es el valor asociado a claves[i] */
+	std::vector<Celda> valores;
+
+	/** Comparador: menor estricto. */
+	Comparador cless;
+};
+
+#endif // __FLATMAP_H
@@ -0,0 +1,315 @@
+/**
+ * Implementación del TAD Set utilizando un vector ordenado.
+ */
+
+#ifndef __FLATSET_H
+#define __FLATSET_H
+
+#include <algorithm>
+#include <functional>
+#include <iostream>
+#include <type_traits>
+#include <utility>
+#include <vector>
+#include "Exceptions.h"
+
+/**
+ * Posición del primer elemento de v[0..n) que no es menor que c (n si no hay
+ * ninguno), siendo v un array ordenado según cless.
+ * Es una búsqueda binaria sin saltos: el intervalo se parte por la mitad en
+ * cada paso como en la búsqueda binaria de siempre, pero no se sale del bucle
+ * al encontrar el elemento, de modo que el número de pasos sólo depende de n y
+ * la única decisión (avanzar o no el principio del intervalo) se puede compilar
+ * como una asignación condicional en vez de como un salto difícil de predecir.
+ * O(log n)
+ */
+template <typename T, typename K, typename Comparador>
+int busquedaSinSaltos(const T *v, int n, const K &c, const Comparador &cless) {
+	if (n == 0)
+		return 0;
+	const T *base = v;
+	while (n > 1) {
+		int mitad = n / 2;
+		base = cless(base[mitad], c) ? base + mitad : base;
+		n -= mitad;
+	}
+	return (int) (base - v) + (cless(*base, c) ? 1 : 0);
+}
+
+/**
+ * Implementación del TAD Set utilizando un vector ordenado y sin repetidos.
+ * Pensado para conjuntos que se construyen una vez (o a bloques) y después
+ * sobre todo se consultan: los elementos están seguidos en memoria, sin punteros
+ * ni nodos, así que ocupa mucho menos que un TreeSetC y las búsquedas y los
+ * recorridos aprovechan mucho mejor la caché. A cambio, insertar o borrar un
+ * elemento suelto es O(n) porque hay que desplazar los que van detrás.
+ * Se añade un comparador: objeto función que acepta dos valores de tipo T y devuelve si el
+ *          primero es menor que el segundo. Por defecto se toma el < T si está definido
+ * Las operaciones son:
+ *    - FlatSetVacio: operación generadora que construye un conjunto vacío.
+ *    - Insert(elem): generadora que añade un nuevo elem al conjunto. Si elem ya estaba no se hace nada.
+ *    - erase(elem): operación modificadora. Elimina elem del conjunto.  Si elem no está la operación no tiene efecto.
+ *    - contains(elem): operación observadora. Determina si elem pertenece conjunto.
+ *    - empty(): operación observadora que indica si el conjunto es vacío.
+ *    - size(): operación observadora que devuelve el tamaño del conjunto
+ * Un conjunto se construye de golpe a partir de un rango de elementos, esté o
+ * no ordenado (se ordena y se quitan los repetidos), e insert_sorted añade un
+ * bloque de elementos mezclándolo con los que ya había en O(n + m).
+ * Cualquier inserción o borrado invalida los iteradores.
+ */
+template <class T, class Comparador = std::less<T>>
+class FlatSet {
+	// std::vector<bool> guarda bits sueltos: elem() no podría devolver una
+	// referencia a un elemento.
+	static_assert(!std::is_same<T, bool>::value, "FlatSet<bool> no está permitido");
+
+public:
+
+	/** Constructor; operación FlatSetVacio. O(1) */
+	FlatSet() {}
+
+	/**
+	 * Constructor a partir de un rango [ini, fin) de elementos, en cualquier
+	 * orden. Los repetidos se añaden una sola vez.
+	 * O(n) si el rango está ordenado; O(n log n) si no lo está.
+	 */
+	template <typename It>
+	FlatSet(It ini, It fin) : elems(ini, fin) {
+		normaliza(elems);
+	}
+
+	/** Operación generadora que añade un nuevo elemento al conjunto. O(n) */
+	void insert(const T &elem) {
+		int pos = posicion(elem);
+		if (pos == size() || cless(elem, elems[pos]))
+			elems.insert(elems.begin() + pos, elem);
+	}
+
+	/**
+	 * Añade todos los elementos del rango [ini, fin). Se ordenan (si no lo
+	 * estaban) y se mezclan con los del conjunto de una sola vez, en vez de
+	 * desplazar los elementos una vez por cada inserción.
+	 * O(n + m) siendo m el tamaño del rango (O(n + m log m) si no está ordenado).
+	 */
+	template <typename It>
+	void insert_sorted(It ini, It fin) {
+		std::vector<T> nuevos(ini, fin);
+		normaliza(nuevos);
+		std::vector<T> res;
+		res.reserve(elems.size() + nuevos.size());
+		std::size_t i = 0, j = 0;
+		while (i < elems.size() || j < nuevos.size()) {
+			if (j == nuevos.size() || (i < elems.size() && cless(elems[i], nuevos[j])))
+				res.push_back(std::move(elems[i++]));
+			else if (i == elems.size() || cless(nuevos[j], elems[i]))
+				res.push_back(std::move(nuevos[j++]));
+			else { // está en los dos: se queda el que había
+				res.push_back(std::move(elems[i++]));
+				++j;
+			}
+		}
+		elems.swap(res);
+	}
+
+	/**
+	 * Operación modificadora que elimina un elemento del conjunto.
+	 * Si elem no existía la operación no tiene efecto.
+	 * O(n)
+	 */
+	void erase(const T &elem) {
+		int pos = posicion(elem);
+		if (pos < size() && !cless(elem, elems[pos]))
+			elems.erase(elems.begin() + pos);
+	}
+
+	/** Operación observadora que comprueba si elem pertenece al conjunto. O(log n) */
+	bool contains(const T &elem) const {
+		int pos = posicion(elem);
+		return pos < size() && !cless(elem, elems[pos]);
+	}
+
+	/** Operación observadora que comprueba si el conjunto es vacío. */
+	bool empty() const {
+		return elems.empty();
+	}
+
+	/** Operación observadora que que indica el tamaño del conjunto. */
+	int size() const {
+		return (int) elems.size();
+	}
+
+	/** Escritura del conjunto: {e1, e2, ...} */
+	friend std::ostream& operator<<(std::ostream& o, const FlatSet& s) {
+		o << "{";
+		for (int i = 0; i < s.size(); ++i) {
+			if (i > 0)
+				o << ", ";
+			o << s.elems[i];
+		}
+		o << "}";
+		return o;
+	}
+
+
+	// //
+	// ITERADOR CONSTANTE Y FUNCIONES RELACIONADAS
+	// //
+
+	/**
+	 * Clase interna que implementa un iterador que permite recorrer el
+	 * conjunto en orden. Basta con la posición en el vector. No hay iterador
+	 * no constante: cambiar un elemento podría desordenar el vector.
+	 */
+	class ConstIterator {
+	public:
+		ConstIterator() : conj(nullptr), pos(0) {}
+
+		/** Avanza al siguiente elemento. O(1) */
+		void next() {
+			if (conj == nullptr || pos == conj->size())
+				throw InvalidAccessException();
+			++pos;
+		}
+
+		/** Retrocede al anterior elemento. Desde el primero se pasa al final. O(1) */
+		void prev() {
+			if (conj == nullptr || pos == conj->size())
+				throw InvalidAccessException();
+			pos = pos == 0 ? conj->size() : pos - 1;
+		}
+
+		/** O(1) */
+		const T &elem() const {
+			if (conj == nullptr || pos == conj->size())
+				throw InvalidAccessException();
+			return conj->elems[pos];
+		}
+
+		const T& operator*() const {
+			return elem();
+		}
+
+		/** O(1) */
+		bool operator==(const ConstIterator &other) const {
+			return conj == other.conj && pos == other.pos;
+		}
+
+		/** O(1) */
+		bool operator!=(const ConstIterator &other) const {
+			return !(this->operator==(other));
+		}
+
+		ConstIterator &operator++() {
+			next();
+			return *this;
+		}
+
+		ConstIterator operator++(int) {
+			ConstIterator ret(*this);
+			operator++();
+			return ret;
+		}
+
+		ConstIterator &operator--() {
+			prev();
+			return *this;
+		}
+
+		ConstIterator operator--(int) {
+			ConstIterator ret(*this);
+			operator--();
+			return ret;
+		}
+
+	protected:
+		friend class FlatSet;
+
+		ConstIterator(const FlatSet *conj, int pos) : conj(conj), pos(pos) {}
+
+		/** Conjunto que se recorre */
+		const FlatSet *conj;
+
+		/** Posición del elemento actual (size() al final) */
+		int pos;
+	};
+
+	/** Devuelve el iterador constante al principio del conjunto (el elemento más pequeño). O(1) */
+	ConstIterator cbegin() const {
+		return ConstIterator(this, 0);
+	}
+
+	/** Devuelve un iterador constante al final del recorrido (fuera de éste). O(1) */
+	ConstIterator cend() const {
+		return ConstIterator(this, size());
+	}
+
+	/** Devuelve el iterador constante al último elemento (cend si es vacío). O(1) */
+	ConstIterator clast() const {
+		return ConstIterator(this, empty() ? 0 : size() - 1);
+	}
+
+	ConstIterator begin() const {
+		return cbegin();
+	}
+
+	ConstIterator end() const {
+		return cend();
+	}
+
+	/** Devuelve un iterador constante al elemento c, o cend si no está. O(log n) */
+	ConstIterator find(const T &c) const {
+		int pos = posicion(c);
+		if (pos < size() && !cless(c, elems[pos]))
+			return ConstIterator(this, pos);
+		return cend();
+	}
+
+	/** Iterador constante al primer elemento mayor o igual que c (cend si no hay). O(log n) */
+	ConstIterator lower_bound(const T &c) const {
+		return ConstIterator(this, posicion(c));
+	}
+
+	/** Iterador constante al primer elemento estrictamente mayor que c (cend si no hay). O(log n) */
+	ConstIterator upper_bound(const T &c) const {
+		int pos = posicion(c);
+		if (pos < size() && !cless(c, elems[pos]))
+			++pos;
+		return ConstIterator(this, pos);
+	}
+
+private:
+	/** Posición del primer elemento mayor o igual que c (size() si no hay). O(log n) */
+	int posicion(const T &c) const {
+		return busquedaSinSaltos(elems.data(), size(), c, cless);
+	}
+
+	/**
+	 * Ordena v y quita los repetidos. Si ya estaba ordenado basta con
+	 * comprobarlo. O(n) si está ordenado; O(n log n) si no.
+	 */
+	void normaliza(std::vector<T> &v) const {
+		bool ordenado = true;
+		for (std::size_t i = 1; i < v.size() && ordenado; ++i)
+			if (!cless(v[i - 1], v[i]))
+				ordenado = false;
+		if (ordenado)
+			return;
+		std::sort(v.begin(), v.end(), cless);
+		std::size_t k = 0; // elementos ya colocados en su sitio definitivo
+		for (std::size_t i = 0; i < v.size(); ++i)
+			if (k == 0 || cless(v[k - 1], v[i])) {
+				if (k != i)
+					v[k] = std::move(v[i]);
+				++k;
+			}
+		v.erase(v.begin() + k, v.end());
+	}
+
+	/** Elementos ordenados y sin repetidos */
+	std::vector<T> elems;
+
+	/** Comparador: menor estricto. */
+	Comparador cless;
+};
+
+#endif // __FLATSET_H
@@ -1,6 +1,6 @@
 /**
- * Ejemplo ilustrativo de la declaración e implementación de 
- * funciones de localización (hash( para tipos básicos y 
+ * Ejemplo ilustrativo de la declaración e implementación de
+ * funciones de localización (hash( para tipos básicos y
  * objeto función.
  * (c) Antonio Sánchez Ruiz-Granados, 2012
  * Modificado por Ignacio Fábregas, 2022
@@ -9,7 +9,10 @@
 #ifndef __HASH_H
 #define __HASH_H
 
+#include <cstddef>
+#include <cstring>
 #include <string>
+#include <string_view>
 
 // ----------------------------------------------------
 //
@@ -17,32 +20,72 @@
 //
 // ----------------------------------------------------
 
+/**
+ * Mezcla final de 64 bits de MurmurHash3 (fmix64). Cada bit de la entrada
+ * afecta a todos los bits de la salida, de modo que claves consecutivas o
+ * con un paso fijo (múltiplos de 8, de 1024...) quedan bien repartidas
+ * aunque luego sólo se usen los bits bajos para elegir la posición.
+ * La aplican los propios diccionarios al resultado de su función hash (sea
+ * ésta mihash, std::hash o cualquier otra), así que las funciones mihash no la
+ * aplican: la mezcla se hace una sola vez.
+ */
+inline std::size_t mezcla(unsigned long long h) {
+	h ^= h >> 33;
+	h *= 0xff51afd7ed558ccdULL;
+	h ^= h >> 33;
+	h *= 0xc4ceb9fe1a85ec53ULL;
+	h ^= h >> 33;
+	return (std::size_t) h;
+}
+
+inline std::size_t mihash(unsigned int clave) {
+	return (std::size_t) clave;
+}
 
-inline unsigned int mihash(unsigned int clave) {
-	return clave;
+inline std::size_t mihash(int clave) {
+	return (std::size_t) (unsigned int) clave;
 }
 
-inline unsigned int mihash(int clave) {
-	return (unsigned int) clave;
+inline std::size_t mihash(unsigned long long clave) {
+	return (std::size_t) clave;
 }
 
-inline unsigned int hash(char clave) {
-	return clave;
+inline std::size_t mihash(long long clave) {
+	return (std::size_t) (unsigned long long) clave;
 }
 
-// Fowler/Noll/Vo (FNV) -- adaptada de http://bretmulvey.com/hash/6.html 
-inline unsigned int mihash(std::string clave) {
-	const unsigned int p = 16777619; // primo grande
-	unsigned int hash = 2166136261;  // valor inicial
-	for (unsigned int i=0; i<clave.size(); i++)
-		hash = (hash ^ clave[i]) * p; // ^ es xor binario
-	// mezcla final
-	hash += hash << 13;
-	hash ^= hash >> 7;
-	hash += hash << 3;
-	hash ^= hash >> 17;
-	hash += hash << 5;
-	return hash;
+inline std::size_t mihash(char clave) {
+	return (std::size_t) (unsigned char) clave;
+}
+
+// MurmurHash64A (Austin Appleby): procesa la cadena de 8 en 8 bytes en vez de
+// byte a byte como FNV.
+inline std::size_t mihash(const char *p, std::size_t n) {
+	const unsigned long long m = 0xc6a4a7935bd1e995ULL;
+	const int r = 47;
+	unsigned long long hash = 0x9e3779b97f4a7c15ULL ^ (n * m); // valor inicial
+	for (; n >= 8; n -= 8, p += 8) {
+		unsigned long long k;
+		std::memcpy(&k, p, 8); // lectura sin problemas de alineamiento
+		k *= m;
+		k ^= k >> r;
+		k *= m;
+		hash ^= k;
+		hash *= m;
+	}
+	// los últimos (menos de 8) bytes
+	if (n > 0) {
+		unsigned long long k = 0;
+		std::memcpy(&k, p, n);
+		hash ^= k;
+		hash *= m;
+	}
+	// sin mezcla final: la hace el diccionario (ver mezcla)
+	return (std::size_t) hash;
+}
+
+inline std::size_t mihash(const std::string &clave) {
+	return mihash(clave.data(), clave.size());
 }
 
 /**
@@ -51,11 +94,35 @@ inline unsigned int mihash(std::string clave) {
 template<class C>
 class Hash{
 public:
-    int operator()(const C& c)  const{
+    std::size_t operator()(const C& c)  const{
         return mihash(c);
     }
 
 };
 
+/**
+ * Objeto función para hash de cadenas. Es transparente (is_transparent): un
+ * std::string_view o un const char* dan el mismo hash que el std::string con
+ * los mismos caracteres, así que los diccionarios pueden buscar con ellos sin
+ * construir un std::string.
+ */
+template<>
+class Hash<std::string>{
+public:
+    using is_transparent = void;
+
+    std::size_t operator()(const std::string& c) const{
+        return mihash(c.data(), c.size());
+    }
+
+    std::size_t operator()(std::string_view c) const{
+        return mihash(c.data(), c.size());
+    }
+
+    std::size_t operator()(const char *c) const{
+        return mihash(c, std::strlen(c));
+    }
+};
+
 
 #endif // __HASH_H
@@ -6,12 +6,50 @@
 #ifndef __HASHMAP_H
 #define __HASHMAP_H
 
+#include <algorithm>
+#include <cstddef>
+#include <exception>
 #include <iostream>
+#include <stdexcept>
+#include <system_error>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
+#include "Allocators.h"
 #include "Exceptions.h"
+#include "Hash.h"
+
+// Pide al procesador que vaya trayendo a la caché la dirección p, sin esperar.
+#if defined(__GNUC__) || defined(__clang__)
+#define HASHMAP_PREFETCH(p) __builtin_prefetch(p)
+#else
+#define HASHMAP_PREFETCH(p) ((void) 0)
+#endif
 
 /**
  * Implementación dinámica del TAD Diccionario usando una tabla hash abierta.
- * La tabla hash se redimensiona según lo necesite.
+ * La tabla hash se redimensiona según lo necesite. Su tamaño es siempre una
+ * potencia de 2, así que el índice de una clave se obtiene con una máscara.
+ * Opcionalmente la redimensión puede ser incremental (set_incremental_rehash):
+ * la tabla antigua y la nueva conviven y cada operación modificadora traslada
+ * unas pocas listas, en vez de trasladarlas todas de golpe en una inserción.
+ * Los nodos se crean y destruyen con el asignador que se pasa como parámetro
+ * (ver Allocators.h); por defecto se usan new y delete.
+ * Si se conoce de antemano el número de elementos, se puede reservar espacio
+ * (constructor con tamaño esperado o reserve) para no ir ampliando la tabla,
+ * y tras un pico de inserciones se puede devolver memoria con shrink_to_fit.
+ * Además de insert, se puede construir el valor directamente en el nodo
+ * (emplace, try_emplace) o insertar/sustituir (insert_or_assign); todas
+ * calculan el hash y buscan la clave una sola vez.
+ * Si la función hash es transparente (define is_transparent, como
+ * Hash<std::string>), at, contains y find admiten claves de otros tipos
+ * compatibles (std::string_view, const char*...) sin construir una Clave.
+ * Para buscar muchas claves de una vez están at_batch y contains_batch, que
+ * solapan los fallos de caché de claves distintas.
+ * Para tablas muy grandes se puede repartir el trabajo entre varios hilos:
+ * build_parallel construye la tabla a partir de un rango de parejas y, con
+ * set_parallel_rehash, las ampliaciones trasladan las listas en paralelo.
  * Se añade la opción de usar cualquier comparador hash
  * Las operaciones son:
  *    - HashMapVacio: operación generadora que construye una tabla hash vacía
@@ -26,7 +64,8 @@
  *    - empty(): operación observadora que indica si la tabla tiene alguna clave introducida.
  *    - size(): operación observadora que indica el tamaño del diccionario.
  */
-template <typename Clave, typename Valor, typename Hash = std::hash<Clave>>
+template <typename Clave, typename Valor, typename Hash = std::hash<Clave>,
+		template <typename> class Asignador = NewAllocator>
 class HashMap {
 private:
 	/**
@@ -42,6 +81,11 @@ private:
 		Nodo(const Clave &clave, const Valor &valor, Nodo *sig) :
                 clave(clave), valor(valor), sig(sig) {};
 
+		/** Construye la clave y el valor en el propio nodo a partir de los argumentos. */
+		template <typename C, typename... Args>
+		Nodo(Nodo *sig, C &&clave, Args&&... args) :
+                clave(std::forward<C>(clave)), valor(std::forward<Args>(args)...), sig(sig) {}
+
 		/** Clave */
 		Clave clave;
 
@@ -58,10 +102,45 @@ public:
 	static const int TAM_INICIAL = 8;    
 	
 	/** Constructor por defecto que implementa HashMapVacio. O(1) */
-	HashMap() : v(new Nodo*[TAM_INICIAL]), tam(TAM_INICIAL), numElems(0) {
+	HashMap() : v(new Nodo*[TAM_INICIAL]), tam(TAM_INICIAL), numElems(0),
+			vAnt(nullptr), tamAnt(0), migrados(0), incremental(false), paralelo(false),
+			maxOcupacion(MAX_OCUPACION) {
+		for (unsigned int i=0; i < tam; ++i)
+            v[i] = nullptr;
+	}
+
+	/**
+	 * Constructor de una tabla vacía con espacio para numEsperado elementos:
+	 * se pueden insertar todos sin que la tabla tenga que ampliarse. O(numEsperado)
+	 */
+	explicit HashMap(unsigned int numEsperado) : v(nullptr), tam(0), numElems(0),
+			vAnt(nullptr), tamAnt(0), migrados(0), incremental(false), paralelo(false),
+			maxOcupacion(MAX_OCUPACION) {
+		tam = cubetasPara(numEsperado);
+		v = new Nodo*[tam];
 		for (unsigned int i=0; i < tam; ++i)
             v[i] = nullptr;
 	}
+
+	/**
+	 * Construye una tabla con las parejas (clave, valor) del rango [ini, fin),
+	 * que debe ser de acceso aleatorio, repartiendo el trabajo entre "hilos"
+	 * hilos (0: tantos como el procesador pueda ejecutar a la vez).
+	 * Como en insert, si una clave se repite se queda con el último valor.
+	 * La tabla se crea directamente con sitio para todas las parejas. Primero
+	 * cada hilo calcula el hash de un trozo del rango; después cada hilo enlaza
+	 * las parejas que caen en un intervalo distinto de listas, así que no hace
+	 * falta ningún cerrojo.
+	 * Si el asignador no se puede usar desde varios hilos a la vez (ver
+	 * SEGURO_ENTRE_HILOS en Allocators.h) las parejas se insertan en un solo hilo.
+	 * O(n / hilos) siempre que haya hilos procesadores libres.
+	 */
+	template <typename It>
+	static HashMap build_parallel(It ini, It fin, unsigned int hilos = 0) {
+		HashMap ret((unsigned int) (fin - ini));
+		ret.insertaEnParalelo(ini, fin, hilos);
+		return ret;
+	}
 	
 	/** Destructor; elimina las listas enlazadas */
 	~HashMap() {
@@ -75,20 +154,74 @@ public:
 	 *   donde k es el número de colisiones en el hash.
 	 */
 	void insert(const Clave &clave, const Valor &valor) {        
-		// Si la ocupación es muy alta ampliamos la tabla
-		float ocupacion = 100 * ((float) numElems) / tam;
-		if (ocupacion > MAX_OCUPACION)
-			amplia();
-		// Obtenemos el índice asociado a la clave.
-		unsigned int ind = hash(clave) % tam;
-		// Si la clave ya existía, actualizamos su valor
-		Nodo *nodo = buscaNodo(clave, v[ind]);
-		if (nodo != nullptr) {
+		bool insertado;
+		// Si la clave es nueva se crea su nodo con el valor; si ya existía
+		// (en cualquiera de las tablas), actualizamos su valor.
+		Nodo *nodo = buscaOInserta(clave, insertado, valor);
+		if (!insertado)
 			nodo->valor = valor;
-		} else { //si la clave es nueva, creamos un nuevo nodo y lo insertamos.
-			v[ind] = new Nodo(clave, valor, v[ind]);
-			numElems++;
-		}
+	}
+
+	/** Como insert, pero moviendo la clave y el valor en vez de copiarlos. */
+	void insert(Clave &&clave, Valor &&valor) {
+		bool insertado;
+		Nodo *nodo = buscaOInserta(std::move(clave), insertado, std::move(valor));
+		if (!insertado)
+			nodo->valor = std::move(valor);
+	}
+
+	/**
+	 * Añade la clave con un valor construido en el propio nodo a partir de args.
+	 * Si la clave ya estaba no se hace nada (y no se construye ningún valor).
+	 * Devuelve si la clave era nueva.
+	 * O(k) amortizado donde k es el número de colisiones en el hash.
+	 */
+	template <typename... Args>
+	bool try_emplace(const Clave &clave, Args&&... args) {
+		bool insertado;
+		buscaOInserta(clave, insertado, std::forward<Args>(args)...);
+		return insertado;
+	}
+
+	template <typename... Args>
+	bool try_emplace(Clave &&clave, Args&&... args) {
+		bool insertado;
+		buscaOInserta(std::move(clave), insertado, std::forward<Args>(args)...);
+		return insertado;
+	}
+
+	/**
+	 * Añade una pareja construyendo la clave a partir de c y el valor a partir
+	 * de args. Como en try_emplace, si la clave ya estaba no se hace nada.
+	 * Devuelve si la clave era nueva.
+	 * O(k) amortizado donde k es el número de colisiones en el hash.
+	 */
+	template <typename C, typename... Args>
+	bool emplace(C &&c, Args&&... args) {
+		return try_emplace(Clave(std::forward<C>(c)), std::forward<Args>(args)...);
+	}
+
+	/**
+	 * Como insert (si la clave ya estaba se sustituye el valor), pero
+	 * devuelve si la clave era nueva.
+	 * O(k) amortizado donde k es el número de colisiones en el hash.
+	 */
+	template <typename V>
+	bool insert_or_assign(const Clave &clave, V &&valor) {
+		bool insertado;
+		Nodo *nodo = buscaOInserta(clave, insertado, std::forward<V>(valor));
+		if (!insertado)
+			nodo->valor = std::forward<V>(valor);
+		return insertado;
+	}
+
+	template <typename V>
+	bool insert_or_assign(Clave &&clave, V &&valor) {
+		bool insertado;
+		Nodo *nodo = buscaOInserta(std::move(clave), insertado, std::forward<V>(valor));
+		if (!insertado)
+			nodo->valor = std::forward<V>(valor);
+		return insertado;
 	}
 	
 	/**
@@ -97,20 +230,33 @@ public:
 	 *  O(k) donde k es el número de colisiones en el hash.
 	 */
 	void erase(const Clave &clave) {
+		if (numElems == 0)
+			return;
+		migraPasos();
 		// Obtenemos el índice asociado a la clave.
-		unsigned int ind = hash(clave) % tam;
+		std::size_t h = hashDe(clave);
+		unsigned int ind = h & (tam - 1);
 		// Buscamos el nodo que contiene esa clave y el nodo anterior.
-		Nodo *act = v[ind];
+		Nodo **lista = &v[ind];
+		Nodo *act = *lista;
 		Nodo *ant = nullptr;
         buscaNodoConAnterior(clave, act, ant);
+		if (act == nullptr && vAnt != nullptr) { // puede estar en una lista aún sin migrar
+			unsigned int indAnt = h & (tamAnt - 1);
+			if (indAnt >= migrados) {
+				lista = &vAnt[indAnt];
+				act = *lista;
+				buscaNodoConAnterior(clave, act, ant);
+			}
+		}
 		if (act != nullptr) { //si está
 			// Sacamos el nodo de la secuencia de nodos.
 			if (ant != nullptr)
 				ant->sig = act->sig;
 			else
-                v[ind] = act->sig;
+                *lista = act->sig;
 			// Borramos el nodo.
-			delete act;
+			asig.borra(act);
 			numElems--;
 		}        
 	}
@@ -121,10 +267,10 @@ public:
 	 *  O(k) donde k es el número de colisiones en el hash.
 	 */
 	const Valor &at(const Clave &clave) const {
-		// Obtenemos el índice asociado a la clave.
-		unsigned int ind = hash(clave) % tam;
 		// Buscamos un nodo que contenga esa clave.
-		Nodo *nodo = buscaNodo(clave, v[ind]);
+		unsigned int ind;
+		bool enAnt;
+		Nodo *nodo = localiza(clave, hashDe(clave), ind, enAnt);
 		if (nodo == nullptr)
 			throw EClaveErronea();
 		return nodo->valor;
@@ -132,12 +278,64 @@ public:
 	
 	/** Operación observadora que indica si una clave aparece. */
 	bool contains(const Clave &clave) const {
-		// Obtenemos el índice asociado a la clave.
-		unsigned int ind = hash(clave) % tam;
 		// Buscamos un nodo que contenga esa clave.
-		Nodo *nodo = buscaNodo(clave, v[ind]);
+		unsigned int ind;
+		bool enAnt;
+		Nodo *nodo = localiza(clave, hashDe(clave), ind, enAnt);
 		return nodo != nullptr;
 	}
+
+	/**
+	 * Versiones de at y contains que buscan con una clave de otro tipo K sin
+	 * construir una Clave temporal. Sólo existen si la función hash es
+	 * transparente; K debe dar el mismo hash que la Clave equivalente y poder
+	 * compararse con ella con ==.
+	 *  O(k) donde k es el número de colisiones en el hash.
+	 */
+	template <typename K, typename H = Hash, typename = typename H::is_transparent>
+	const Valor &at(const K &clave) const {
+		unsigned int ind;
+		bool enAnt;
+		Nodo *nodo = localiza(clave, hashDe(clave), ind, enAnt);
+		if (nodo == nullptr)
+			throw EClaveErronea();
+		return nodo->valor;
+	}
+
+	template <typename K, typename H = Hash, typename = typename H::is_transparent>
+	bool contains(const K &clave) const {
+		unsigned int ind;
+		bool enAnt;
+		return localiza(clave, hashDe(clave), ind, enAnt) != nullptr;
+	}
+
+	/**
+	 * Versiones de contains y at para muchas claves: para cada clave del rango
+	 * [ini, fin) escribe en out (iterador de salida, por ejemplo un bool* o un
+	 * back_inserter) si está, o su valor. at_batch lanza EClaveErronea al llegar
+	 * a una clave que no existe (con lo anterior ya escrito).
+	 * En una tabla que no cabe en la caché cada búsqueda suelta tiene que
+	 * esperar a la memoria una o dos veces; aquí las claves se buscan en grupos
+	 * de TAM_GRUPO (ver buscaEnGrupos) para que esas esperas se solapen.
+	 * O(m * k) siendo m el número de claves y k el número de colisiones en el hash.
+	 */
+	template <typename It, typename Out>
+	void contains_batch(It ini, It fin, Out out) const {
+		buscaEnGrupos(ini, fin, [&](const Nodo *nodo) {
+			*out = nodo != nullptr;
+			++out;
+		});
+	}
+
+	template <typename It, typename Out>
+	void at_batch(It ini, It fin, Out out) const {
+		buscaEnGrupos(ini, fin, [&](const Nodo *nodo) {
+			if (nodo == nullptr)
+				throw EClaveErronea();
+			*out = nodo->valor;
+			++out;
+		});
+	}
 	
 	/** Operación observadora que devuelve si el diccionario es vacío. O(1) */
 	bool empty() const {
@@ -148,6 +346,105 @@ public:
     int size() const {
         return numElems;
     }
+
+	/**
+	 * Activa o desactiva la redimensión incremental. Con ella, al ampliar la
+	 * tabla no se trasladan todas las listas de golpe: cada insert, erase u
+	 * operator[] posterior traslada PASOS_MIGRACION listas de la tabla antigua,
+	 * y mientras tanto las búsquedas consultan ambas tablas.
+	 * Al desactivarla se termina la migración pendiente, si la hay.
+	 */
+	void set_incremental_rehash(bool activar) {
+		incremental = activar;
+		if (!incremental)
+			terminaMigracion();
+	}
+
+	/**
+	 * Activa o desactiva la redimensión en paralelo. Con ella, cuando una
+	 * tabla grande (al menos 2 * LISTAS_POR_HILO listas) se amplía de golpe (no
+	 * de forma incremental), las listas antiguas se reparten entre varios hilos. La
+	 * función hash tiene que poder usarse desde varios hilos a la vez.
+	 */
+	void set_parallel_rehash(bool activar) {
+		paralelo = activar;
+	}
+
+	/** Número de listas (cubetas) de la tabla. O(1) */
+	unsigned int bucket_count() const {
+		return tam;
+	}
+
+	/** Ocupación actual: número medio de elementos por lista. O(1) */
+	float load_factor() const {
+		if (tam == 0)
+			return 0;
+		return ((float) numElems) / tam;
+	}
+
+	/** Ocupación máxima antes de ampliar la tabla (por defecto 0.8). O(1) */
+	float max_load_factor() const {
+		return maxOcupacion / 100;
+	}
+
+	/**
+	 * Cambia la ocupación máxima antes de ampliar la tabla. Valores bajos
+	 * hacen las listas más cortas a cambio de más memoria. Si la ocupación
+	 * actual ya supera la nueva máxima, la tabla se redimensiona.
+	 * Un valor no positivo no tiene efecto. Si la tabla necesaria no cabe
+	 * (std::length_error) o no hay memoria, se deja la ocupación máxima
+	 * que había.
+	 * O(n) si hay que redimensionar y O(1) si no.
+	 */
+	void max_load_factor(float maxima) {
+		if (maxima <= 0)
+			return;
+		float anterior = maxOcupacion;
+		maxOcupacion = 100 * maxima;
+		try {
+			if (cubetasPara(numElems) > tam)
+				rehash(0);
+		} catch (...) {
+			maxOcupacion = anterior;
+			throw;
+		}
+	}
+
+	/**
+	 * Redimensiona la tabla para que tenga al menos "cubetas" listas (siempre
+	 * una potencia de 2), pero nunca menos de las necesarias para los elementos
+	 * actuales sin superar la ocupación máxima. Puede reducir la tabla.
+	 * Si se piden más de TAM_MAXIMO listas se lanza std::length_error.
+	 * O(n + cubetas)
+	 */
+	void rehash(unsigned int cubetas) {
+		unsigned int nuevoTam = cubetasPara(numElems);
+		while (nuevoTam < cubetas)
+			nuevoTam = doble(nuevoTam);
+		terminaMigracion();
+		if (nuevoTam != tam)
+			redimensiona(nuevoTam, false);
+	}
+
+	/**
+	 * Reserva espacio para n elementos: se pueden insertar hasta tener n sin
+	 * que la tabla tenga que ampliarse. Nunca reduce la tabla.
+	 * O(n) si hay que redimensionar y O(1) si no.
+	 */
+	void reserve(unsigned int n) {
+		unsigned int nuevoTam = cubetasPara(n);
+		if (nuevoTam > tam)
+			redimensiona(nuevoTam, false);
+	}
+
+	/**
+	 * Reduce la tabla al menor tamaño que admite los elementos actuales,
+	 * devolviendo la memoria que sobra (por ejemplo, tras muchos borrados).
+	 * O(n)
+	 */
+	void shrink_to_fit() {
+		rehash(0);
+	}
 	
 	/**
 	 * Sobrecarga del operador [] que permite acceder al valor asociado
@@ -156,17 +453,15 @@ public:
 	 * O(k) donde k es el número de colisiones en el hash.
 	 */
 	Valor &operator[](const Clave &clave) {
-		// Obtenemos el índice asociado a la clave.
-		unsigned int ind = hash(clave) % tam;
-		// Buscamos un nodo que contenga esa clave.
-		Nodo *nodo = buscaNodo(clave, v[ind]);
-		if (nodo == nullptr) { // No está, se añade
-			insert(clave, Valor());
-			// ¡Ojo, ind puede cambiar si al insertar hubo expansion!
-			ind = hash(clave) % tam;
-			nodo = buscaNodo(clave, v[ind]);
-		}        
-		return nodo->valor;
+		// Buscamos un nodo que contenga esa clave y, si no está, se añade
+		// (una única búsqueda, aunque haya que ampliar la tabla).
+		bool insertado;
+		return buscaOInserta(clave, insertado)->valor;
+	}
+
+	Valor &operator[](Clave &&clave) {
+		bool insertado;
+		return buscaOInserta(std::move(clave), insertado)->valor;
 	}
 	
 	// //
@@ -179,7 +474,7 @@ public:
 	 */
 	class ConstIterator {
 	public:
-		ConstIterator() : tabla(nullptr), act(nullptr), ind(0) {}
+		ConstIterator() : tabla(nullptr), act(nullptr), ind(0), enAnt(false) {}
 
 		void next() {
 			if (act == nullptr)
@@ -187,11 +482,8 @@ public:
 			// Buscamos el siguiente nodo de la lista de nodos.
 			act = act->sig;
 			// Si hemos llegado al final de la lista de nodos,
-			// pasamos al siguiente índice
-			while ((act == nullptr) && (ind < tabla->tam - 1)) {
-				++ind;
-                act = tabla->v[ind];
-			}
+			// pasamos a la siguiente lista no vacía
+			tabla->avanzaLista(act, ind, enAnt);
 		}
 		
 		const Clave &key() const {
@@ -228,8 +520,8 @@ public:
 	protected:
 		friend class HashMap;
 		
-		ConstIterator(const HashMap* tabla, Nodo* act, unsigned int ind) 
-			: tabla(tabla), act(act), ind(ind) { }
+		ConstIterator(const HashMap* tabla, Nodo* act, unsigned int ind, bool enAnt = false)
+			: tabla(tabla), act(act), ind(ind), enAnt(enAnt) { }
 
         /** Puntero a la tabla que se está recorriendo */
 		const HashMap *tabla;
@@ -237,19 +529,22 @@ public:
         /** Puntero al nodo actual del recorrido */
         Nodo* act;
 
-        /** Índice actual en el vector v */
+        /** Índice actual en el vector v (o en vAnt si enAnt) */
 		unsigned int ind;
+
+        /** Indica si se están recorriendo las listas aún sin migrar de vAnt */
+		bool enAnt;
 	};
 	
 	/** Devuelve un iterador constante al principio del diccionario. */
 	ConstIterator cbegin() const {
+		if (numElems == 0)
+			return cend();
 		unsigned int ind = 0;
 		Nodo *act = v[0];
-		while (ind < tam - 1 && act == nullptr) {
-			ind++;
-			act = v[ind];
-		}
-		return ConstIterator(this, act, ind);
+		bool enAnt = false;
+		avanzaLista(act, ind, enAnt);
+		return ConstIterator(this, act, ind, enAnt);
 	}
 	
 	/** Devuelve un iterador constante al final del recorrido */
@@ -262,11 +557,20 @@ public:
 	 * Si no existe la clave devuelve un iterador al final.
 	 */
 	ConstIterator find(const Clave &clave) const {
-		// Obtenemos el índice asociado a la clave.
-		unsigned int ind = hash(clave) % tam;
 		// Buscamos un nodo que contenga esa clave.
-		Nodo *nodo = buscaNodo(clave, v[ind]);
-		return ConstIterator(this, nodo, ind); //si nodo == nullptr se devuelve cend
+		unsigned int ind;
+		bool enAnt;
+		Nodo *nodo = localiza(clave, hashDe(clave), ind, enAnt);
+		return ConstIterator(this, nodo, ind, enAnt); //si nodo == nullptr se devuelve cend
+	}
+
+	/** find con una clave de otro tipo (sólo si la función hash es transparente). */
+	template <typename K, typename H = Hash, typename = typename H::is_transparent>
+	ConstIterator find(const K &clave) const {
+		unsigned int ind;
+		bool enAnt;
+		Nodo *nodo = localiza(clave, hashDe(clave), ind, enAnt);
+		return ConstIterator(this, nodo, ind, enAnt);
 	}
 	
 	// //
@@ -279,19 +583,16 @@ public:
 	 */
 	class Iterator {
 	public:
-		Iterator() : tabla(nullptr), act(nullptr), ind(0) {}
+		Iterator() : tabla(nullptr), act(nullptr), ind(0), enAnt(false) {}
 
 		void next() {
 			if (act == nullptr)
                 throw InvalidAccessException();
 			// Buscamos el siguiente nodo de la lista de nodos.
 			act = act->sig;
-            // Si hemos llegado al final de la lista de nodos,
-            // pasamos al siguiente índice
-			while ((act == nullptr) && (ind < tabla->tam - 1)) {
-				++ind;
-                act = tabla->v[ind];
-			}
+			// Si hemos llegado al final de la lista de nodos,
+			// pasamos a la siguiente lista no vacía
+			tabla->avanzaLista(act, ind, enAnt);
 		}
 		
 		const Clave &key() const {
@@ -328,8 +629,8 @@ public:
 	protected:
 		friend class HashMap;
 		
-		Iterator(const HashMap* tabla, Nodo* act, unsigned int ind) 
-		: tabla(tabla), act(act), ind(ind) { }
+		Iterator(const HashMap* tabla, Nodo* act, unsigned int ind, bool enAnt = false)
+		: tabla(tabla), act(act), ind(ind), enAnt(enAnt) { }
 
         /** Puntero a la tabla que se está recorriendo */
         const HashMap *tabla;
@@ -337,19 +638,22 @@ public:
         /** Puntero al nodo actual del recorrido */
         Nodo* act;
 
-        /** Índice actual en el vector v */
+        /** Índice actual en el vector v (o en vAnt si enAnt) */
         unsigned int ind;
+
+        /** Indica si se están recorriendo las listas aún sin migrar de vAnt */
+        bool enAnt;
 	};
 
     /** Devuelve un iterador al principio del diccionario. */
 	Iterator begin() {
+		if (numElems == 0)
+			return end();
 		unsigned int ind = 0;
 		Nodo *act = v[0];
-		while (ind < tam - 1 && act == nullptr) {
-			ind++;
-			act = v[ind];
-		}
-		return Iterator(this, act, ind);        
+		bool enAnt = false;
+		avanzaLista(act, ind, enAnt);
+		return Iterator(this, act, ind, enAnt);
 	}
 	
 	/** Devuelve un iterador al final del recorrido. */
@@ -362,11 +666,20 @@ public:
      * Si no existe la clave devuelve un iterador al final.
      */
 	Iterator find(const Clave &clave) {
-		// Obtenemos el índice asociado a la clave.
-		unsigned int ind = hash(clave) % tam;
 		// Buscamos un nodo que contenga esa clave.
-		Nodo *nodo = buscaNodo(clave, v[ind]);
-		return Iterator(this, nodo, ind); //si nodo == nullptr se devuelve cend
+		unsigned int ind;
+		bool enAnt;
+		Nodo *nodo = localiza(clave, hashDe(clave), ind, enAnt);
+		return Iterator(this, nodo, ind, enAnt); //si nodo == nullptr se devuelve end
+	}
+
+	/** find con una clave de otro tipo (sólo si la función hash es transparente). */
+	template <typename K, typename H = Hash, typename = typename H::is_transparent>
+	Iterator find(const K &clave) {
+		unsigned int ind;
+		bool enAnt;
+		Nodo *nodo = localiza(clave, hashDe(clave), ind, enAnt);
+		return Iterator(this, nodo, ind, enAnt);
 	}
 	
 	
@@ -383,49 +696,113 @@ public:
     }
 	
 	/** Constructor copia */
-	HashMap(const HashMap<Clave, Valor, Hash> &other) {
+	HashMap(const HashMap &other) : vAnt(nullptr), tamAnt(0), migrados(0) {
 		copia(other);
 	}
 	
 	/** Operador de asignación */
-	HashMap<Clave, Valor, Hash> &operator=(const HashMap<Clave, Valor, Hash> &other) {
+	HashMap &operator=(const HashMap &other) {
 		if (this != &other) {
 			libera();
 			copia(other);
 		}
 		return *this;
 	}
+
+	/**
+	 * Constructor de movimiento: se queda con la tabla de other sin copiar
+	 * ningún nodo. other queda vacío y sin tabla (se creará si se vuelve a usar).
+	 * O(1)
+	 */
+	HashMap(HashMap &&other) noexcept : v(nullptr), tam(0), numElems(0),
+			vAnt(nullptr), tamAnt(0), migrados(0), incremental(false), paralelo(false),
+			maxOcupacion(MAX_OCUPACION) {
+		mueve(other);
+	}
+
+	/** Asignación de movimiento. O(n) para liberar la tabla actual */
+	HashMap &operator=(HashMap &&other) noexcept {
+		if (this != &other) {
+			libera();
+			mueve(other);
+		}
+		return *this;
+	}
 	
 private:
 	
 	/** Libera toda la memoria dinámica reservada para la tabla. */
 	void libera() {
-		// Liberamos las listas de nodos.
-		for (unsigned int i=0; i < tam; i++)
-			liberaNodos(v[i]);
+		// Liberamos las listas de nodos. Si el asignador puede liberar todos
+		// los nodos de golpe y éstos no necesitan destructor, no las recorremos.
+		if (LIBERA_EN_BLOQUE)
+			asig.liberaTodo();
+		else
+			for (unsigned int i=0; i < tam; i++)
+				liberaNodos(v[i]);
 		// Liberamos el array de punteros a nodos.
 		if (v != nullptr) {
 			delete[] v;
             v = nullptr;
 		}
+		// Y la tabla antigua si había una migración en curso
+		if (vAnt != nullptr) {
+			if (!LIBERA_EN_BLOQUE)
+				for (unsigned int i = migrados; i < tamAnt; i++)
+					liberaNodos(vAnt[i]);
+			delete[] vAnt;
+			vAnt = nullptr;
+		}
 	}
 	
+	/**
+	 * Se queda con la tabla, los nodos y el asignador de other, que queda vacío
+	 * y sin tabla. Antes de llamar a este método se debe invocar a "libera".
+	 */
+	void mueve(HashMap &other) {
+		v = other.v;
+		tam = other.tam;
+		numElems = other.numElems;
+		vAnt = other.vAnt;
+		tamAnt = other.tamAnt;
+		migrados = other.migrados;
+		incremental = other.incremental;
+		paralelo = other.paralelo;
+		maxOcupacion = other.maxOcupacion;
+		hash = std::move(other.hash);
+		asig = std::move(other.asig);
+		other.v = nullptr;
+		other.tam = 0;
+		other.numElems = 0;
+		other.vAnt = nullptr;
+		other.tamAnt = 0;
+		other.migrados = 0;
+	}
+
 	/** Libera un nodo y todos los siguientes. */
-	static void liberaNodos(Nodo *prim) {
+	void liberaNodos(Nodo *prim) {
 		while (prim != nullptr) {
 			Nodo *aux = prim;
 			prim = prim->sig;
-			delete aux;
+			asig.borra(aux);
 		}       
 	}
 	
 	/**
 	 * Hace una copia de la tabla que recibe como parámetro.
 	 * Antes de llamar a este método se debe invocar al método "libera".
+	 * Si other estaba migrando, la copia ya nace con todo en la tabla nueva.
 	 */
-	void copia(const HashMap<Clave, Valor, Hash> &other) {
+	void copia(const HashMap &other) {
         tam = other.tam;
         numElems = other.numElems;
+        incremental = other.incremental;
+        paralelo = other.paralelo;
+        maxOcupacion = other.maxOcupacion;
+		if (other.v == nullptr) { // other se movió y no tiene tabla
+			v = nullptr;
+			return;
+		}
 		// Reservar memoria para el array de punteros a nodos.
 		v = new Nodo*[tam];
 		for (unsigned int i=0; i < tam; ++i) {
@@ -434,48 +811,426 @@ private:
 			// La lista de nodos queda invertida con respecto a la original.
 			Nodo *act = other.v[i];
 			while (act != nullptr) {
-                v[i] = new Nodo(act->clave, act->valor, v[i]);
+                v[i] = asig.nuevo(act->clave, act->valor, v[i]);
 				act = act->sig;
 			}
 		}
+		// Copiar las listas de other.vAnt aún no migradas, recolocando sus nodos.
+		if (other.vAnt != nullptr) {
+			for (unsigned int i = other.migrados; i < other.tamAnt; ++i)
+				for (Nodo *act = other.vAnt[i]; act != nullptr; act = act->sig) {
+					unsigned int ind = indice(act->clave);
+					v[ind] = asig.nuevo(act->clave, act->valor, v[ind]);
+				}
+		}
 	}
 	
-	/** Duplica la capacidad del array de punteros a Nodos */
+	/**
+	 * Duplica la capacidad del array de punteros a Nodos.
+	 * En modo incremental sólo crea el array nuevo y deja el antiguo en vAnt;
+	 * las listas se irán trasladando en migraPasos.
+	 */
 	void amplia() {
+		redimensiona(doble(tam), incremental);
+	}
+
+	/**
+	 * Cambia el array de punteros a Nodos por uno de nuevoTam posiciones
+	 * (potencia de 2). Si "gradual" es true, sólo se crea el array nuevo y
+	 * las listas se irán trasladando en migraPasos; si no, se trasladan ya.
+	 */
+	void redimensiona(unsigned int nuevoTam, bool gradual) {
+		// Una migración anterior tiene que haber terminado antes de empezar otra.
+		terminaMigracion();
+		// Creamos el nuevo array en otra posición de memoria, antes de tocar
+		// nada por si no hay memoria suficiente.
+		Nodo **nuevo = new Nodo*[nuevoTam];
+		for (unsigned int i=0; i < nuevoTam; ++i)
+            nuevo[i] = nullptr;
 		// Creamos un puntero al array actual y anotamos su tamaño.
-		Nodo **vAnt = v;
-		unsigned int tamAnt = tam;
-		// Duplicamos el array en otra posición de memoria.
-		tam *= 2;
-        v = new Nodo*[tam];
-		for (unsigned int i=0; i < tam; ++i)
-            v[i] = nullptr;
-		
-		// Recorremos el array original
-		for (unsigned int i=0; i<tamAnt; ++i) {
-            /* IMPORTANTE: al modificar el tamaño también se modifica el índice.
-             * Por eficiencia NO copiamos Nodos, sino que los movemos.
-             */
-			Nodo *nodo = vAnt[i];
-			while (nodo != nullptr) {
-				Nodo *aux = nodo;
-				nodo = nodo->sig;
-				unsigned int ind = hash(aux->clave) % tam; //el nuevo índice
-				aux->sig = v[ind];
-                v[ind] = aux;
-			}
+		vAnt = v;
+		tamAnt = tam;
+		migrados = 0;
+		tam = nuevoTam;
+		v = nuevo;
+		// Si no es gradual, trasladamos todas las listas ya.
+		if (!gradual) {
+			if (paralelo && tam > tamAnt && tamAnt >= 2 * LISTAS_POR_HILO)
+				trasladaEnParalelo();
+			terminaMigracion();
 		}
-		// Borramos el array antiguo (ya no contiene ningún nodo).
+	}
+
+	/**
+	 * Traslada todas las listas de vAnt a v, que es más grande, repartiendo
+	 * las listas de vAnt entre varios hilos. Como los dos tamaños son potencias
+	 * de 2, los nodos de la lista i de vAnt sólo pueden ir a listas de v cuyo
+	 * índice es i más un múltiplo de tamAnt: dos listas distintas de vAnt nunca
+	 * acaban en la misma lista de v, así que los hilos no se estorban.
+	 */
+	void trasladaEnParalelo() {
+		unsigned int desde = migrados;
+		unsigned int hilos = numHilos(0, (tamAnt - desde) / LISTAS_POR_HILO);
+		enParalelo(hilos, [&](unsigned int t) {
+			unsigned int ini = desde + (unsigned int) ((unsigned long long) (tamAnt - desde) * t / hilos);
+			unsigned int fin = desde + (unsigned int) ((unsigned long long) (tamAnt - desde) * (t + 1) / hilos);
+			for (unsigned int i = ini; i < fin; ++i) {
+				mueveNodos(vAnt[i]);
+				vAnt[i] = nullptr;
+			}
+		});
 		delete[] vAnt;
+		vAnt = nullptr;
+		migrados = tamAnt;
+	}
+
+	/**
+	 * Añade las parejas del rango [ini, fin) (de acceso aleatorio) a la tabla,
+	 * que debe tener ya sitio para todas ellas, repartiendo el trabajo entre
+	 * varios hilos (ver build_parallel):
+	 *    1. Cada hilo calcula el hash de un trozo del rango y cuenta cuántas de
+	 *       sus parejas caen en las listas de cada hilo (las listas se reparten
+	 *       en intervalos consecutivos, uno por hilo).
+	 *    2. Con esas cuentas cada hilo coloca los índices de sus parejas en
+	 *       "orden", agrupadas por el hilo al que le tocan.
+	 *    3. Cada hilo enlaza las parejas de su grupo en sus listas, en el orden
+	 *       del rango para que una clave repetida se quede con el último valor.
+	 */
+	template <typename It>
+	void insertaEnParalelo(It ini, It fin, unsigned int hilos) {
+		std::size_t n = fin - ini;
+		terminaMigracion();
+		hilos = numHilos(hilos, n / PAREJAS_POR_HILO);
+		if (hilos == 1 || !Asignador<Nodo>::SEGURO_ENTRE_HILOS) {
+			for (It it = ini; it != fin; ++it)
+				insert(it->first, it->second);
+			return;
+		}
+		// Hilo al que le toca la lista de un hash
+		auto duenno = [&](std::size_t h) {
+			return (unsigned int) ((unsigned long long) (h & (tam - 1)) * hilos / tam);
+		};
+		std::vector<std::size_t> hashes(n);
+		std::vector<std::size_t> cuenta(hilos * hilos); // [j * hilos + t]: del trozo j para el hilo t
+		enParalelo(hilos, [&](unsigned int j) {
+			std::vector<std::size_t> propia(hilos, 0);
+			for (std::size_t i = n * j / hilos; i < n * (j + 1) / hilos; ++i) {
+				hashes[i] = hashDe(ini[i].first);
+				++propia[duenno(hashes[i])];
+			}
+			std::copy(propia.begin(), propia.end(), cuenta.begin() + j * hilos);
+		});
+		// Grupo del hilo t: orden[comienzo[t]..comienzo[t + 1]), primero lo del
+		// trozo 0, luego lo del trozo 1...
+		std::vector<std::size_t> comienzo(hilos + 1);
+		std::vector<std::size_t> pos(hilos * hilos);
+		std::size_t acum = 0;
+		for (unsigned int t = 0; t < hilos; ++t) {
+			comienzo[t] = acum;
+			for (unsigned int j = 0; j < hilos; ++j) {
+				pos[j * hilos + t] = acum;
+				acum += cuenta[j * hilos + t];
+			}
+		}
+		comienzo[hilos] = n;
+		std::vector<std::size_t> orden(n);
+		enParalelo(hilos, [&](unsigned int j) {
+			for (std::size_t i = n * j / hilos; i < n * (j + 1) / hilos; ++i)
+				orden[pos[j * hilos + duenno(hashes[i])]++] = i;
+		});
+		// Si un hilo lanza una excepción (al copiar una pareja o al pedir un
+		// nodo), los nodos que ya han enlazado los demás se quedan en la tabla
+		// y se cuentan, así que la tabla sigue siendo correcta.
+		std::vector<unsigned int> nuevos(hilos, 0);
+		std::exception_ptr error;
+		try {
+			enParalelo(hilos, [&](unsigned int t) {
+				unsigned int propios = 0;
+				try {
+					for (std::size_t k = comienzo[t]; k < comienzo[t + 1]; ++k) {
+						std::size_t i = orden[k];
+						unsigned int ind = hashes[i] & (tam - 1);
+						Nodo *nodo = buscaNodo(ini[i].first, v[ind]);
+						if (nodo != nullptr)
+							nodo->valor = ini[i].second;
+						else {
+							v[ind] = asig.nuevo(ini[i].first, ini[i].second, v[ind]);
+							++propios;
+						}
+					}
+				} catch (...) {
+					nuevos[t] = propios;
+					throw;
+				}
+				nuevos[t] = propios;
+			});
+		} catch (...) {
+			error = std::current_exception();
+		}
+		for (unsigned int t = 0; t < hilos; ++t)
+			numElems += nuevos[t];
+		if (error)
+			std::rethrow_exception(error);
+	}
+
+	/**
+	 * Número de hilos que se usan: "pedidos" (o, si es 0, los que el
+	 * procesador puede ejecutar a la vez), pero no más de "maximo" ni menos de 1.
+	 */
+	static unsigned int numHilos(unsigned int pedidos, std::size_t maximo) {
+		if (pedidos == 0)
+			pedidos = std::thread::hardware_concurrency();
+		return (unsigned int) std::max<std::size_t>(1, std::min<std::size_t>(pedidos, maximo));
+	}
+
+	/**
+	 * Ejecuta fn(0), ..., fn(hilos - 1), cada una en un hilo (fn(0) en el
+	 * actual), y espera a que terminen todas. Si no se puede crear un hilo,
+	 * lo que le tocaba se ejecuta en el actual. Si alguna fn lanza una
+	 * excepción, se espera igualmente a todos los hilos y después se relanza
+	 * (la del hilo de menor número, si hay varias).
+	 */
+	template <typename F>
+	static void enParalelo(unsigned int hilos, F fn) {
+		std::vector<std::exception_ptr> errores(hilos);
+		auto ejecuta = [&errores, &fn](unsigned int t) {
+			try {
+				fn(t);
+			} catch (...) {
+				errores[t] = std::current_exception();
+			}
+		};
+		std::vector<std::thread> otros;
+		otros.reserve(hilos - 1);
+		unsigned int lanzados = 1;
+		try {
+			for (; lanzados < hilos; ++lanzados)
+				otros.emplace_back(ejecuta, lanzados);
+		} catch (std::system_error &) {
+			// No quedan hilos: el resto se hace en este
+		}
+		ejecuta(0);
+		for (unsigned int t = lanzados; t < hilos; ++t)
+			ejecuta(t);
+		for (std::thread &h : otros)
+			h.join();
+		for (std::exception_ptr &e : errores)
+			if (e)
+				std::rethrow_exception(e);
+	}
+
+	/**
+	 * Menor tamaño de la tabla (potencia de 2, no menor que TAM_INICIAL) en el
+	 * que caben n elementos sin superar la ocupación máxima.
+	 */
+	unsigned int cubetasPara(unsigned int n) const {
+		unsigned int ret = TAM_INICIAL;
+		while (100 * (double) n > maxOcupacion * (double) ret)
+			ret = doble(ret);
+		return ret;
+	}
+
+	/**
+	 * Doble de un tamaño de la tabla. Más allá de TAM_MAXIMO el tamaño ya no
+	 * cabe en un unsigned int, así que se lanza std::length_error.
+	 */
+	static unsigned int doble(unsigned int t) {
+		if (t >= TAM_MAXIMO)
+			throw std::length_error("HashMap: demasiadas listas");
+		return t * 2;
+	}
+
+	/**
+	 * Traslada a v los nodos de la lista que empieza en "nodo".
+	 * IMPORTANTE: al modificar el tamaño también se modifica el índice.
+	 * Por eficiencia NO copiamos Nodos, sino que los movemos.
+	 */
+	void mueveNodos(Nodo *nodo) {
+		while (nodo != nullptr) {
+			Nodo *aux = nodo;
+			nodo = nodo->sig;
+			unsigned int ind = indice(aux->clave); //el nuevo índice
+			aux->sig = v[ind];
+			v[ind] = aux;
+		}
+	}
+
+	/**
+	 * Si hay una migración en curso, traslada como mucho PASOS_MIGRACION
+	 * listas de vAnt a v. Al trasladar la última se libera vAnt.
+	 */
+	void migraPasos() {
+		if (vAnt == nullptr)
+			return;
+		for (unsigned int i = 0; i < PASOS_MIGRACION && migrados < tamAnt; ++i) {
+			mueveNodos(vAnt[migrados]);
+			vAnt[migrados] = nullptr;
+			++migrados;
+		}
+		if (migrados == tamAnt) {
+			// Borramos el array antiguo (ya no contiene ningún nodo).
+			delete[] vAnt;
+			vAnt = nullptr;
+		}
+	}
+
+	/** Traslada todas las listas pendientes de la migración en curso (si la hay). */
+	void terminaMigracion() {
+		while (vAnt != nullptr) {
+			mueveNodos(vAnt[migrados]);
+			vAnt[migrados] = nullptr;
+			++migrados;
+			if (migrados == tamAnt) {
+				delete[] vAnt;
+				vAnt = nullptr;
+			}
+		}
 	}
 	
+	/**
+	 * Índice de la tabla que corresponde a una clave. El resultado de la función
+	 * hash se mezcla antes de quedarnos con sus bits bajos: así funciones débiles
+	 * como std::hash<int> (la identidad) no agrupan claves con un paso fijo.
+	 * Como tam es potencia de 2, "& (tam - 1)" equivale a "% tam" sin dividir.
+	 */
+	unsigned int indice(const Clave &clave) const {
+		return (unsigned int) (hashDe(clave) & (tam - 1));
+	}
+
+	/**
+	 * Resultado de la función hash para la clave, ya mezclado. Éste y los
+	 * métodos de búsqueda que siguen admiten claves de otro tipo K para las
+	 * búsquedas transparentes.
+	 */
+	template <typename K>
+	std::size_t hashDe(const K &clave) const {
+		return mezcla((std::size_t) hash(clave));
+	}
+
+	/**
+	 * Busca la clave (cuyo hash mezclado es h) en v y, si hay una migración en
+	 * curso y la lista que le corresponde en vAnt aún no se ha trasladado,
+	 * también en vAnt.
+	 * Devuelve el nodo (nullptr si no está) y deja en "ind" y "enAnt" la lista
+	 * en la que se encuentra, tal y como los usan los iteradores.
+	 */
+	template <typename K>
+	Nodo *localiza(const K &clave, std::size_t h, unsigned int &ind, bool &enAnt) const {
+		enAnt = false;
+		ind = 0;
+		if (numElems == 0)
+			return nullptr;
+		ind = h & (tam - 1);
+		Nodo *nodo = buscaNodo(clave, v[ind]);
+		if (nodo == nullptr && vAnt != nullptr) {
+			unsigned int indAnt = h & (tamAnt - 1);
+			if (indAnt >= migrados) {
+				nodo = buscaNodo(clave, vAnt[indAnt]);
+				if (nodo != nullptr) {
+					ind = indAnt;
+					enAnt = true;
+				}
+			}
+		}
+		return nodo;
+	}
+
+	/**
+	 * Busca las claves del rango [ini, fin) (que se recorre dos veces, así que
+	 * no puede ser de un solo uso) y llama a fn con el nodo de cada una, en
+	 * orden (nullptr si no está). Se procesan en grupos de TAM_GRUPO claves:
+	 *    1. Se calcula el hash de cada clave del grupo y se pide traer a la
+	 *       caché su posición en v, sin esperar a que llegue.
+	 *    2. Se lee el primer nodo de cada lista (ya en la caché, o de camino)
+	 *       y se pide traer también ese nodo.
+	 *    3. Se buscan las claves, que casi siempre encuentran ya en la caché
+	 *       la posición de v y el primer nodo.
+	 * Así se espera a la memoria por todo el grupo a la vez en vez de por cada
+	 * clave una detrás de otra.
+	 */
+	template <typename It, typename F>
+	void buscaEnGrupos(It ini, It fin, F fn) const {
+		std::size_t hashes[TAM_GRUPO];
+		while (ini != fin) {
+			unsigned int n = 0;
+			for (It it = ini; it != fin && n < TAM_GRUPO; ++it, ++n) {
+				hashes[n] = hashDe(*it);
+				if (numElems > 0)
+					HASHMAP_PREFETCH(&v[hashes[n] & (tam - 1)]);
+			}
+			if (numElems > 0)
+				for (unsigned int k = 0; k < n; ++k)
+					HASHMAP_PREFETCH(v[hashes[k] & (tam - 1)]);
+			for (unsigned int k = 0; k < n; ++k, ++ini) {
+				unsigned int ind;
+				bool enAnt;
+				fn(localiza(*ini, hashes[k], ind, enAnt));
+			}
+		}
+	}
+
+	/**
+	 * Busca la clave y, si no está, la añade en un nodo nuevo cuyo valor se
+	 * construye con args (sin args, el valor por defecto). Devuelve el nodo con
+	 * la clave y deja en "insertado" si era nueva. Si no era nueva no se usa
+	 * ninguno de los argumentos, así que se pueden volver a usar.
+	 * El hash se calcula una sola vez y la tabla se amplía, si hace falta,
+	 * antes de buscar.
+	 * O(k) amortizado donde k es el número de colisiones en el hash.
+	 */
+	template <typename C, typename... Args>
+	Nodo *buscaOInserta(C &&clave, bool &insertado, Args&&... args) {
+		if (v == nullptr) // la tabla se movió a otra
+			redimensiona(TAM_INICIAL, false);
+		// Si la ocupación es muy alta ampliamos la tabla
+		float ocupacion = 100 * ((float) numElems) / tam;
+		if (ocupacion > maxOcupacion)
+			amplia();
+		migraPasos();
+		std::size_t h = hashDe(clave);
+		unsigned int ind;
+		bool enAnt;
+		Nodo *nodo = localiza(clave, h, ind, enAnt);
+		insertado = nodo == nullptr;
+		if (insertado) { //si la clave es nueva, creamos un nuevo nodo y lo insertamos.
+			ind = h & (tam - 1);
+			nodo = asig.nuevo(v[ind], std::forward<C>(clave), std::forward<Args>(args)...);
+			v[ind] = nodo;
+			numElems++;
+		}
+		return nodo;
+	}
+
+	/**
+	 * Si act es nullptr, avanza (ind, enAnt) hasta la siguiente lista no vacía y
+	 * deja act apuntando a su primer nodo. Se recorre primero v y después las
+	 * listas de vAnt aún sin migrar. Si no quedan más, act sigue siendo nullptr.
+	 */
+	void avanzaLista(Nodo* &act, unsigned int &ind, bool &enAnt) const {
+		while (act == nullptr) {
+			if (!enAnt && ind < tam - 1) {
+				++ind;
+				act = v[ind];
+			} else if (!enAnt && vAnt != nullptr) { // pasamos a la tabla antigua
+				enAnt = true;
+				ind = migrados;
+				act = vAnt[ind];
+			} else if (enAnt && ind < tamAnt - 1) {
+				++ind;
+				act = vAnt[ind];
+			} else
+				return;
+		}
+	}
+
 	/**
 	 * Busca un nodo a partir del nodo "act" que contenga la clave dada. Si lo 
 	 * encuentra, "act" quedará apuntando a dicho nodo y "ant" al nodo anterior.
 	 * Si no lo encuentra "act" quedará apuntando a nullptr.
 	 * O(k) donde k es el número de colisiones que haya
 	 */
-	static void buscaNodoConAnterior(const Clave &clave, Nodo* &act, Nodo* &ant) {
+	template <typename K>
+	static void buscaNodoConAnterior(const K &clave, Nodo* &act, Nodo* &ant) {
 		ant = nullptr;
 		bool encontrado = false;
 		while ((act != nullptr) && !encontrado) {
@@ -494,7 +1249,8 @@ private:
 	 * Devuelve el nodo si lo encuentra, pero no el anterior.
 	 * Se usa como función auxiliar
 	 */
-	static Nodo* buscaNodo(const Clave &clave, Nodo* n) {
+	template <typename K>
+	static Nodo* buscaNodo(const K &clave, Nodo* n) {
 		Nodo *act = n;
 		Nodo *ant = nullptr;
         buscaNodoConAnterior(clave, act, ant);
@@ -506,34 +1262,84 @@ private:
      */
     void muestra(std::ostream &out) const {
         bool primero = true;
-        for (int i = 0; i < tam; i++) {
-            Nodo * nodo = v[i];
-            while(nodo != nullptr){ //si hay algo en esta posición recorremos la lista
-                out << (primero ? " " : ", ");
-                primero = false;
-                out << nodo->clave << " -> " << nodo->valor;
-                nodo = nodo->sig;
-            }
+        for (ConstIterator it = cbegin(); it != cend(); ++it) {
+            out << (primero ? " " : ", ");
+            primero = false;
+            out << it.key() << " -> " << it.value();
         }
     }
 
 	
 	/**
-	 * Ocupación máxima permitida antes de ampliar la tabla en tanto por cientos.
+	 * Ocupación máxima por defecto antes de ampliar la tabla en tanto por cientos.
 	 */
 	static const unsigned int MAX_OCUPACION = 80;
 
+	/** Mayor tamaño de la tabla: la mayor potencia de 2 que cabe en un unsigned int. */
+	static const unsigned int TAM_MAXIMO = 1u << (8 * sizeof(unsigned int) - 1);
+
+	/**
+	 * Listas de la tabla antigua que traslada cada operación modificadora
+	 * durante una redimensión incremental. Tras duplicar, la ocupación es la
+	 * mitad de la máxima, así que la migración suele acabar mucho antes de que
+	 * haga falta volver a ampliar (si no, amplia la termina de golpe).
+	 */
+	static const unsigned int PASOS_MIGRACION = 4;
+
+	/**
+	 * Claves que se buscan a la vez en at_batch y contains_batch: suficientes
+	 * para tener ocupada la memoria con peticiones, pero no tantas como para
+	 * que lo traído para las primeras salga de la caché antes de usarlo.
+	 */
+	static const unsigned int TAM_GRUPO = 16;
+
+	/**
+	 * Trabajo mínimo que se le da a cada hilo en las operaciones en paralelo
+	 * (listas que traslada al redimensionar y parejas en build_parallel):
+	 * con menos, crear el hilo cuesta más de lo que se gana.
+	 */
+	static const unsigned int LISTAS_POR_HILO = 1 << 15;
+	static const unsigned int PAREJAS_POR_HILO = 1 << 14;
+
+	/**
+	 * Indica si al liberar la tabla basta con que el asignador libere toda su
+	 * memoria de golpe (sin recorrer las listas ni destruir los nodos).
+	 */
+	static const bool LIBERA_EN_BLOQUE =
+			Asignador<Nodo>::LIBERA_EN_BLOQUE && std::is_trivially_destructible<Nodo>::value;
+
     /** Array de punteros a Nodo */
 	Nodo **v;
 
     /** Función hash usada */
     Hash hash;
 
+    /** Asignador que crea y destruye los nodos */
+    Asignador<Nodo> asig;
+
     /** Tamaño del array v */
 	unsigned int tam;
 
     /** Número de elementos en la tabla */
 	unsigned int numElems;
+
+    /** Array antiguo durante una redimensión incremental (nullptr si no hay) */
+	Nodo **vAnt;
+
+    /** Tamaño del array vAnt */
+	unsigned int tamAnt;
+
+    /** Número de listas de vAnt ya trasladadas a v (las de índice menor) */
+	unsigned int migrados;
+
+    /** Indica si la redimensión es incremental */
+	bool incremental;
+
+    /** Indica si las ampliaciones de golpe trasladan las listas en paralelo */
+	bool paralelo;
+
+    /** Ocupación máxima permitida antes de ampliar la tabla en tanto por cientos */
+	float maxOcupacion;
 };
 
 #endif // __HASHMAP_H
@@ -0,0 +1,402 @@
+/**
+ * Implementación del TAD Diccionario para muchos lectores y pocos escritores,
+ * con lecturas sin cerrojos.
+ */
+#ifndef __LOCKFREEHASHMAP_H
+#define __LOCKFREEHASHMAP_H
+
+#include <atomic>
+#include <cstddef>
+#include <mutex>
+#include <stdexcept>
+#include <thread>
+#include <utility>
+#include <vector>
+#include "Exceptions.h"
+#include "Hash.h"
+
+/**
+ * Implementación del TAD Diccionario usando una tabla hash abierta, pensada
+ * para usarse desde muchos hilos cuando casi todas las operaciones son
+ * consultas (at, contains) y las modificaciones son raras.
+ * Las consultas no esperan nunca a nadie: no toman ningún cerrojo, y lo único
+ * que escriben es un contador de su "franja" (cada hilo usa siempre la misma de
+ * entre NUM_FRANJAS, cada una en su propia línea de caché).
+ * Las modificaciones se hacen de una en una (con un cerrojo que sólo usan los
+ * escritores) y nunca cambian un nodo que un lector pueda estar viendo:
+ *    - Las listas se enlazan con punteros atómicos; un nodo nuevo se construye
+ *       entero antes de publicarlo en la lista.
+ *    - Cambiar el valor de una clave crea un nodo nuevo que sustituye al antiguo.
+ *    - Borrar saca el nodo de la lista sin tocar su puntero al siguiente, así
+ *       que un lector que estuviera en él puede seguir recorriendo la lista.
+ *    - Al ampliar, se construye una tabla nueva con copias de los nodos y se
+ *       publica de golpe; los lectores que aún recorren la antigua la ven intacta.
+ * Lo que se saca de la estructura (nodos y tablas) no se libera enseguida sino
+ * que se "retira", y se libera cuando ningún lector puede tenerlo (reclamación
+ * por épocas): cada consulta se apunta en el contador de la época actual
+ * (par o impar) de su franja. Para liberar lo retirado, el escritor pasa a la
+ * época siguiente y espera a que se vacíen los contadores de la anterior;
+ * las consultas que empiezan después ya no pueden llegar a lo retirado.
+ * Para no esperar a los lectores en cada modificación, se libera por lotes.
+ * Las operaciones son:
+ *    - LockFreeHashMapVacio: operación generadora que construye una tabla vacía
+ *    - Insert(clave, valor): generadora que añade una nueva pareja (clave, valor)
+ *       a la tabla. Si la clave ya estaba se sustituye el valor.
+ *    - erase(clave): operación modificadora. Elimina la clave de la tabla.
+ *       Si la clave no está, la operación no tiene efecto.
+ *    - at(clave): operación observadora que devuelve (una copia de) el valor
+ *       asociado a una clave. Es un error preguntar por una clave que no existe.
+ *    - contains(clave): operación observadora. Sirve para averiguar si una clave
+ *       está presente en la tabla.
+ *    - empty(), size(): operaciones observadoras sobre el tamaño del diccionario.
+ * No hay referencias al valor ni iteradores: sólo son seguros mientras dura
+ * una consulta.
+ */
+template <typename Clave, typename Valor, typename Hash = std::hash<Clave>>
+class LockFreeHashMap {
+private:
+	/**
+	 * Nodo de una lista. La clave y el valor no cambian nunca después de
+	 * publicar el nodo; sólo cambia (atómicamente) el puntero al siguiente.
+	 */
+	class Nodo {
+	public:
+		Nodo(const Clave &clave, const Valor &valor, Nodo *sig) :
+				clave(clave), valor(valor), sig(sig) {}
+
+		/** Clave */
+		const Clave clave;
+
+		/** Valor */
+		const Valor valor;
+
+		/** Puntero al siguiente nodo */
+		std::atomic<Nodo*> sig;
+	};
+
+	/** Array de listas y su tamaño (potencia de 2), que se publican juntos. */
+	class Tabla {
+	public:
+		explicit Tabla(unsigned int tam) : v(new std::atomic<Nodo*>[tam]), tam(tam) {
+			for (unsigned int i = 0; i < tam; ++i)
+				v[i].store(nullptr, std::memory_order_relaxed);
+		}
+
+		~Tabla() {
+			delete[] v;
+		}
+
+		/** Array de punteros a la primera posición de cada lista */
+		std::atomic<Nodo*> *v;
+
+		/** Tamaño del array v */
+		unsigned int tam;
+	};
+
+	/**
+	 * Contadores de lectores en curso de una franja: uno para las épocas pares
+	 * y otro para las impares. Cada franja ocupa su propia línea de caché.
+	 */
+	class alignas(64) Franja {
+	public:
+		std::atomic<long> lectores[2] = {{0}, {0}};
+	};
+
+	/**
+	 * Mientras existe un objeto de esta clase el hilo está haciendo una
+	 * consulta, y nada de lo que pueda alcanzar desde la tabla se libera.
+	 */
+	class Lectura {
+	public:
+		explicit Lectura(const LockFreeHashMap &m) {
+			Franja &f = m.franjas[franjaDelHilo()];
+			while (true) {
+				unsigned long e = m.epoca.load();
+				contador = &f.lectores[e & 1];
+				contador->fetch_add(1);
+				// Si la época ha cambiado mientras nos apuntábamos, puede que el
+				// escritor ya no esté esperando a este contador: se repite.
+				if (m.epoca.load() == e)
+					return;
+				contador->fetch_sub(1);
+			}
+		}
+
+		~Lectura() {
+			contador->fetch_sub(1);
+		}
+
+		Lectura(const Lectura &other) = delete;
+		Lectura &operator=(const Lectura &other) = delete;
+
+	private:
+		/** Contador en el que se ha apuntado la consulta */
+		std::atomic<long> *contador;
+	};
+
+public:
+
+	/** Tamaño inicial de la tabla. */
+	static const unsigned int TAM_INICIAL = 8;
+
+	/** Constructor por defecto que implementa LockFreeHashMapVacio. O(1) */
+	LockFreeHashMap() : tabla(new Tabla(TAM_INICIAL)), numElems(0), epoca(0) {}
+
+	/**
+	 * Destructor; libera los nodos, las tablas y todo lo retirado.
+	 * Ningún otro hilo puede estar usando el diccionario.
+	 */
+	~LockFreeHashMap() {
+		Tabla *t = tabla.load();
+		for (unsigned int i = 0; i < t->tam; ++i)
+			liberaNodos(t->v[i].load());
+		delete t;
+		liberaRetirados();
+	}
+
+	/**
+	 * Operación generadora que añade una nueva clave/valor a la tabla.
+	 * Si la clave ya estaba, se sustituye su nodo por uno con el nuevo valor.
+	 * Puede tener que esperar a otros escritores y, si toca liberar lo
+	 * retirado, a las consultas en curso.
+	 * O(k) amortizado donde k es el número de colisiones en el hash.
+	 */
+	void insert(const Clave &clave, const Valor &valor) {
+		std::lock_guard<std::mutex> g(escritores);
+		if (100 * (double) (numElems.load() + 1) > MAX_OCUPACION * (double) tabla.load()->tam)
+			amplia();
+		std::atomic<Nodo*> *enlace;
+		Nodo *act = buscaEnlace(clave, enlace);
+		if (act == nullptr) {
+			enlace = &primero(clave);
+			enlace->store(new Nodo(clave, valor, enlace->load()));
+			numElems.fetch_add(1);
+		} else {
+			enlace->store(new Nodo(clave, valor, act->sig.load()));
+			retira(act);
+		}
+	}
+
+	/**
+	 * Operación modificadora que elimina una clave de la tabla.
+	 * Si la clave no existía la operación no tiene efecto.
+	 * O(k) amortizado donde k es el número de colisiones en el hash.
+	 */
+	void erase(const Clave &clave) {
+		std::lock_guard<std::mutex> g(escritores);
+		std::atomic<Nodo*> *enlace;
+		Nodo *act = buscaEnlace(clave, enlace);
+		if (act != nullptr) {
+			enlace->store(act->sig.load());
+			numElems.fetch_sub(1);
+			retira(act);
+		}
+	}
+
+	/**
+	 * Operación observadora que devuelve una copia del valor asociado a una
+	 * clave (el nodo puede liberarse en cuanto acaba la consulta).
+	 * Si no existe se lanza una excepción. No toma ningún cerrojo.
+	 * O(k) donde k es el número de colisiones en el hash.
+	 */
+	Valor at(const Clave &clave) const {
+		Lectura l(*this);
+		const Nodo *nodo = busca(clave);
+		if (nodo == nullptr)
+			throw EClaveErronea();
+		return nodo->valor;
+	}
+
+	/**
+	 * Operación observadora que indica si una clave aparece. No toma ningún cerrojo.
+	 * O(k) donde k es el número de colisiones en el hash.
+	 */
+	bool contains(const Clave &clave) const {
+		Lectura l(*this);
+		return busca(clave) != nullptr;
+	}
+
+	/** Operación observadora que devuelve si el diccionario es vacío. O(1) */
+	bool empty() const {
+		return numElems.load() == 0;
+	}
+
+	/** Operación observadora que devuelve el tamaño del diccionario. O(1) */
+	int size() const {
+		return numElems.load();
+	}
+
+	// Copiar o mover el diccionario mientras otros hilos lo usan no tendría
+	// sentido, así que no se permite.
+	LockFreeHashMap(const LockFreeHashMap &other) = delete;
+	LockFreeHashMap &operator=(const LockFreeHashMap &other) = delete;
+
+private:
+
+	/**
+	 * Busca la clave en la tabla actual sin tomar cerrojos. Sólo se puede
+	 * llamar dentro de una Lectura (o con el cerrojo de los escritores).
+	 */
+	const Nodo *busca(const Clave &clave) const {
+		Tabla *t = tabla.load(std::memory_order_acquire);
+		const Nodo *act = t->v[mezcla((std::size_t) hash(clave)) & (t->tam - 1)]
+				.load(std::memory_order_acquire);
+		while (act != nullptr && !(act->clave == clave))
+			act = act->sig.load(std::memory_order_acquire);
+		return act;
+	}
+
+	/** Puntero atómico a la primera posición de la lista de la clave. */
+	std::atomic<Nodo*> &primero(const Clave &clave) const {
+		Tabla *t = tabla.load();
+		return t->v[mezcla((std::size_t) hash(clave)) & (t->tam - 1)];
+	}
+
+	/**
+	 * Busca la clave y deja en "enlace" el puntero atómico que apunta a su
+	 * nodo (el de la tabla o el del nodo anterior). Devuelve el nodo, o
+	 * nullptr si no está. Sólo la usan los escritores.
+	 */
+	Nodo *buscaEnlace(const Clave &clave, std::atomic<Nodo*> *&enlace) const {
+		enlace = &primero(clave);
+		Nodo *act = enlace->load();
+		while (act != nullptr && !(act->clave == clave)) {
+			enlace = &act->sig;
+			act = act->sig.load();
+		}
+		return act;
+	}
+
+	/**
+	 * Duplica la tabla. Los nodos no se mueven sino que se copian, porque
+	 * puede haber lectores recorriendo las listas antiguas; la tabla antigua
+	 * y sus nodos se retiran. Si falla una copia, la tabla nueva se descarta
+	 * y la antigua sigue como estaba.
+	 */
+	void amplia() {
+		Tabla *ant = tabla.load();
+		Tabla *nueva = new Tabla(doble(ant->tam));
+		try {
+			for (unsigned int i = 0; i < ant->tam; ++i)
+				for (Nodo *act = ant->v[i].load(); act != nullptr; act = act->sig.load()) {
+					std::atomic<Nodo*> &lista =
+							nueva->v[mezcla((std::size_t) hash(act->clave)) & (nueva->tam - 1)];
+					lista.store(new Nodo(act->clave, act->valor, lista.load()), std::memory_order_relaxed);
+				}
+			nodosRetirados.reserve(nodosRetirados.size() + numElems.load());
+			tablasRetiradas.reserve(tablasRetiradas.size() + 1);
+		} catch (...) {
+			for (unsigned int i = 0; i < nueva->tam; ++i)
+				liberaNodos(nueva->v[i].load());
+			delete nueva;
+			throw;
+		}
+		for (unsigned int i = 0; i < ant->tam; ++i)
+			for (Nodo *act = ant->v[i].load(); act != nullptr; act = act->sig.load())
+				nodosRetirados.push_back(act);
+		tabla.store(nueva, std::memory_order_release);
+		tablasRetiradas.push_back(ant);
+		if (nodosRetirados.size() >= LOTE_RETIRADOS)
+			recoge();
+	}
+
+	/**
+	 * Doble de un tamaño de la tabla. Más allá de TAM_MAXIMO el tamaño ya no
+	 * cabe en un unsigned int, así que se lanza std::length_error.
+	 */
+	static unsigned int doble(unsigned int t) {
+		if (t >= TAM_MAXIMO)
+			throw std::length_error("LockFreeHashMap: demasiadas listas");
+		return t * 2;
+	}
+
+	/** Retira un nodo que ya no se puede alcanzar desde la tabla. */
+	void retira(Nodo *nodo) {
+		nodosRetirados.push_back(nodo);
+		if (nodosRetirados.size() >= LOTE_RETIRADOS)
+			recoge();
+	}
+
+	/**
+	 * Pasa a la época siguiente y espera a que terminen todas las consultas
+	 * apuntadas en la anterior. Las que siguen en curso (o empiecen) lo
+	 * hacen en la nueva época, después de que lo retirado dejase de ser
+	 * alcanzable, así que ya se puede liberar.
+	 */
+	void recoge() {
+		unsigned long e = epoca.load();
+		epoca.store(e + 1);
+		for (unsigned int i = 0; i < NUM_FRANJAS; ++i)
+			while (franjas[i].lectores[e & 1].load() != 0)
+				std::this_thread::yield();
+		liberaRetirados();
+	}
+
+	/** Libera todos los nodos y tablas retirados. */
+	void liberaRetirados() {
+		for (Nodo *n : nodosRetirados)
+			delete n;
+		nodosRetirados.clear();
+		for (Tabla *t : tablasRetiradas)
+			delete t;
+		tablasRetiradas.clear();
+	}
+
+	/** Libera un nodo y todos los siguientes. */
+	static void liberaNodos(Nodo *prim) {
+		while (prim != nullptr) {
+			Nodo *aux = prim;
+			prim = prim->sig.load();
+			delete aux;
+		}
+	}
+
+	/**
+	 * Franja de contadores del hilo actual. Los hilos se reparten las franjas
+	 * por orden de llegada, así que hasta NUM_FRANJAS hilos no comparten ninguna.
+	 */
+	static unsigned int franjaDelHilo() {
+		static std::atomic<unsigned int> siguiente(0);
+		thread_local unsigned int franja =
+				siguiente.fetch_add(1, std::memory_order_relaxed) % NUM_FRANJAS;
+		return franja;
+	}
+
+	/** Ocupación máxima antes de ampliar la tabla, en tanto por cientos. */
+	static const unsigned int MAX_OCUPACION = 80;
+
+	/** Mayor tamaño de la tabla: la mayor potencia de 2 que cabe en un unsigned int. */
+	static const unsigned int TAM_MAXIMO = 1u << (8 * sizeof(unsigned int) - 1);
+
+	/** Número de franjas de contadores de lectores. */
+	static const unsigned int NUM_FRANJAS = 64;
+
+	/** Nodos retirados a partir de los cuales se liberan. */
+	static const std::size_t LOTE_RETIRADOS = 256;
+
+	/** Tabla actual */
+	std::atomic<Tabla*> tabla;
+
+	/** Número de elementos en la tabla */
+	std::atomic<int> numElems;
+
+	/** Época actual: su paridad indica en qué contador se apuntan las consultas */
+	std::atomic<unsigned long> epoca;
+
+	/** Contadores de consultas en curso */
+	mutable Franja franjas[NUM_FRANJAS];
+
+	/** Cerrojo que sólo toman los escritores */
+	std::mutex escritores;
+
+	/** Nodos retirados pendientes de liberar (sólo los usan los escritores) */
+	std::vector<Nodo*> nodosRetirados;
+
+	/** Tablas retiradas pendientes de liberar (sólo las usan los escritores) */
+	std::vector<Tabla*> tablasRetiradas;
+
+	/** Función hash usada */
+	Hash hash;
+};
+
+#endif // __LOCKFREEHASHMAP_H
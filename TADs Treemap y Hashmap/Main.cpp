@@ -0,0 +1,32 @@
+#include "Benchmarks.h"
+#include "Tests.h"
+
+int main(){
+	testClosedHashMap();
+	testHashMapIncremental();
+	testHashMapReserva();
+	testHashMapMovido();
+	testHashMapTransparente();
+	testBTreeMap();
+	testTreeMapNavegacion();
+	testTreeMapOrden();
+	testTreeMapMasivo();
+	testTreeMapSplitJoin();
+	testPersistentTreeMap();
+	testTreeMapPistas();
+	testTreeMapConjuntos();
+	testFlatMap();
+	testConcurrentHashMap();
+	testLockFreeHashMap();
+	testHashMapBatch();
+	testDenseHashMap();
+	//benchClosedHashMap();
+	//benchHash();
+	//benchArena();
+	//benchTreeMapOrden();
+	//benchBTreeMap();
+	//benchConcurrentHashMap();
+	//benchLockFreeHashMap();
+	//benchBuildParallel();
+	benchBatch();
+}
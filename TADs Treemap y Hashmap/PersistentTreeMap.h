@@ -0,0 +1,396 @@
+/**
+ * Implementación del TAD Dictionary persistente utilizando árboles AVL
+ * que comparten su estructura.
+ */
+
+#ifndef __PERSISTENTTREEMAP_H
+#define __PERSISTENTTREEMAP_H
+
+#include <functional>
+#include <memory>
+#include <utility>
+#include "Exceptions.h"
+#include "Stack.h"
+
+/**
+ * Implementación dinámica del TAD Dictionary persistente: un diccionario no se
+ * modifica nunca, sino que insert y erase devuelven un diccionario nuevo (una
+ * nueva versión) y dejan intacto el original.
+ * Como en Arbin, los nodos se comparten entre versiones y se cuenta cuántas
+ * referencias hay a cada uno, pero aquí se usan punteros inteligentes
+ * (std::shared_ptr a nodos constantes), como en ArbinS:
+ *    - insert y erase copian sólo los nodos del camino desde la raíz hasta la
+ *          clave (y los que hay que rotar para reequilibrar), O(log n) nodos, y
+ *          la versión nueva comparte con la antigua todos los demás.
+ *    - Copiar un diccionario es O(1): la copia comparte la raíz.
+ *    - Un nodo se libera cuando ya no lo usa ninguna versión.
+ * El árbol es un AVL (las alturas de los dos hijos de cualquier nodo difieren
+ * como mucho en 1), así que todas las operaciones son O(log n) en el caso peor.
+ * Los nodos no tienen puntero al padre (un nodo compartido tiene un padre en
+ * cada versión), así que los iteradores guardan una pila con los ascendientes.
+ * Como los nodos no cambian nunca, varios hilos pueden leer a la vez copias de un
+ * mismo diccionario mientras otro hilo crea versiones nuevas; lo que no se puede
+ * es leer y reasignar a la vez la misma variable.
+ * Las operaciones son:
+ *    - PersistentTreeMapVacio: operación generadora que construye un diccionario vacío.
+ *    - insert(clave, valor): generadora que devuelve el diccionario con la nueva pareja
+ *          (clave, valor). Si la clave ya estaba se sustituye el valor.
+ *    - erase(clave): devuelve el diccionario sin la clave. Si la clave no está
+ *          devuelve el mismo diccionario.
+ *    - at(clave): operación observadora que devuelve el valor asociado a una clave.
+ *          Es un error preguntar por una clave que no existe.
+ *    - contains(clave): operación observadora. Sirve para averiguar si se ha introducido una
+ *          clave en el diccionario
+ *    - empty(): operación observadora que indica si el diccionario tiene alguna clave introducida.
+ *    - size(): operación observadora que indica el tamaño del diccionario.
+ * Uso típico: m = m.insert(clave, valor); las copias que se hicieron antes de m
+ * siguen viendo la versión anterior.
+ */
+template <typename Clave, typename Valor, typename Comparador = std::less<Clave>>
+class PersistentTreeMap {
+private:
+	/**
+	 * Clase nodo que almacena internamente la pareja (clave, valor), los
+	 * punteros inteligentes a los hijos y la altura de su subárbol.
+	 * Un nodo no se modifica después de construirlo.
+	 */
+	class Nodo;
+	using Link = std::shared_ptr<const Nodo>; // Alias de tipo
+
+	class Nodo {
+	public:
+		Nodo(const Link &iz, const Clave &clave, const Valor &valor, const Link &dr)
+			: clave(clave), valor(valor), iz(iz), dr(dr), altura(1 + alturaMayor(iz, dr)) {}
+
+		const Clave clave;
+		const Valor valor;
+		const Link iz;
+		const Link dr;
+		const int altura;
+
+	private:
+		/** Altura del más alto de los dos subárboles. */
+		static int alturaMayor(const Link &iz, const Link &dr) {
+			int a = iz == nullptr ? 0 : iz->altura;
+			int b = dr == nullptr ? 0 : dr->altura;
+			return a > b ? a : b;
+		}
+	};
+
+public:
+
+	/** Constructor; operación PersistentTreeMapVacio. O(1) */
+	PersistentTreeMap() : ra(nullptr), numElems(0) {}
+
+	/**
+	 * Devuelve un diccionario igual a éste pero con la pareja (clave, valor).
+	 * Si la clave ya existía, en el nuevo se sustituye el valor viejo por el nuevo.
+	 * Éste no cambia.
+	 * O(log n)
+	 */
+	PersistentTreeMap insert(const Clave &clave, const Valor &valor) const {
+		bool nueva = false;
+		Link r = insertaAux(ra, clave, valor, nueva);
+		return PersistentTreeMap(r, nueva ? numElems + 1 : numElems, cless);
+	}
+
+	/**
+	 * Devuelve un diccionario igual a éste pero sin la clave. Si la clave no
+	 * existía se devuelve una copia de éste (sin copiar ningún nodo).
+	 * Éste no cambia.
+	 * O(log n)
+	 */
+	PersistentTreeMap erase(const Clave &clave) const {
+		bool borrada = false;
+		Link r = borraAux(ra, clave, borrada);
+		return PersistentTreeMap(r, borrada ? numElems - 1 : numElems, cless);
+	}
+
+	/**
+	 * Operación observadora que devuelve el valor asociado
+	 * a una clave dada. O(log n)
+	 */
+	const Valor &at(const Clave &clave) const {
+		const Nodo *p = buscaAux(clave);
+		if (p == nullptr)
+			throw EClaveErronea();
+		return p->valor;
+	}
+
+	/**
+	 * Operación observadora que permite averiguar si una clave
+	 * determinada está en el diccionario. O(log n)
+	 */
+	bool contains(const Clave &clave) const {
+		return buscaAux(clave) != nullptr;
+	}
+
+	/** Operación observadora que devuelve si un diccionario es vacío */
+	bool empty() const {
+		return ra == nullptr;
+	}
+
+	/** Operación observadora que devuelve el tamaño de un diccionario */
+	int size() const {
+		return numElems;
+	}
+
+
+	// //
+	// ITERADOR CONSTANTE Y FUNCIONES RELACIONADAS
+	// //
+
+	/**
+	 * Clase interna que implementa un iterador que permite recorrer el árbol
+	 * en inorden. No hay iterador no constante: los nodos no se modifican.
+	 * El iterador no mantiene viva la versión: deja de ser válido si se
+	 * destruye (o se reasigna) el último diccionario que la usaba.
+	 */
+	class ConstIterator {
+	public:
+		ConstIterator() : act(nullptr) {}
+
+		/** O(1) amortizado en un recorrido completo (O(log n) en el caso peor) */
+		void next() {
+			if (act == nullptr)
+				throw InvalidAccessException();
+			// Si hay hijo derecho, saltamos al primero en inorden del hijo derecho
+			if (act->dr != nullptr)
+				act = primeroInOrden(act->dr.get());
+			else {
+				// Si no, vamos al primer ascendiente no visitado
+				if (ascendientes.empty()) // Ya no hay por visitar
+					act = nullptr;
+				else {
+					act = ascendientes.top();
+					ascendientes.pop();
+				}
+			}
+		}
+
+		/** O(1) */
+		const Clave &key() const {
+			if (act == nullptr) throw InvalidAccessException();
+			return act->clave;
+		}
+
+		/** O(1) */
+		const Valor &value() const {
+			if (act == nullptr) throw InvalidAccessException();
+			return act->valor;
+		}
+
+		/** O(1) */
+		bool operator==(const ConstIterator &other) const {
+			return act == other.act;
+		}
+
+		/** O(1) */
+		bool operator!=(const ConstIterator &other) const {
+			return !(this->operator==(other));
+		}
+
+		ConstIterator &operator++() {
+			next();
+			return *this;
+		}
+
+		ConstIterator operator++(int) {
+			ConstIterator ret(*this);
+			operator++();
+			return ret;
+		}
+
+	protected:
+		friend class PersistentTreeMap;
+
+		ConstIterator(const Nodo *act) {
+			this->act = primeroInOrden(act);
+		}
+
+		/**
+		 * Busca el primer elemento en inorden de la estructura jerárquica de nodos.
+		 * Va apilando sus ascendientes para poder "ir hacia atrás" cuando sea necesario.
+		 */
+		const Nodo *primeroInOrden(const Nodo *p) {
+			if (p == nullptr)
+				return nullptr;
+			while (p->iz != nullptr) {
+				ascendientes.push(p);
+				p = p->iz.get();
+			}
+			return p;
+		}
+
+		/** Puntero al nodo actual del recorrido */
+		const Nodo *act;
+
+		/** Ascendientes del nodo actual aún por visitar */
+		Stack<const Nodo*> ascendientes;
+	};
+
+	/** Devuelve el iterador constante al principio del diccionario (clave más pequeña). */
+	ConstIterator cbegin() const {
+		return ConstIterator(ra.get());
+	}
+
+	/** Devuelve un iterador constante al final del recorrido (fuera de éste). */
+	ConstIterator cend() const {
+		return ConstIterator(nullptr);
+	}
+
+	ConstIterator begin() const {
+		return cbegin();
+	}
+
+	ConstIterator end() const {
+		return cend();
+	}
+
+	/**
+	 * Devuelve un iterador constante a la pareja con esa clave, o cend() si no
+	 * está. Al bajar se apilan los nodos en los que se gira a la izquierda,
+	 * que son los que quedan por visitar después de la clave. O(log n)
+	 */
+	ConstIterator find(const Clave &clave) const {
+		ConstIterator it;
+		const Nodo *p = ra.get();
+		while (p != nullptr) {
+			if (cless(clave, p->clave)) {
+				it.ascendientes.push(p);
+				p = p->iz.get();
+			} else if (cless(p->clave, clave))
+				p = p->dr.get();
+			else {
+				it.act = p;
+				return it;
+			}
+		}
+		return cend();
+	}
+
+private:
+	/** Constructor que crea una versión a partir de una raíz ya construida. */
+	PersistentTreeMap(const Link &ra, int numElems, const Comparador &cless)
+		: ra(ra), cless(cless), numElems(numElems) {}
+
+	/** Nodo con esa clave (nullptr si no está). O(log n) */
+	const Nodo *buscaAux(const Clave &clave) const {
+		const Nodo *p = ra.get();
+		while (p != nullptr) {
+			if (cless(clave, p->clave))
+				p = p->iz.get();
+			else if (cless(p->clave, clave))
+				p = p->dr.get();
+			else
+				return p;
+		}
+		return nullptr;
+	}
+
+	/**
+	 * Devuelve la raíz de una copia de p con la pareja (clave, valor). Sólo se
+	 * crean nodos nuevos en el camino hasta la clave; cada uno se construye con
+	 * equilibra a partir del hijo ya modificado y del otro hijo, compartido.
+	 * "nueva" indica si la clave no estaba.
+	 * O(log n)
+	 */
+	Link insertaAux(const Link &p, const Clave &clave, const Valor &valor, bool &nueva) const {
+		if (p == nullptr) {
+			nueva = true;
+			return std::make_shared<const Nodo>(nullptr, clave, valor, nullptr);
+		} else if (cless(clave, p->clave))
+			return equilibra(insertaAux(p->iz, clave, valor, nueva), p->clave, p->valor, p->dr);
+		else if (cless(p->clave, clave))
+			return equilibra(p->iz, p->clave, p->valor, insertaAux(p->dr, clave, valor, nueva));
+		else // la clave ya estaba: nodo nuevo con el nuevo valor
+			return std::make_shared<const Nodo>(p->iz, p->clave, valor, p->dr);
+	}
+
+	/**
+	 * Devuelve la raíz de una copia de p sin la clave, o el propio p (sin
+	 * copiar nada) si la clave no estaba. "borrada" indica si estaba.
+	 * O(log n)
+	 */
+	Link borraAux(const Link &p, const Clave &clave, bool &borrada) const {
+		if (p == nullptr)
+			return p;
+		if (cless(clave, p->clave)) {
+			Link iz = borraAux(p->iz, clave, borrada);
+			return borrada ? equilibra(iz, p->clave, p->valor, p->dr) : p;
+		} else if (cless(p->clave, clave)) {
+			Link dr = borraAux(p->dr, clave, borrada);
+			return borrada ? equilibra(p->iz, p->clave, p->valor, dr) : p;
+		}
+		borrada = true;
+		if (p->iz == nullptr)
+			return p->dr;
+		if (p->dr == nullptr)
+			return p->iz;
+		// Dos hijos: el mínimo del hijo derecho ocupa el lugar de p
+		const Nodo *min;
+		Link dr = quitaMinimo(p->dr, min);
+		return equilibra(p->iz, min->clave, min->valor, dr);
+	}
+
+	/**
+	 * Devuelve la raíz de una copia de p sin su nodo mínimo, que se deja en min
+	 * (sigue existiendo porque lo mantiene vivo p). O(log n)
+	 */
+	static Link quitaMinimo(const Link &p, const Nodo *&min) {
+		if (p->iz == nullptr) {
+			min = p.get();
+			return p->dr;
+		}
+		return equilibra(quitaMinimo(p->iz, min), p->clave, p->valor, p->dr);
+	}
+
+	/** Altura de un subárbol (0 si es vacío). */
+	static int altura(const Link &p) {
+		return p == nullptr ? 0 : p->altura;
+	}
+
+	/**
+	 * Crea un nodo nuevo con los hijos iz y dr, cuyas alturas difieren como
+	 * mucho en 2 (lo que puede pasar tras insertar o borrar en uno de ellos).
+	 * Si difieren en 2 no se rota ningún nodo existente, sino que se crean los
+	 * nodos de la rotación simple o doble correspondiente, compartiendo los
+	 * nietos. Devuelve la raíz del subárbol ya equilibrado. O(1)
+	 */
+	static Link equilibra(const Link &iz, const Clave &clave, const Valor &valor, const Link &dr) {
+		int hiz = altura(iz), hdr = altura(dr);
+		if (hiz > hdr + 1) {
+			if (altura(iz->iz) >= altura(iz->dr)) // rotación a la derecha
+				return nodo(iz->iz, iz->clave, iz->valor, nodo(iz->dr, clave, valor, dr));
+			// rotación doble: el hijo derecho de iz sube a la raíz
+			const Link &n = iz->dr;
+			return nodo(nodo(iz->iz, iz->clave, iz->valor, n->iz), n->clave, n->valor,
+					nodo(n->dr, clave, valor, dr));
+		}
+		if (hdr > hiz + 1) {
+			if (altura(dr->dr) >= altura(dr->iz)) // rotación a la izquierda
+				return nodo(nodo(iz, clave, valor, dr->iz), dr->clave, dr->valor, dr->dr);
+			// rotación doble: el hijo izquierdo de dr sube a la raíz
+			const Link &n = dr->iz;
+			return nodo(nodo(iz, clave, valor, n->iz), n->clave, n->valor,
+					nodo(n->dr, dr->clave, dr->valor, dr->dr));
+		}
+		return nodo(iz, clave, valor, dr);
+	}
+
+	/** Crea un nodo nuevo. */
+	static Link nodo(const Link &iz, const Clave &clave, const Valor &valor, const Link &dr) {
+		return std::make_shared<const Nodo>(iz, clave, valor, dr);
+	}
+
+	/** Puntero inteligente a la raíz de la estructura jerárquica de nodos. */
+	Link ra;
+
+	/** Comparador: menor estricto. */
+	Comparador cless;
+
+	/** Número de elementos */
+	int numElems;
+};
+
+#endif // __PERSISTENTTREEMAP_H
@@ -0,0 +1,1086 @@
+#include <algorithm>
+#include <atomic>
+#include <iostream>
+#include <iterator>
+#include <map>
+#include <random>
+#include <set>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <utility>
+#include <vector>
+using namespace std;
+
+#include "ClosedHashMap.h"
+#include "HashMap.h"
+#include "BTreeMap.h"
+#include "TreeMap.h"
+#include "PersistentTreeMap.h"
+#include "FlatMap.h"
+#include "ConcurrentHashMap.h"
+#include "LockFreeHashMap.h"
+#include "DenseHashMap.h"
+
+// Pruebas de los diccionarios contra std::map (o std::set): se hacen las
+// mismas operaciones, casi siempre al azar, en los dos y se comprueba que
+// acaban con el mismo contenido. Conviene compilarlas también con
+// -fsanitize=address (y las de varios hilos con -fsanitize=thread).
+
+static void comprueba(bool cond, const char *que){
+	cout << (cond ? "OK    " : "ERROR ") << que << endl;
+}
+
+/**
+ * Indica si el diccionario m tiene exactamente las parejas de esperado y,
+ * al recorrerlo, salen en el mismo orden que en esperado.
+ */
+template <typename M, typename K, typename V>
+static bool igualOrdenado(const M &m, const map<K, V> &esperado){
+	if (m.size() != (int) esperado.size())
+		return false;
+	auto e = esperado.begin();
+	for (auto it = m.cbegin(); it != m.cend(); ++it, ++e)
+		if (e == esperado.end() || !(it.key() == e->first) || !(it.value() == e->second))
+			return false;
+	return e == esperado.end();
+}
+
+/**
+ * Indica si el diccionario m (sin orden) tiene exactamente las parejas de
+ * esperado: el recorrido pasa una vez por cada una y at y contains las encuentran.
+ */
+template <typename M, typename K, typename V>
+static bool igualSinOrden(const M &m, const map<K, V> &esperado){
+	if (m.size() != (int) esperado.size())
+		return false;
+	set<K> vistas;
+	for (auto it = m.cbegin(); it != m.cend(); ++it){
+		auto e = esperado.find(it.key());
+		if (e == esperado.end() || !(it.value() == e->second) || !vistas.insert(it.key()).second)
+			return false;
+	}
+	for (const auto &p : esperado)
+		if (!m.contains(p.first) || !(m.at(p.first) == p.second))
+			return false;
+	return vistas.size() == esperado.size();
+}
+
+/**
+ * Función hash que da lo mismo para todas las claves: todas chocan. Tras la
+ * mezcla de MurmurHash3 que hace ClosedHashMap, 8798 tiene a 1 sus 12 bits
+ * bajos, así que su posición inicial es la última celda de la tabla (en
+ * cualquier tabla de hasta 4096 celdas) y el bloque de claves siempre da la
+ * vuelta.
+ */
+class HashConstante {
+public:
+	size_t operator()(int) const {
+		return 8798;
+	}
+};
+
+/**
+ * Prueba aleatoria de ClosedHashMap: inserciones, borrados y operator[] sobre
+ * claves de [0, rango), comparando con un map. Se comprueba todo el contenido
+ * cada cierto número de operaciones.
+ */
+template <typename H>
+static void pruebaClosedHashMap(int rango, float ocupacion, unsigned int semilla){
+	const int OPS = 100000;
+	ClosedHashMap<int, int, H> m;
+	m.max_load_factor(ocupacion);
+	map<int, int> e;
+	mt19937 gen(semilla);
+	bool bien = true, maxima = true;
+	for (int i = 0; i < OPS && bien; ++i){
+		int c = (int) (gen() % rango);
+		switch (gen() % 4){
+		case 0:
+			m.insert(c, i);
+			e[c] = i;
+			break;
+		case 1:
+			m.erase(c);
+			e.erase(c);
+			break;
+		case 2:
+			m[c] += 1;
+			e[c] += 1;
+			break;
+		default:
+			bien = m.contains(c) == (e.count(c) == 1);
+		}
+		maxima = maxima && m.load_factor() <= ocupacion;
+		if (i % 1000 == 0)
+			bien = bien && igualSinOrden(m, e);
+	}
+	comprueba(bien && igualSinOrden(m, e), "same contents as std::map");
+	comprueba(maxima, "load factor never above the maximum");
+	ClosedHashMap<int, int, H> copia(m);
+	for (int c = 0; c < rango; c += 2){
+		m.erase(c);
+		e.erase(c);
+	}
+	comprueba(igualSinOrden(m, e), "erase every other key");
+	copia = m;
+	comprueba(igualSinOrden(copia, e), "copy");
+}
+
+/**
+ * ClosedHashMap. Con la función hash constante todas las claves forman un
+ * único bloque de celdas seguidas que empieza en la última, así que da la
+ * vuelta al final de la tabla (y los grupos de control se leen de la copia
+ * que hay tras el final) y cada borrado desplaza hacia atrás todo lo que le
+ * sigue. Conviene compilarla también con -U__SSE2__ para probar la búsqueda
+ * en grupos sin SSE2.
+ */
+void testClosedHashMap(){
+	cout << "ClosedHashMap, random insert/erase/operator[] against std::map" << endl;
+	pruebaClosedHashMap<std::hash<int>>(5000, 0.9f, 1);
+	cout << "ClosedHashMap, every key with the same hash" << endl;
+	pruebaClosedHashMap<HashConstante>(200, 0.95f, 2);
+}
+
+/**
+ * HashMap con redimensión incremental: mientras las listas de la tabla
+ * antigua se van trasladando (unas pocas en cada operación) se busca, se
+ * borra y se recorre la tabla, que tiene que ver las dos a la vez.
+ */
+void testHashMapIncremental(){
+	cout << "HashMap, incremental rehash against std::map" << endl;
+	const int OPS = 60000, RANGO = 20000;
+	HashMap<int, int> m;
+	m.set_incremental_rehash(true);
+	map<int, int> e;
+	mt19937 gen(3);
+	bool bien = true, copias = true;
+	for (int i = 0; i < OPS && bien; ++i){
+		// Primero sobre todo se inserta (la tabla crece y migra muchas veces)
+		// y al final sobre todo se borra
+		int c = (int) (gen() % RANGO);
+		unsigned int op = gen() % 10;
+		if (op < (i < OPS / 2 ? 7u : 3u)){
+			m.insert(c, i);
+			e[c] = i;
+		} else if (op < 9){
+			m.erase(c);
+			e.erase(c);
+		} else {
+			m[c] += 1;
+			e[c] += 1;
+		}
+		if (i % 97 == 0)
+			bien = igualSinOrden(m, e);
+		if (i % 4999 == 0){
+			HashMap<int, int> copia(m);
+			copias = copias && igualSinOrden(copia, e);
+		}
+	}
+	comprueba(bien && igualSinOrden(m, e), "same contents as std::map while migrating");
+	comprueba(copias, "copies made while migrating");
+	m.set_incremental_rehash(false);
+	comprueba(igualSinOrden(m, e), "after finishing the migration");
+}
+
+/**
+ * HashMap: reserve, rehash, shrink_to_fit y max_load_factor cambian el
+ * tamaño de la tabla pero no su contenido.
+ */
+void testHashMapReserva(){
+	cout << "HashMap, reserve/rehash/shrink_to_fit" << endl;
+	const int N = 10000;
+	HashMap<int, int> m;
+	map<int, int> e;
+	m.reserve(N);
+	unsigned int cubetas = m.bucket_count();
+	for (int i = 0; i < N; ++i){
+		m.insert(i * 7, i);
+		e[i * 7] = i;
+	}
+	comprueba(m.bucket_count() == cubetas && igualSinOrden(m, e), "reserve: no growth while filling");
+	m.rehash(4 * cubetas);
+	comprueba(m.bucket_count() >= 4 * cubetas && igualSinOrden(m, e), "rehash to a bigger table");
+	m.rehash(1);
+	comprueba(m.bucket_count() == cubetas && igualSinOrden(m, e), "rehash never below what the elements need");
+	for (int i = 0; i < N; ++i)
+		if (i % 100 != 0){
+			m.erase(i * 7);
+			e.erase(i * 7);
+		}
+	m.shrink_to_fit();
+	comprueba(m.bucket_count() < cubetas / 32 && igualSinOrden(m, e), "shrink_to_fit after erasing");
+	m.max_load_factor(0.25f);
+	comprueba(m.load_factor() <= 0.25f && igualSinOrden(m, e), "lower max_load_factor");
+	bool lanza = false;
+	try {
+		m.reserve(3000000000u);
+	} catch (length_error &) {
+		lanza = true;
+	}
+	comprueba(lanza && igualSinOrden(m, e), "impossible reserve throws and keeps the contents");
+	// rehash en mitad de una redimensión incremental
+	m.set_incremental_rehash(true);
+	for (int i = 0; i < N; ++i){
+		m.insert(-i, i);
+		e[-i] = i;
+		if (i == N / 2)
+			m.rehash(0);
+	}
+	comprueba(igualSinOrden(m, e), "rehash while migrating");
+}
+
+/**
+ * HashMap: después de mover una tabla, la original se queda sin listas y
+ * tiene que poder seguir usándose (consultarse, copiarse y volver a llenarse).
+ */
+void testHashMapMovido(){
+	cout << "HashMap, moved-from tables and emplace" << endl;
+	HashMap<int, string> m;
+	map<int, string> e;
+	for (int i = 0; i < 1000; ++i){
+		m.insert(i, to_string(i));
+		e[i] = to_string(i);
+	}
+	HashMap<int, string> destino(std::move(m));
+	comprueba(igualSinOrden(destino, e), "move constructor");
+	bool lanza = false;
+	try {
+		m.at(1);
+	} catch (EClaveErronea &) {
+		lanza = true;
+	}
+	comprueba(m.empty() && !m.contains(1) && lanza && m.cbegin() == m.cend(), "moved-from table is empty");
+	m.erase(1);
+	HashMap<int, string> copiaVacia(m);
+	comprueba(copiaVacia.empty() && copiaVacia.cbegin() == copiaVacia.cend(), "copy of a moved-from table");
+	copiaVacia.insert(5, "5");
+	comprueba(copiaVacia.size() == 1 && copiaVacia.at(5) == "5", "the copy can be filled");
+	m[7] = "7";
+	m.insert(8, "8");
+	comprueba(m.size() == 2 && m.at(7) == "7" && m.at(8) == "8", "a moved-from table can be filled again");
+	m = std::move(destino);
+	comprueba(igualSinOrden(m, e) && destino.empty(), "move assignment");
+	destino = m;
+	comprueba(igualSinOrden(destino, e), "copy into a moved-from table");
+
+	// emplace, try_emplace e insert_or_assign no tocan los argumentos si la clave ya estaba
+	string valor = "nuevo";
+	bool nueva = m.try_emplace(1, std::move(valor));
+	comprueba(!nueva && valor == "nuevo" && m.at(1) == "1", "try_emplace on an existing key");
+	nueva = m.try_emplace(2000, 3, 'x');
+	comprueba(nueva && m.at(2000) == "xxx", "try_emplace on a new key");
+	nueva = m.emplace(2001, "a");
+	comprueba(nueva && !m.emplace(2001, "b") && m.at(2001) == "a", "emplace");
+	nueva = m.insert_or_assign(2001, string("c"));
+	comprueba(!nueva && m.at(2001) == "c" && m.insert_or_assign(2002, "d"), "insert_or_assign");
+}
+
+/**
+ * Búsquedas transparentes: con Hash<string> (o std::less<> en TreeMap) se
+ * puede buscar con un std::string_view o un const char* sin crear un string.
+ */
+void testHashMapTransparente(){
+	cout << "HashMap and TreeMap, string_view and const char* lookups" << endl;
+	HashMap<string, int, Hash<string>> h;
+	TreeMap<string, int, less<>> t;
+	for (int i = 0; i < 500; ++i){
+		h.insert("key" + to_string(i), i);
+		t.insert("key" + to_string(i), i);
+	}
+	bool bien = true;
+	for (int i = 0; i < 600; ++i){
+		string s = "key" + to_string(i);
+		string_view sv = s;
+		const char *cs = s.c_str();
+		bool esta = i < 500;
+		bien = bien && h.contains(sv) == esta && h.contains(cs) == esta &&
+				t.contains(sv) == esta && t.contains(cs) == esta &&
+				(h.find(sv) != h.end()) == esta && (t.find(cs) != t.end()) == esta;
+		if (esta)
+			bien = bien && h.at(sv) == i && h.at(cs) == i && t.at(sv) == i && t.at(cs) == i &&
+					h.find(cs).value() == i && t.find(sv).value() == i;
+	}
+	comprueba(bien, "lookups by string_view and const char*");
+	// Un trozo de una cadena más larga: sólo cuentan sus caracteres
+	string largo = "key42 and more";
+	comprueba(h.contains(string_view(largo).substr(0, 5)) && t.at(string_view(largo).substr(0, 5)) == 42,
+			"string_view into a longer string");
+}
+
+/**
+ * BTreeMap con muchos borrados: las hojas e internos se quedan escasos y hay
+ * que pedir prestado a los hermanos o fusionarlos. Se comprueba el contenido
+ * recorriendo la lista enlazada de hojas.
+ */
+void testBTreeMap(){
+	cout << "BTreeMap, erase-heavy random test against std::map" << endl;
+	const int N = 50000, RANGO = 100000;
+	BTreeMap<int, int> m;
+	map<int, int> e;
+	mt19937 gen(4);
+	for (int i = 0; i < N; ++i){
+		int c = (int) (gen() % RANGO);
+		m.insert(c, i);
+		e[c] = i;
+	}
+	comprueba(igualOrdenado(m, e), "after the inserts");
+	bool bien = true;
+	for (int i = 0; !e.empty() && bien; ++i){
+		int c = (int) (gen() % RANGO);
+		if (gen() % 5 == 0){
+			m.insert(c, i);
+			e[c] = i;
+		} else {
+			// Casi siempre se borra una clave que está (la primera mayor o igual que c)
+			auto it = e.lower_bound(c);
+			if (it != e.end())
+				c = it->first;
+			m.erase(c);
+			e.erase(c);
+		}
+		if (i % 1000 == 0)
+			bien = igualOrdenado(m, e);
+	}
+	comprueba(bien && m.empty() && m.cbegin() == m.cend(), "random erases until empty");
+	for (int i = 0; i < N; ++i){
+		m.insert(i, i);
+		e[i] = i;
+	}
+	BTreeMap<int, int> copia(m);
+	map<int, int> eCopia(e);
+	for (int i = 0; i < N; ++i){
+		m.erase(i);
+		e.erase(i);
+		copia.erase(N - 1 - i);
+		eCopia.erase(N - 1 - i);
+		if (i % 5000 == 0)
+			bien = bien && igualOrdenado(m, e) && igualOrdenado(copia, eCopia);
+	}
+	comprueba(bien && m.empty() && copia.empty(), "erase in increasing and decreasing order");
+}
+
+/** Claves pares de [0, 2n) con valores al azar, en un TreeMap y en un map */
+static void llenaPares(TreeMap<int, int> &m, map<int, int> &e, int n, unsigned int semilla){
+	mt19937 gen(semilla);
+	vector<int> claves;
+	for (int i = 0; i < n; ++i)
+		claves.push_back(2 * i);
+	shuffle(claves.begin(), claves.end(), gen);
+	for (int c : claves){
+		int v = (int) (gen() % 1000);
+		m.insert(c, v);
+		e[c] = v;
+	}
+}
+
+/** Indica si el iterador de TreeMap apunta a lo mismo que el de map */
+template <typename It>
+static bool mismaPosicion(It it, It fin, map<int, int>::const_iterator e, const map<int, int> &esperado){
+	if (e == esperado.end())
+		return it == fin;
+	return it != fin && it.key() == e->first && it.value() == e->second;
+}
+
+/** TreeMap: lower_bound, upper_bound, floor, ceiling, equal_range y range. */
+void testTreeMapNavegacion(){
+	cout << "TreeMap, ordered navigation against std::map" << endl;
+	TreeMap<int, int> m;
+	map<int, int> e;
+	llenaPares(m, e, 1000, 5);
+	const TreeMap<int, int> &cm = m;
+	bool cotas = true, suelos = true, rangos = true;
+	for (int c = -3; c <= 2003; ++c){
+		cotas = cotas && mismaPosicion(cm.lower_bound(c), cm.cend(), e.lower_bound(c), e) &&
+				mismaPosicion(cm.upper_bound(c), cm.cend(), e.upper_bound(c), e) &&
+				mismaPosicion(cm.equal_range(c).first, cm.cend(), e.equal_range(c).first, e) &&
+				mismaPosicion(cm.equal_range(c).second, cm.cend(), e.equal_range(c).second, e);
+		auto mayor = e.upper_bound(c);
+		auto suelo = mayor == e.begin() ? e.end() : prev(mayor);
+		suelos = suelos && mismaPosicion(cm.floor(c), cm.cend(), suelo, e) &&
+				mismaPosicion(cm.ceiling(c), cm.cend(), e.lower_bound(c), e);
+		// range(c, c + 37): las claves de [c, c + 37)
+		auto r = cm.range(c, c + 37);
+		auto esp = e.lower_bound(c);
+		for (auto it = r.begin(); it != r.end(); ++it, ++esp)
+			rangos = rangos && esp != e.end() && esp->first < c + 37 && it.key() == esp->first;
+		rangos = rangos && (esp == e.end() || esp->first >= c + 37);
+	}
+	comprueba(cotas, "lower_bound/upper_bound/equal_range");
+	comprueba(suelos, "floor/ceiling");
+	comprueba(rangos && cm.range(10, 10).empty() && cm.range(10, 5).empty(), "range");
+	// Las versiones no constantes permiten modificar los valores
+	for (auto it = m.range(100, 200).begin(); it != m.range(100, 200).end(); ++it)
+		it.value() = -1;
+	for (auto &p : e)
+		if (p.first >= 100 && p.first < 200)
+			p.second = -1;
+	m.floor(1999).value() = -2;
+	e[1998] = -2;
+	comprueba(igualOrdenado(m, e), "changing values through range and floor");
+}
+
+/** TreeMap: select, rank y count_range, también tras borrar. */
+void testTreeMapOrden(){
+	cout << "TreeMap, select/rank/count_range against std::map" << endl;
+	TreeMap<int, int> m;
+	map<int, int> e;
+	llenaPares(m, e, 2000, 6);
+	bool bien = true;
+	for (int vuelta = 0; vuelta < 2; ++vuelta){
+		int k = 0;
+		for (auto it = e.begin(); it != e.end(); ++it, ++k)
+			bien = bien && m.select(k) != m.end() && m.select(k).key() == it->first;
+		bien = bien && m.select(-1) == m.end() && m.select(m.size()) == m.end();
+		for (int c = -1; c <= 4001; ++c){
+			int menores = (int) distance(e.begin(), e.lower_bound(c));
+			bien = bien && m.rank(c) == menores &&
+					m.count_range(c, c + 101) == (int) distance(e.lower_bound(c), e.lower_bound(c + 101));
+		}
+		bien = bien && m.count_range(50, 50) == 0 && m.count_range(60, 50) == 0;
+		// Segunda vuelta tras borrar uno de cada tres
+		for (int c = 0; c < 4000; c += 6){
+			m.erase(c);
+			e.erase(c);
+		}
+	}
+	comprueba(bien && igualOrdenado(m, e), "select/rank/count_range");
+}
+
+/** TreeMap: construcción de golpe e insert_sorted, con claves repetidas. */
+void testTreeMapMasivo(){
+	cout << "TreeMap, bulk construction and insert_sorted against std::map" << endl;
+	mt19937 gen(7);
+	vector<pair<int, int>> parejas;
+	map<int, int> e;
+	for (int i = 0; i < 20000; ++i){
+		int c = (int) (gen() % 5000);
+		parejas.push_back(make_pair(c, i));
+		e[c] = i; // como en insert, se queda el último valor
+	}
+	TreeMap<int, int> desordenado(parejas.begin(), parejas.end());
+	comprueba(igualOrdenado(desordenado, e), "bulk construction from an unsorted range with repeats");
+	vector<pair<int, int>> ordenadas(e.begin(), e.end());
+	TreeMap<int, int> ordenado(ordenadas.begin(), ordenadas.end());
+	comprueba(igualOrdenado(ordenado, e) && ordenado.select(ordenado.size() / 2).key() ==
+			next(e.begin(), e.size() / 2)->first, "bulk construction from a sorted range");
+	TreeMap<int, int> vacio(ordenadas.end(), ordenadas.end());
+	comprueba(vacio.empty() && vacio.cbegin() == vacio.cend(), "bulk construction from an empty range");
+
+	// insert_sorted con claves nuevas, repetidas y ya existentes
+	vector<pair<int, int>> bloque;
+	for (int i = 0; i < 8000; ++i){
+		int c = 2500 + (int) (gen() % 5000);
+		bloque.push_back(make_pair(c, -i));
+		e[c] = -i;
+	}
+	// stable_sort: entre claves repetidas se queda la última, como en e
+	stable_sort(bloque.begin(), bloque.end(), [](const pair<int, int> &a, const pair<int, int> &b){
+		return a.first < b.first;
+	});
+	ordenado.insert_sorted(bloque.begin(), bloque.end());
+	comprueba(igualOrdenado(ordenado, e), "insert_sorted merging with existing keys");
+	shuffle(bloque.begin(), bloque.end(), gen);
+	for (pair<int, int> &p : bloque)
+		p.second = 1;
+	desordenado.insert_sorted(bloque.begin(), bloque.end());
+	map<int, int> e2;
+	for (const pair<int, int> &p : parejas)
+		e2[p.first] = p.second;
+	for (const pair<int, int> &p : bloque)
+		e2[p.first] = p.second;
+	comprueba(igualOrdenado(desordenado, e2), "insert_sorted with an unsorted range");
+	// El árbol sigue siendo válido para las operaciones normales
+	for (int c = 0; c < 8000; c += 3){
+		ordenado.erase(c);
+		e.erase(c);
+		ordenado.insert(c + 1, c);
+		e[c + 1] = c;
+	}
+	comprueba(igualOrdenado(ordenado, e) && ordenado.rank(4000) == (int) distance(e.begin(), e.lower_bound(4000)),
+			"insert and erase after a bulk build");
+}
+
+/**
+ * Parte m (y su copia e) por cada clave de cortes y los vuelve a unir,
+ * comprobando las dos mitades.
+ */
+template <typename M>
+static bool pruebaPartir(M &m, map<int, int> &e, const vector<int> &cortes){
+	bool bien = true;
+	for (int c : cortes){
+		M mayores = m.split(c);
+		map<int, int> eMayores(e.lower_bound(c), e.end());
+		map<int, int> eMenores(e.begin(), e.lower_bound(c));
+		bien = bien && igualOrdenado(m, eMenores) && igualOrdenado(mayores, eMayores) &&
+				m.rank(c) == m.size() && mayores.rank(c) == 0;
+		// Las mitades siguen siendo árboles válidos
+		m.insert(c - 1000000, 1);
+		mayores.insert(c + 1000000, 2);
+		m.erase(c - 1000000);
+		mayores.erase(c + 1000000);
+		m.join(mayores);
+		bien = bien && mayores.empty() && igualOrdenado(m, e);
+	}
+	return bien;
+}
+
+/** TreeMap: split y join, con el asignador por defecto y con ArenaAllocator. */
+template <template <typename> class Asignador>
+static void pruebaSplitJoin(){
+	TreeMap<int, int, less<int>, Asignador> m;
+	map<int, int> e;
+	mt19937 gen(8);
+	for (int i = 0; i < 5000; ++i){
+		int c = (int) (gen() % 20000);
+		m.insert(c, i);
+		e[c] = i;
+	}
+	vector<int> cortes = {-5, 0, e.begin()->first, e.rbegin()->first, e.rbegin()->first + 1, 30000};
+	for (int i = 0; i < 30; ++i)
+		cortes.push_back((int) (gen() % 20000));
+	comprueba(pruebaPartir(m, e, cortes), "split and join back");
+
+	// join de claves que se solapan: excepción y nada cambia
+	TreeMap<int, int, less<int>, Asignador> otro;
+	otro.insert(e.rbegin()->first, 0);
+	otro.insert(e.rbegin()->first + 5, 0);
+	bool lanza = false;
+	try {
+		m.join(otro);
+	} catch (EClaveErronea &) {
+		lanza = true;
+	}
+	comprueba(lanza && otro.size() == 2 && igualOrdenado(m, e), "join with overlapping keys throws");
+	TreeMap<int, int, less<int>, Asignador> vacio;
+	vacio.join(m);
+	comprueba(m.empty() && igualOrdenado(vacio, e), "join into an empty map");
+	// Unir muchos trozos pequeños de alturas muy distintas
+	TreeMap<int, int, less<int>, Asignador> total;
+	map<int, int> eTotal;
+	for (int trozo = 0; trozo < 200; ++trozo){
+		TreeMap<int, int, less<int>, Asignador> t;
+		for (int k = 0; k < trozo % 17; ++k){
+			t.insert(trozo * 100 + k, k);
+			eTotal[trozo * 100 + k] = k;
+		}
+		total.join(t);
+	}
+	comprueba(igualOrdenado(total, eTotal) && total.select(total.size() / 2).key() ==
+			next(eTotal.begin(), eTotal.size() / 2)->first, "join many small pieces");
+}
+
+void testTreeMapSplitJoin(){
+	cout << "TreeMap, split/join against std::map" << endl;
+	pruebaSplitJoin<NewAllocator>();
+	cout << "TreeMap with ArenaAllocator, split/join against std::map" << endl;
+	pruebaSplitJoin<ArenaAllocator>();
+}
+
+/**
+ * PersistentTreeMap: se guardan versiones mientras se sigue modificando el
+ * diccionario y al final cada versión tiene que seguir igual que cuando se
+ * guardó.
+ */
+void testPersistentTreeMap(){
+	cout << "PersistentTreeMap, old versions against std::map snapshots" << endl;
+	const int OPS = 40000, RANGO = 3000;
+	PersistentTreeMap<int, int> m;
+	map<int, int> e;
+	vector<PersistentTreeMap<int, int>> versiones;
+	vector<map<int, int>> esperadas;
+	mt19937 gen(9);
+	for (int i = 0; i < OPS; ++i){
+		int c = (int) (gen() % RANGO);
+		if (gen() % 3 == 0){
+			m = m.erase(c);
+			e.erase(c);
+		} else {
+			m = m.insert(c, i);
+			e[c] = i;
+		}
+		if (i % 500 == 0){
+			versiones.push_back(m);
+			esperadas.push_back(e);
+		}
+	}
+	bool bien = igualOrdenado(m, e);
+	for (size_t v = 0; v < versiones.size(); ++v){
+		bien = bien && igualOrdenado(versiones[v], esperadas[v]);
+		for (int c = 0; c < RANGO; c += 37)
+			bien = bien && versiones[v].contains(c) == (esperadas[v].count(c) == 1) &&
+					(versiones[v].find(c) != versiones[v].cend()) == (esperadas[v].count(c) == 1);
+	}
+	comprueba(bien, "every saved version is unchanged");
+	PersistentTreeMap<int, int> antes = m;
+	PersistentTreeMap<int, int> despues = m.insert(-1, 0).erase(e.begin()->first);
+	comprueba(igualOrdenado(antes, e) && igualOrdenado(m, e) && despues.size() == m.size() &&
+			despues.contains(-1) && !despues.contains(e.begin()->first), "insert/erase leave the original alone");
+	comprueba(m.erase(RANGO + 1).size() == m.size() && m.at(e.rbegin()->first) == e.rbegin()->second,
+			"erase of a missing key");
+}
+
+/** TreeMap: find_or_insert, insert con pista y erase con iterador. */
+void testTreeMapPistas(){
+	cout << "TreeMap, find_or_insert, hinted insert and erase(Iterator)" << endl;
+	TreeMap<int, int> m;
+	map<int, int> e;
+	mt19937 gen(10);
+	bool bien = true;
+	for (int i = 0; i < 20000; ++i){
+		int c = (int) (gen() % 5000);
+		auto r = m.find_or_insert(c, i);
+		bool nueva = e.count(c) == 0;
+		if (nueva)
+			e[c] = i;
+		bien = bien && r.second == nueva && r.first.key() == c && r.first.value() == e[c];
+	}
+	comprueba(bien && igualOrdenado(m, e), "find_or_insert");
+	// Pistas correctas (la posición delante de la que va la clave) e incorrectas
+	TreeMap<int, int> h;
+	map<int, int> eh;
+	for (int i = 0; i < 5000; ++i){
+		h.insert(h.end(), 2 * i, i); // en orden: la pista end() siempre es correcta
+		eh[2 * i] = i;
+	}
+	bien = true;
+	for (int i = 0; i < 5000; ++i){
+		int c = (int) (gen() % 12000) - 1000;
+		auto pista = (i % 2 == 0) ? h.lower_bound(c) : h.select((int) (gen() % h.size()));
+		auto it = h.insert(pista, c, -i);
+		eh[c] = -i;
+		bien = bien && it.key() == c && it.value() == -i;
+	}
+	comprueba(bien && igualOrdenado(h, eh), "hinted insert with good and bad hints");
+	// Borrar las claves impares durante un recorrido
+	int vistas = 0;
+	for (auto it = h.begin(); it != h.end(); ++vistas)
+		if (it.key() % 2 != 0)
+			it = h.erase(it);
+		else
+			++it;
+	for (auto it = eh.begin(); it != eh.end(); )
+		if (it->first % 2 != 0)
+			it = eh.erase(it);
+		else
+			++it;
+	comprueba(igualOrdenado(h, eh) && vistas > h.size(), "erase(Iterator) while iterating");
+	bool lanza = false;
+	try {
+		h.erase(h.end());
+	} catch (InvalidAccessException &) {
+		lanza = true;
+	}
+	comprueba(lanza, "erase(end()) throws");
+}
+
+/** TreeMap: union_with, intersect_with, difference_with e is_subset_of. */
+void testTreeMapConjuntos(){
+	cout << "TreeMap, set operations against std::map" << endl;
+	mt19937 gen(11);
+	bool bien = true;
+	for (int vuelta = 0; vuelta < 20; ++vuelta){
+		TreeMap<int, int> a, b;
+		map<int, int> ea, eb;
+		int tamA = (int) (gen() % 300), tamB = (int) (gen() % 300);
+		for (int i = 0; i < tamA; ++i){
+			int c = (int) (gen() % 400);
+			a.insert(c, 1);
+			ea[c] = 1;
+		}
+		for (int i = 0; i < tamB; ++i){
+			int c = (int) (gen() % 400);
+			b.insert(c, 2);
+			eb[c] = 2;
+		}
+		map<int, int> eUnion(ea), eInter, eDif;
+		for (const auto &p : eb)
+			eUnion.insert(p); // las claves comunes conservan el valor de a
+		for (const auto &p : ea)
+			(eb.count(p.first) ? eInter : eDif).insert(p);
+		TreeMap<int, int> u(a), in(a), d(a);
+		u.union_with(b);
+		in.intersect_with(b);
+		d.difference_with(b);
+		bien = bien && igualOrdenado(u, eUnion) && igualOrdenado(in, eInter) && igualOrdenado(d, eDif) &&
+				in.is_subset_of(a) && in.is_subset_of(b) && a.is_subset_of(u) && b.is_subset_of(u) &&
+				d.is_subset_of(a) && (d.empty() || !d.is_subset_of(b)) &&
+				a.is_subset_of(b) == includes(eb.begin(), eb.end(), ea.begin(), ea.end(),
+						[](const pair<const int, int> &x, const pair<const int, int> &y){ return x.first < y.first; });
+		// Los resultados siguen siendo árboles válidos
+		u.insert(1000, 0);
+		in.erase(in.empty() ? 0 : in.cbegin().key());
+		bien = bien && u.rank(1000) == u.size() - 1 && in.size() == max(0, (int) eInter.size() - 1);
+	}
+	comprueba(bien, "union_with/intersect_with/difference_with/is_subset_of");
+}
+
+/**
+ * FlatMap y FlatSet contra map y set. La búsqueda sin saltos se prueba sola
+ * con arrays de todos los tamaños pequeños (0, 1, 2...), donde es más fácil
+ * salirse del array.
+ */
+void testFlatMap(){
+	cout << "FlatMap and FlatSet against std::map and std::set" << endl;
+	bool busquedas = true;
+	for (int n = 0; n <= 17; ++n){
+		vector<int> v;
+		for (int i = 0; i < n; ++i)
+			v.push_back(2 * i);
+		for (int c = -1; c <= 2 * n; ++c)
+			busquedas = busquedas && busquedaSinSaltos(v.data(), n, c, less<int>()) ==
+					(int) (lower_bound(v.begin(), v.end(), c) - v.begin());
+	}
+	comprueba(busquedas, "branchless binary search on sizes 0 to 17");
+
+	mt19937 gen(12);
+	vector<pair<int, int>> parejas;
+	map<int, int> e;
+	for (int i = 0; i < 5000; ++i){
+		int c = (int) (gen() % 2000);
+		parejas.push_back(make_pair(c, i));
+		e[c] = i;
+	}
+	FlatMap<int, int> m(parejas.begin(), parejas.end());
+	comprueba(igualOrdenado(m, e), "bulk construction with repeated keys: the last one wins");
+	vector<pair<int, int>> bloque;
+	for (int i = 0; i < 3000; ++i){
+		int c = 1000 + (int) (gen() % 2000);
+		bloque.push_back(make_pair(c, -i));
+		e[c] = -i;
+	}
+	m.insert_sorted(bloque.begin(), bloque.end());
+	comprueba(igualOrdenado(m, e), "insert_sorted merging with existing keys");
+	bool bien = true;
+	for (int i = 0; i < 3000; ++i){
+		int c = (int) (gen() % 3500);
+		if (i % 3 == 0){
+			m.erase(c);
+			e.erase(c);
+		} else {
+			m[c] += 1;
+			e[c] += 1;
+		}
+		bien = bien && m.contains(c) == (e.count(c) == 1);
+	}
+	comprueba(bien && igualOrdenado(m, e), "insert/erase/operator[]");
+	// Borrar las claves pares durante un recorrido
+	int vistas = 0, tam = m.size();
+	for (auto it = m.begin(); it != m.end(); ++vistas)
+		if (it.key() % 2 == 0)
+			it = m.erase(it);
+		else
+			++it;
+	for (auto it = e.begin(); it != e.end(); )
+		if (it->first % 2 == 0)
+			it = e.erase(it);
+		else
+			++it;
+	comprueba(igualOrdenado(m, e) && vistas == tam, "erase(Iterator) while iterating");
+
+	// Con valores bool cada valor tiene su propia dirección
+	FlatMap<int, bool> b;
+	bool &b1 = b[1];
+	b[2] = true;
+	bool &b1otra = b[1];
+	b1otra = true;
+	comprueba(&b1otra != &b[2] && b.at(1) && b.at(2) && !b.contains(3), "FlatMap<int, bool> values");
+	(void) b1;
+
+	vector<int> elems;
+	set<int> s;
+	for (int i = 0; i < 3000; ++i){
+		int c = (int) (gen() % 1000);
+		elems.push_back(c);
+		s.insert(c);
+	}
+	FlatSet<int> fs(elems.begin(), elems.end());
+	vector<int> masElems;
+	for (int i = 0; i < 1000; ++i)
+		masElems.push_back(500 + (int) (gen() % 1000));
+	fs.insert_sorted(masElems.begin(), masElems.end());
+	s.insert(masElems.begin(), masElems.end());
+	bien = fs.size() == (int) s.size() && equal(s.begin(), s.end(), fs.begin(),
+			[](int x, const int &y){ return x == y; });
+	bool cotas = true;
+	for (int c = -1; c <= 1501; ++c)
+		cotas = cotas && fs.contains(c) == (s.count(c) == 1) &&
+				(s.lower_bound(c) == s.end() ? fs.lower_bound(c) == fs.end() : fs.lower_bound(c).elem() == *s.lower_bound(c)) &&
+				(s.upper_bound(c) == s.end() ? fs.upper_bound(c) == fs.end() : fs.upper_bound(c).elem() == *s.upper_bound(c));
+	comprueba(bien && cotas, "FlatSet bulk construction, insert_sorted and bounds");
+}
+
+/**
+ * ConcurrentHashMap: varios hilos incrementan los mismos contadores con
+ * update y upsert (no se puede perder ningún incremento) e insertan y borran
+ * cada uno sus propias claves.
+ */
+void testConcurrentHashMap(){
+	const unsigned int HILOS = 4;
+	const int INCREMENTOS = 20000, CONTADORES = 16, PROPIAS = 20000;
+	cout << "ConcurrentHashMap, " << HILOS << " threads" << endl;
+	ConcurrentHashMap<int, long long> m(8);
+	for (int c = 0; c < CONTADORES; ++c)
+		m.insert(c, 0);
+	vector<thread> hilos;
+	for (unsigned int t = 0; t < HILOS; ++t)
+		hilos.emplace_back([&m, t](){
+			mt19937 gen(t + 20);
+			for (int i = 0; i < INCREMENTOS; ++i){
+				m.update((int) (gen() % CONTADORES), [](long long &v){ ++v; });
+				// Contadores que empiezan sin estar: el primero que llega los crea
+				m.upsert(-1 - (int) (gen() % CONTADORES), 1, [](long long &v){ ++v; });
+			}
+			// Claves propias: múltiplos de HILOS más t; se borran las que
+			// dan resto 0 módulo 3
+			for (int i = 0; i < PROPIAS; ++i)
+				m.insert(1000 + i * (int) HILOS + (int) t, i);
+			for (int i = 0; i < PROPIAS; i += 3)
+				m.erase(1000 + i * (int) HILOS + (int) t);
+		});
+	for (thread &h : hilos)
+		h.join();
+	long long suma = 0, sumaUpsert = 0;
+	int propias = 0;
+	bool bien = true;
+	m.for_each([&](const int &c, const long long &v){
+		if (c < 0)
+			sumaUpsert += v;
+		else if (c < CONTADORES)
+			suma += v;
+		else {
+			int i = (c - 1000) / (int) HILOS;
+			bien = bien && i % 3 != 0 && v == i;
+			++propias;
+		}
+	});
+	comprueba(suma == (long long) HILOS * INCREMENTOS, "update: no increment lost");
+	comprueba(sumaUpsert == (long long) HILOS * INCREMENTOS, "upsert: no increment lost");
+	int quedan = PROPIAS - (PROPIAS + 2) / 3;
+	comprueba(bien && propias == quedan * (int) HILOS, "insert/erase on disjoint keys");
+	comprueba(m.size() == 2 * CONTADORES + propias && !m.contains(1000) && m.contains(1000 + (int) HILOS),
+			"size and contains");
+}
+
+/** Valor que se guarda con la clave c en su versión v: "c#v" */
+static string valorDe(int c, unsigned int v){
+	return to_string(c) + "#" + to_string(v);
+}
+
+/** Indica si el valor leído de la clave c es de esa clave (de cualquier versión) */
+static bool esDeLaClave(const string &valor, int c){
+	string prefijo = to_string(c) + "#";
+	return valor.compare(0, prefijo.size(), prefijo) == 0;
+}
+
+/**
+ * Prueba aleatoria de LockFreeHashMap con escritores y lectores a la vez.
+ * Cada escritor inserta, sustituye y borra al azar las claves que le tocan
+ * (las que dan su número módulo ESCRITORES) y lleva en un map lo que debería
+ * quedar. Mientras tanto, los lectores consultan claves al azar y comprueban
+ * que cada valor que ven es de la clave que han pedido (un nodo liberado antes
+ * de tiempo o a medio construir daría basura). La tabla empieza vacía, así que
+ * también se amplía con lecturas en curso. Al final la tabla tiene que tener
+ * exactamente las parejas de los map de los escritores.
+ */
+void testLockFreeHashMap(){
+	const unsigned int ESCRITORES = 2, LECTORES = 2;
+	const unsigned int OPS = 200000, RANGO = 20000;
+	cout << "LockFreeHashMap, " << ESCRITORES << " writers and " << LECTORES << " readers" << endl;
+	LockFreeHashMap<int, string> m;
+	vector<map<int, string>> esperado(ESCRITORES);
+	atomic<bool> fin(false);
+	atomic<long long> lecturas(0), erroneas(0);
+
+	vector<thread> hilos;
+	for (unsigned int t = 0; t < LECTORES; ++t)
+		hilos.emplace_back([&, t](){
+			mt19937 gen(100 + t);
+			long long n = 0, mal = 0;
+			while (!fin.load()){
+				int c = (int) (gen() % RANGO);
+				try {
+					if (!esDeLaClave(m.at(c), c))
+						++mal;
+				} catch (EClaveErronea &) {
+					// la clave no está (o se acaba de borrar)
+				}
+				++n;
+			}
+			lecturas += n;
+			erroneas += mal;
+		});
+	vector<thread> escritores;
+	for (unsigned int t = 0; t < ESCRITORES; ++t)
+		escritores.emplace_back([&, t](){
+			mt19937 gen(t + 1);
+			map<int, string> &mio = esperado[t];
+			for (unsigned int i = 0; i < OPS; ++i){
+				int c = (int) ((gen() % (RANGO / ESCRITORES)) * ESCRITORES + t);
+				if (gen() % 3 == 0){
+					m.erase(c);
+					mio.erase(c);
+				} else {
+					string v = valorDe(c, i);
+					m.insert(c, v);
+					mio[c] = v;
+				}
+			}
+		});
+	for (thread &h : escritores)
+		h.join();
+	fin = true;
+	for (thread &h : hilos)
+		h.join();
+
+	comprueba(lecturas > 0 && erroneas == 0, "readers only saw values of the key they asked for");
+	size_t total = 0;
+	bool iguales = true;
+	for (const map<int, string> &mio : esperado){
+		total += mio.size();
+		for (const auto &p : mio)
+			iguales = iguales && m.contains(p.first) && m.at(p.first) == p.second;
+	}
+	comprueba(m.size() == (int) total, "size");
+	comprueba(iguales, "final contents");
+	int sobran = 0;
+	for (unsigned int c = 0; c < RANGO; ++c)
+		if (m.contains((int) c) && esperado[c % ESCRITORES].count((int) c) == 0)
+			++sobran;
+	comprueba(sobran == 0, "no erased key left");
+}
+
+/**
+ * HashMap: contains_batch y at_batch dan lo mismo que contains y at clave a
+ * clave, también en una tabla vacía, en una movida y durante una migración.
+ */
+void testHashMapBatch(){
+	cout << "HashMap, contains_batch/at_batch against contains/at" << endl;
+	mt19937 gen(13);
+	HashMap<int, int> m;
+	m.set_incremental_rehash(true);
+	vector<int> claves;
+	for (int i = 0; i < 3000; ++i)
+		claves.push_back((int) (gen() % 6000));
+	bool bien = true;
+	for (int i = 0; i < 3000; ++i){
+		m.insert((int) (gen() % 6000), i);
+		if (i % 250 == 0){
+			// claves es más largo que un grupo y no es múltiplo de su tamaño
+			vector<char> estan(claves.size());
+			m.contains_batch(claves.begin(), claves.end(), estan.begin());
+			vector<int> presentes, valores;
+			for (size_t k = 0; k < claves.size(); ++k){
+				bien = bien && (estan[k] != 0) == m.contains(claves[k]);
+				if (estan[k])
+					presentes.push_back(claves[k]);
+			}
+			m.at_batch(presentes.begin(), presentes.end(), back_inserter(valores));
+			for (size_t k = 0; k < presentes.size(); ++k)
+				bien = bien && valores[k] == m.at(presentes[k]);
+		}
+	}
+	comprueba(bien, "same answers as contains/at while migrating");
+	vector<int> salida;
+	bool lanza = false;
+	try {
+		vector<int> conFalta = {claves[0], claves[1], -1, claves[2]};
+		m.insert(claves[0], 10);
+		m.insert(claves[1], 11);
+		m.at_batch(conFalta.begin(), conFalta.end(), back_inserter(salida));
+	} catch (EClaveErronea &) {
+		lanza = true;
+	}
+	comprueba(lanza && salida.size() == 2 && salida[0] == 10 && salida[1] == 11,
+			"at_batch throws at a missing key after writing the previous ones");
+	HashMap<int, int> vacio;
+	vector<char> estan(claves.size(), 1);
+	vacio.contains_batch(claves.begin(), claves.end(), estan.begin());
+	bool ninguna = count(estan.begin(), estan.end(), 0) == (int) claves.size();
+	HashMap<int, int> destino(std::move(m));
+	fill(estan.begin(), estan.end(), 1);
+	m.contains_batch(claves.begin(), claves.end(), estan.begin());
+	ninguna = ninguna && count(estan.begin(), estan.end(), 0) == (int) claves.size();
+	salida.clear();
+	m.at_batch(claves.begin(), claves.begin(), back_inserter(salida));
+	comprueba(ninguna && salida.empty(), "empty and moved-from tables");
+	destino.contains_batch(claves.begin(), claves.end(), estan.begin());
+	bien = true;
+	for (size_t k = 0; k < claves.size(); ++k)
+		bien = bien && (estan[k] != 0) == destino.contains(claves[k]);
+	comprueba(bien, "the moved-to table");
+}
+
+/**
+ * DenseHashMap: el recorrido sigue el orden de inserción, salvo que al borrar
+ * la última entrada ocupa el hueco; se comprueba contra un vector al que se
+ * le hace lo mismo.
+ */
+void testDenseHashMap(){
+	cout << "DenseHashMap, insertion order, erase and growth" << endl;
+	mt19937 gen(14);
+	DenseHashMap<int, int> m;
+	vector<pair<int, int>> orden; // lo que debería dar el recorrido
+	map<int, int> e;
+	for (int i = 0; i < 5000; ++i){
+		int c = (int) (gen() % 20000);
+		if (e.count(c) == 0)
+			orden.push_back(make_pair(c, i));
+		else
+			find_if(orden.begin(), orden.end(), [c](const pair<int, int> &p){ return p.first == c; })->second = i;
+		m.insert(c, i);
+		e[c] = i;
+	}
+	auto mismoOrden = [&](){
+		if (m.size() != (int) orden.size())
+			return false;
+		size_t k = 0;
+		for (auto it = m.cbegin(); it != m.cend(); ++it, ++k)
+			if (it.key() != orden[k].first || it.value() != orden[k].second)
+				return false;
+		return true;
+	};
+	comprueba(mismoOrden() && igualSinOrden(m, e) && m.bucket_count() >= 4096,
+			"insertion order and lookups after growing");
+	// Borrar por clave: la última entrada pasa al hueco
+	for (int i = 0; i < 500; ++i){
+		int k = (int) (gen() % orden.size());
+		m.erase(orden[k].first);
+		e.erase(orden[k].first);
+		orden[k] = orden.back();
+		orden.pop_back();
+	}
+	comprueba(mismoOrden() && igualSinOrden(m, e), "erase moves the last entry into the hole");
+	// Borrar con el iterador durante un recorrido: se tienen que ver todas
+	set<int> vistas;
+	int tam = m.size();
+	for (auto it = m.begin(); it != m.end(); ){
+		vistas.insert(it.key());
+		if (it.value() % 2 == 0){
+			e.erase(it.key());
+			it = m.erase(it);
+		} else
+			++it;
+	}
+	comprueba((int) vistas.size() == tam && igualSinOrden(m, e), "erase(Iterator) while iterating visits every entry");
+	// Con reserve no cambia la tabla al insertar
+	m.reserve(20000);
+	unsigned int cubetas = m.bucket_count();
+	for (int i = 0; i < 15000; ++i){
+		m.insert(100000 + i, i);
+		e[100000 + i] = i;
+	}
+	comprueba(m.bucket_count() == cubetas && igualSinOrden(m, e), "reserve");
+	DenseHashMap<int, int> destino(std::move(m));
+	comprueba(igualSinOrden(destino, e), "move constructor");
+	comprueba(m.empty() && !m.contains(100000) && m.cbegin() == m.cend() && m.find(3) == m.end(),
+			"moved-from table is empty");
+	m.erase(3);
+	m[3] = 4;
+	m.insert(5, 6);
+	comprueba(m.size() == 2 && m.at(3) == 4 && m.at(5) == 6, "a moved-from table can be filled again");
+	DenseHashMap<int, int> copia(destino);
+	destino = std::move(m);
+	comprueba(igualSinOrden(copia, e) && destino.size() == 2, "copy and move assignment");
+}
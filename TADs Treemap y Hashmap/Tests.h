@@ -0,0 +1,23 @@
+#ifndef TESTS_H_
+#define TESTS_H_
+
+void testClosedHashMap();
+void testHashMapIncremental();
+void testHashMapReserva();
+void testHashMapMovido();
+void testHashMapTransparente();
+void testBTreeMap();
+void testTreeMapNavegacion();
+void testTreeMapOrden();
+void testTreeMapMasivo();
+void testTreeMapSplitJoin();
+void testPersistentTreeMap();
+void testTreeMapPistas();
+void testTreeMapConjuntos();
+void testFlatMap();
+void testConcurrentHashMap();
+void testLockFreeHashMap();
+void testHashMapBatch();
+void testDenseHashMap();
+
+#endif /* TESTS_H_ */